@@ -0,0 +1,255 @@
+#include "agency_table_models.h"
+
+#include "travel_agency.h"
+
+#include <algorithm>
+
+namespace {
+
+QString yesNo(bool value) {
+    return value ? QStringLiteral("Да") : QStringLiteral("Нет");
+}
+
+QString requestStatusText(RequestStatus status) {
+    switch (status) {
+    case RequestStatus::Draft:     return QStringLiteral("Черновик");
+    case RequestStatus::Completed: return QStringLiteral("Оформлена");
+    case RequestStatus::Paid:      return QStringLiteral("Оплачена");
+    case RequestStatus::Canceled:  return QStringLiteral("Отменена");
+    }
+    return QString();
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+// AgencyTableModel
+//-----------------------------------------------------------------------------
+AgencyTableModel::AgencyTableModel(const TravelAgency& agency, const QStringList& headers, QObject* parent)
+    : QAbstractTableModel(parent), agency_(agency), headers_(headers) {}
+
+int AgencyTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows_;
+}
+
+int AgencyTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(headers_.size());
+}
+
+QVariant AgencyTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rows_) return QVariant();
+    // Редактируемый QComboBox берёт текст строки по EditRole
+    if (role == Qt::DisplayRole || role == Qt::EditRole) return cell(index.row(), index.column());
+    if (role == Qt::UserRole) return sourceId(index.row());
+    return QVariant();
+}
+
+QVariant AgencyTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal && section >= 0 && section < headers_.size())
+        return headers_.at(section);
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool AgencyTableModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && pageSize_ > 0 && rows_ < sourceSize();
+}
+
+void AgencyTableModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) return;
+    const int last = std::min(sourceSize(), rows_ + pageSize_) - 1;
+    beginInsertRows(QModelIndex(), rows_, last);
+    rows_ = last + 1;
+    endInsertRows();
+}
+
+void AgencyTableModel::setPageSize(int rows) {
+    pageSize_ = std::max(0, rows);
+    reload();
+}
+
+int AgencyTableModel::idAt(int row) const {
+    return row >= 0 && row < rows_ ? sourceId(row) : 0;
+}
+
+int AgencyTableModel::sourceRowOf(int id) const {
+    if (rowIndexStale_) {
+        const int size = sourceSize();
+        rowById_.clear();
+        rowById_.reserve(size);
+        for (int row = 0; row < size; ++row) rowById_.insert(sourceId(row), row);
+        rowIndexStale_ = false;
+    }
+    return rowById_.value(id, -1);
+}
+
+int AgencyTableModel::rowOf(int id) const {
+    const int row = sourceRowOf(id);
+    return row < rows_ ? row : -1;
+}
+
+int AgencyTableModel::fetchRowOf(int id) {
+    const int row = sourceRowOf(id);
+    if (row < rows_ || pageSize_ == 0) return rowOf(id);
+    beginInsertRows(QModelIndex(), rows_, row);
+    rows_ = row + 1;
+    endInsertRows();
+    return row;
+}
+
+void AgencyTableModel::reload() {
+    beginResetModel();
+    rowIndexStale_ = true;
+    known_ = sourceSize();
+    rows_ = pageSize_ > 0 ? std::min(known_, pageSize_) : known_;
+    endResetModel();
+}
+
+void AgencyTableModel::rowsAppended() {
+    const int size = sourceSize();
+    // Не все строки подгружены — новые придут с очередной подгрузкой
+    const bool complete = pageSize_ == 0 || rows_ == known_;
+    if (!rowIndexStale_) {
+        for (int row = known_; row < size; ++row) rowById_.insert(sourceId(row), row);
+    }
+    known_ = size;
+    if (!complete || size <= rows_) return;
+    beginInsertRows(QModelIndex(), rows_, size - 1);
+    rows_ = size;
+    endInsertRows();
+}
+
+void AgencyTableModel::rowRemoved(int row) {
+    // Строки после удалённой сдвинулись: индекс перестроится при следующем поиске
+    rowIndexStale_ = true;
+    if (row < 0 || row >= rows_) {
+        known_ = sourceSize();
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    dropRow(row);
+    --rows_;
+    known_ = sourceSize();
+    endRemoveRows();
+}
+
+void AgencyTableModel::rowChanged(int id) {
+    const int row = rowOf(id);
+    if (row < 0) return;
+    emit dataChanged(index(row, 0), index(row, columnCount() - 1), {Qt::DisplayRole});
+}
+
+void AgencyTableModel::allChanged() {
+    if (rows_ == 0) return;
+    emit dataChanged(index(0, 0), index(rows_ - 1, columnCount() - 1), {Qt::DisplayRole});
+}
+
+//-----------------------------------------------------------------------------
+// ClientTableModel
+//-----------------------------------------------------------------------------
+ClientTableModel::ClientTableModel(const TravelAgency& agency, QObject* parent)
+    : AgencyTableModel(agency, {"ID", "ФИО", "Телефон", "Email", "Дата рождения", "Комментарии"}, parent) {
+    reload();
+}
+
+void ClientTableModel::setFilter(const std::vector<Client*>& list) {
+    filtered_ = true;
+    filter_ = list;
+    reload();
+}
+
+void ClientTableModel::clearFilter() {
+    if (!filtered_) return;
+    filtered_ = false;
+    filter_.clear();
+    reload();
+}
+
+int ClientTableModel::sourceSize() const {
+    return static_cast<int>(filtered_ ? filter_.size() : agency_.clients().size());
+}
+
+const Client* ClientTableModel::clientAt(int row) const {
+    return filtered_ ? filter_[row] : agency_.clients()[row];
+}
+
+int ClientTableModel::sourceId(int row) const {
+    return clientAt(row)->getId();
+}
+
+QString ClientTableModel::cell(int row, int column) const {
+    const Client* c = clientAt(row);
+    switch (column) {
+    case 0: return QString::number(c->getId());
+    case 1: return c->getFullName();
+    case 2: return c->getPhone();
+    case 3: return c->getEmail();
+    case 4: return c->getDateOfBirth().toString(Qt::ISODate);
+    case 5: return c->getComments();
+    }
+    return QString();
+}
+
+void ClientTableModel::dropRow(int row) {
+    if (filtered_) filter_.erase(filter_.begin() + row);
+}
+
+//-----------------------------------------------------------------------------
+// TourTableModel
+//-----------------------------------------------------------------------------
+TourTableModel::TourTableModel(const TravelAgency& agency, QObject* parent)
+    : AgencyTableModel(agency, {"ID", "Название", "Страна", "Тип", "Начало", "Дней", "Цена", "Внутр.", "Виза"},
+                       parent) {
+    reload();
+}
+
+int TourTableModel::sourceSize() const {
+    return static_cast<int>(agency_.tours().size());
+}
+
+int TourTableModel::sourceId(int row) const {
+    return agency_.tours()[row]->getId();
+}
+
+QString TourTableModel::cell(int row, int column) const {
+    const Tour* t = agency_.tours()[row];
+    switch (column) {
+    case 0: return QString::number(t->getId());
+    case 1: return t->getName();
+    case 2: return t->getCountry();
+    case 3: return t->getTourType();
+    case 4: return t->getStartDate().toString(Qt::ISODate);
+    case 5: return QString::number(t->getDurationDays());
+    case 6: return QString::number(t->getBasePrice(), 'f', 2);
+    case 7: return yesNo(t->isDomestic());
+    case 8: return yesNo(t->isVisaRequired());
+    }
+    return QString();
+}
+
+//-----------------------------------------------------------------------------
+// RequestTableModel
+//-----------------------------------------------------------------------------
+RequestTableModel::RequestTableModel(const TravelAgency& agency, QObject* parent)
+    : AgencyTableModel(agency, {"ID", "Клиент", "Тур", "Статус", "Стоимость"}, parent) {
+    reload();
+}
+
+int RequestTableModel::sourceSize() const {
+    return static_cast<int>(agency_.requests().size());
+}
+
+int RequestTableModel::sourceId(int row) const {
+    return agency_.requests()[row]->getId();
+}
+
+QString RequestTableModel::cell(int row, int column) const {
+    const TourRequest* r = agency_.requests()[row];
+    switch (column) {
+    case 0: return QString::number(r->getId());
+    case 1: return r->getClient()->getFullName();
+    case 2: return r->getTour()->getName();
+    case 3: return requestStatusText(r->getStatus());
+    case 4: return QString::number(r->calculateTotalCost(), 'f', 2);
+    }
+    return QString();
+}
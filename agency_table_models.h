@@ -0,0 +1,134 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QStringList>
+
+#include <vector>
+
+class Client;
+class TravelAgency;
+
+//=============================================================================
+// AgencyTableModel — таблица над вектором TravelAgency
+//=============================================================================
+
+/**
+ * Строки — элементы вектора агентства в его порядке; текст ячеек формируется
+ * в data(), то есть только для видимых строк. После изменения данных окно
+ * сообщает модели, что именно изменилось (rowsAppended, rowRemoved, rowChanged),
+ * и представление перерисовывает только эти строки; reload — полная перестройка.
+ * Число строк хранится в модели и меняется между begin*Rows и end*Rows.
+ * Qt::UserRole — id элемента (QComboBox::currentData). При заданном размере
+ * страницы строки отдаются представлению частями через canFetchMore/fetchMore.
+ */
+class AgencyTableModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    /** Строк в одной подгрузке (выпадающие списки); 0 — все строки сразу */
+    void setPageSize(int rows);
+    /** id элемента в строке; 0 — строки нет */
+    int idAt(int row) const;
+    /** Строка элемента с id; -1 — не показан. Поиск по индексу id → строка */
+    int rowOf(int id) const;
+    /** Как rowOf, но ещё не подгруженные строки до элемента подгружаются */
+    int fetchRowOf(int id);
+
+    /** Полная перестройка (загрузка файла, смена отбора) */
+    void reload();
+    /**
+     * В конец вектора агентства добавлены элементы. При постраничной подгрузке
+     * они показываются сразу, только если прежние строки уже показаны все.
+     */
+    void rowsAppended();
+    /** Элемент строки row удалён из агентства (row — из rowOf до удаления) */
+    void rowRemoved(int row);
+    /** Изменились поля элемента с id */
+    void rowChanged(int id);
+    /** Изменились ячейки всех строк (например, имя клиента во всех его заявках) */
+    void allChanged();
+
+protected:
+    AgencyTableModel(const TravelAgency& agency, const QStringList& headers, QObject* parent);
+
+    const TravelAgency& agency_;
+
+    virtual int sourceSize() const = 0;
+    virtual int sourceId(int row) const = 0;
+    virtual QString cell(int row, int column) const = 0;
+    /** Вызывается внутри begin/endRemoveRows: модель со своим списком строк убирает строку */
+    virtual void dropRow(int row) { Q_UNUSED(row); }
+
+private:
+    QStringList headers_;
+    int rows_ = 0;
+    int pageSize_ = 0;
+    int known_ = 0;  // размер источника при последнем сообщении об изменении
+    // id → строка источника (и ещё не подгруженные строки); перестраивается
+    // при первом поиске после reload или удаления, дополняется при добавлении
+    mutable QHash<int, int> rowById_;
+    mutable bool rowIndexStale_ = true;
+
+    int sourceRowOf(int id) const;
+};
+
+//=============================================================================
+// ClientTableModel — клиенты агентства или результат поиска
+//=============================================================================
+
+class ClientTableModel : public AgencyTableModel {
+    Q_OBJECT
+public:
+    explicit ClientTableModel(const TravelAgency& agency, QObject* parent = nullptr);
+
+    /** Показать только list (результат поиска) */
+    void setFilter(const std::vector<Client*>& list);
+    /** Снова показать всех клиентов; без отбора ничего не делает */
+    void clearFilter();
+    bool isFiltered() const { return filtered_; }
+
+protected:
+    int sourceSize() const override;
+    int sourceId(int row) const override;
+    QString cell(int row, int column) const override;
+    void dropRow(int row) override;
+
+private:
+    bool filtered_ = false;
+    std::vector<Client*> filter_;
+
+    const Client* clientAt(int row) const;
+};
+
+//=============================================================================
+// TourTableModel, RequestTableModel — туры и заявки агентства
+//=============================================================================
+
+class TourTableModel : public AgencyTableModel {
+    Q_OBJECT
+public:
+    explicit TourTableModel(const TravelAgency& agency, QObject* parent = nullptr);
+
+protected:
+    int sourceSize() const override;
+    int sourceId(int row) const override;
+    QString cell(int row, int column) const override;
+};
+
+class RequestTableModel : public AgencyTableModel {
+    Q_OBJECT
+public:
+    explicit RequestTableModel(const TravelAgency& agency, QObject* parent = nullptr);
+
+protected:
+    int sourceSize() const override;
+    int sourceId(int row) const override;
+    QString cell(int row, int column) const override;
+};
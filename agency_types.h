@@ -16,6 +16,8 @@ enum class DocumentType {
     ConsentForChildDeparture,
     VeterinaryPassport
 };
+/** Число типов документов (для таблиц, индексируемых типом) */
+constexpr int DOCUMENT_TYPE_COUNT = static_cast<int>(DocumentType::VeterinaryPassport) + 1;
 
 /** Статус документа: отсутствует / имеется / проверен */
 enum class DocumentStatus {
@@ -31,3 +33,4 @@ enum class RequestStatus {
     Paid,        // Оплачена
     Canceled     // Отменена
 };
+constexpr int REQUEST_STATUS_COUNT = static_cast<int>(RequestStatus::Canceled) + 1;
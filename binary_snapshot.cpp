@@ -0,0 +1,510 @@
+#include "binary_snapshot.h"
+
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QVariant>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "travel_agency.h"
+
+namespace {
+
+const char MAGIC[8] = {'T', 'A', 'G', 'S', 'N', 'A', 'P', '\0'};
+
+enum SectionId : quint32 {
+    SectionStrings = 1,
+    SectionClients = 2,
+    SectionTours = 3,
+    SectionRequests = 4
+};
+
+// Тип значения поля документа
+enum ValueTag : quint8 {
+    TagString = 0,
+    TagDouble = 1,
+    TagBool = 2,
+    TagNull = 3
+};
+
+// Как хранятся туристы, животные и документы заявки (с версии 2)
+enum DetailsKind : quint8 {
+    DetailsInline = 0,   // разобранными полями
+    DetailsJson = 1      // неразобранной JSON-записью (ленивая загрузка)
+};
+
+const int HEADER_SIZE = 8 + 4 + 4;
+const int SECTION_ENTRY_SIZE = 4 + 8 + 8;
+
+/** Словарь повторяющихся строк: строка → индекс */
+class StringDictionary {
+public:
+    quint32 intern(const QString& s) {
+        auto it = index_.constFind(s);
+        if (it != index_.constEnd()) return it.value();
+        const quint32 i = static_cast<quint32>(values_.size());
+        index_.insert(s, i);
+        values_.push_back(s);
+        return i;
+    }
+    const std::vector<QString>& values() const { return values_; }
+private:
+    QHash<QString, quint32> index_;
+    std::vector<QString> values_;
+};
+
+class Writer {
+public:
+    explicit Writer(StringDictionary* dict = nullptr) : dict_(dict) {}
+    QByteArray& buffer() { return buf_; }
+
+    void u8(quint8 v) { buf_.append(static_cast<char>(v)); }
+    void u32(quint32 v) { raw(qToLittleEndian(v)); }
+    void i32(qint32 v) { raw(qToLittleEndian(v)); }
+    void u64(quint64 v) { raw(qToLittleEndian(v)); }
+    void i64(qint64 v) { raw(qToLittleEndian(v)); }
+    void f64(double v) {
+        quint64 bits;
+        std::memcpy(&bits, &v, sizeof bits);
+        u64(bits);
+    }
+    void date(const QDate& d) { i64(d.toJulianDay()); }
+    void str(const QString& s) {
+        const QByteArray utf8 = s.toUtf8();
+        u32(static_cast<quint32>(utf8.size()));
+        buf_.append(utf8);
+    }
+    void sym(const QString& s) { u32(dict_->intern(s)); }
+    void bytes(const QByteArray& b) {
+        u32(static_cast<quint32>(b.size()));
+        buf_.append(b);
+    }
+
+private:
+    template <typename T>
+    void raw(T v) { buf_.append(reinterpret_cast<const char*>(&v), sizeof v); }
+
+    QByteArray buf_;
+    StringDictionary* dict_;
+};
+
+/** Чтение из отображённой памяти; при выходе за границы ok становится false */
+class Reader {
+public:
+    Reader(const uchar* begin, const uchar* end, const std::vector<QString>* dict = nullptr)
+        : p_(begin), end_(end), dict_(dict) {}
+    bool ok() const { return ok_; }
+    /** Отметить данные как повреждённые (значение вне допустимого диапазона) */
+    void fail() { ok_ = false; }
+
+    quint8 u8() { return need(1) ? *p_++ : 0; }
+    quint32 u32() { return fixed<quint32>(); }
+    qint32 i32() { return fixed<qint32>(); }
+    quint64 u64() { return fixed<quint64>(); }
+    qint64 i64() { return fixed<qint64>(); }
+    double f64() {
+        const quint64 bits = u64();
+        double v;
+        std::memcpy(&v, &bits, sizeof v);
+        return v;
+    }
+    QDate date() { return QDate::fromJulianDay(i64()); }
+    QString str() {
+        const quint32 n = u32();
+        if (!need(n)) return QString();
+        const QString s = QString::fromUtf8(reinterpret_cast<const char*>(p_), static_cast<int>(n));
+        p_ += n;
+        return s;
+    }
+    /** Копия байтов: отображение файла снимается после загрузки */
+    QByteArray bytes() {
+        const quint32 n = u32();
+        if (!need(n)) return QByteArray();
+        const QByteArray b(reinterpret_cast<const char*>(p_), static_cast<int>(n));
+        p_ += n;
+        return b;
+    }
+    QString sym() {
+        const quint32 i = u32();
+        if (!ok_ || !dict_ || i >= dict_->size()) { ok_ = false; return QString(); }
+        return (*dict_)[i];   // неявное разделение данных: без копирования символов
+    }
+
+private:
+    bool need(quint64 n) {
+        if (ok_ && static_cast<quint64>(end_ - p_) >= n) return true;
+        ok_ = false;
+        return false;
+    }
+    template <typename T>
+    T fixed() {
+        if (!need(sizeof(T))) return 0;
+        const T v = qFromLittleEndian<T>(p_);
+        p_ += sizeof(T);
+        return v;
+    }
+
+    const uchar* p_;
+    const uchar* end_;
+    const std::vector<QString>* dict_;
+    bool ok_ = true;
+};
+
+void writeAddress(Writer& w, const Address& a) {
+    w.sym(a.region);
+    w.sym(a.city);
+    w.str(a.street);
+    w.str(a.house);
+    w.str(a.building);
+    w.str(a.apartment);
+    w.str(a.postalCode);
+    w.str(a.additional);
+}
+
+Address readAddress(Reader& r) {
+    Address a;
+    a.region = r.sym();
+    a.city = r.sym();
+    a.street = r.str();
+    a.house = r.str();
+    a.building = r.str();
+    a.apartment = r.str();
+    a.postalCode = r.str();
+    a.additional = r.str();
+    return a;
+}
+
+void writeDocument(Writer& w, const Document& d) {
+    w.u8(static_cast<quint8>(d.getType()));
+    w.u8(static_cast<quint8>(d.getStatus()));
+    const QVariantMap fields = d.fields();
+    w.u32(static_cast<quint32>(fields.size()));
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        w.sym(it.key());
+        const QVariant& v = it.value();
+        if (v.isNull()) {
+            w.u8(TagNull);
+        } else if (v.userType() == QMetaType::Bool) {
+            w.u8(TagBool);
+            w.u8(v.toBool() ? 1 : 0);
+        } else if (v.userType() == QMetaType::Double || v.userType() == QMetaType::Int
+                   || v.userType() == QMetaType::LongLong) {
+            w.u8(TagDouble);
+            w.f64(v.toDouble());
+        } else {
+            w.u8(TagString);
+            w.str(v.toString());
+        }
+    }
+}
+
+/** Документ из потока; nullptr и ошибка читателя при неизвестном типе или статусе */
+std::unique_ptr<Document> readDocument(Reader& r) {
+    const quint8 type = r.u8();
+    const quint8 status = r.u8();
+    if (!r.ok() || type >= DOCUMENT_TYPE_COUNT
+        || status > static_cast<quint8>(DocumentStatus::Verified)) {
+        r.fail();
+        return nullptr;
+    }
+    auto doc = std::make_unique<Document>(static_cast<DocumentType>(type),
+                                          static_cast<DocumentStatus>(status));
+    QVariantMap fields;
+    const quint32 n = r.u32();
+    for (quint32 i = 0; i < n && r.ok(); ++i) {
+        const QString key = r.sym();
+        switch (r.u8()) {
+        case TagString: fields.insert(key, r.str()); break;
+        case TagDouble: fields.insert(key, r.f64()); break;
+        case TagBool: fields.insert(key, r.u8() != 0); break;
+        default: fields.insert(key, QVariant()); break;
+        }
+    }
+    doc->setFields(fields);
+    return doc;
+}
+
+} // namespace
+
+bool BinarySnapshot::save(const TravelAgency& agency, const QString& path, QString* err) {
+    StringDictionary dict;
+    Writer clients(&dict), tours(&dict), requests(&dict);
+
+    clients.u32(static_cast<quint32>(agency.clients().size()));
+    for (const Client* c : agency.clients()) {
+        clients.i32(c->getId());
+        clients.str(c->getLastName());
+        clients.str(c->getFirstName());
+        clients.str(c->getMiddleName());
+        clients.str(c->getPhone());
+        clients.str(c->getEmail());
+        clients.date(c->getDateOfBirth());
+        clients.str(c->getComments());
+        writeAddress(clients, c->getRegistrationAddress());
+        writeAddress(clients, c->getActualAddress());
+    }
+
+    tours.u32(static_cast<quint32>(agency.tours().size()));
+    for (const Tour* t : agency.tours()) {
+        tours.i32(t->getId());
+        tours.str(t->getName());
+        tours.sym(t->getCountry());
+        tours.sym(t->getTourType());
+        tours.date(t->getStartDate());
+        tours.i32(t->getDurationDays());
+        tours.f64(t->getBasePrice());
+        tours.u8((t->isDomestic() ? 1 : 0) | (t->isVisaRequired() ? 2 : 0));
+        const QStringList modes = t->getTravelModes();
+        tours.u32(static_cast<quint32>(modes.size()));
+        for (const QString& mode : modes) tours.sym(mode);
+    }
+
+    requests.u32(static_cast<quint32>(agency.requests().size()));
+    for (const TourRequest* r : agency.requests()) {
+        requests.i32(r->getId());
+        requests.i32(r->getClient()->getId());
+        requests.i32(r->getTour()->getId());
+        requests.u8(static_cast<quint8>(r->getStatus()));
+        requests.sym(r->getTravelMode());
+        requests.sym(r->getTravelClass());
+
+        // Неразобранные подробности пишутся как есть, без создания объектов
+        if (r->hasPendingDetails()) {
+            const TourRequest::DetailsSummary& summary = r->totals();
+            requests.u8(DetailsJson);
+            requests.i32(summary.adults);
+            requests.i32(summary.children);
+            requests.f64(summary.animalSurcharge);
+            requests.bytes(r->pendingDetails());
+            continue;
+        }
+        requests.u8(DetailsInline);
+
+        requests.u32(static_cast<quint32>(r->getTourists().size()));
+        for (const auto& t : r->getTourists()) {
+            requests.u8((t->isChild() ? 1 : 0) | (t->hasBenefit() ? 2 : 0));
+            requests.str(t->getLastName());
+            requests.str(t->getFirstName());
+            requests.str(t->getMiddleName());
+            requests.date(t->isChild() ? static_cast<const ChildTourist*>(t.get())->getDateOfBirth() : QDate());
+            requests.u32(static_cast<quint32>(t->documents().size()));
+            for (const auto& doc : t->documents()) writeDocument(requests, *doc);
+        }
+
+        requests.u32(static_cast<quint32>(r->getAnimals().size()));
+        for (const auto& a : r->getAnimals()) {
+            requests.sym(a->getType());
+            requests.f64(a->getWeight());
+            requests.sym(a->getTransport());
+        }
+
+        requests.u32(static_cast<quint32>(r->getDocuments().size()));
+        for (const auto& doc : r->getDocuments()) writeDocument(requests, *doc);
+    }
+
+    // Словарь заполнен только после записи всех остальных секций
+    Writer strings;
+    strings.u32(static_cast<quint32>(dict.values().size()));
+    for (const QString& s : dict.values()) strings.str(s);
+
+    const std::pair<SectionId, QByteArray*> sections[] = {
+        {SectionStrings, &strings.buffer()},
+        {SectionClients, &clients.buffer()},
+        {SectionTours, &tours.buffer()},
+        {SectionRequests, &requests.buffer()}
+    };
+    const int sectionCount = static_cast<int>(sizeof sections / sizeof sections[0]);
+
+    Writer header;
+    header.buffer().append(MAGIC, sizeof MAGIC);
+    header.u32(VERSION);
+    header.u32(static_cast<quint32>(sectionCount));
+    quint64 offset = HEADER_SIZE + quint64(sectionCount) * SECTION_ENTRY_SIZE;
+    for (const auto& section : sections) {
+        header.u32(section.first);
+        header.u64(offset);
+        header.u64(static_cast<quint64>(section.second->size()));
+        offset += static_cast<quint64>(section.second->size());
+    }
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err) *err = "Не удалось открыть файл для записи";
+        return false;
+    }
+    f.write(header.buffer());
+    for (const auto& section : sections) f.write(*section.second);
+    if (!f.commit()) {
+        if (err) *err = "Не удалось записать файл снимка";
+        return false;
+    }
+    return true;
+}
+
+bool BinarySnapshot::load(TravelAgency& agency, const QString& path, QString* err) {
+    auto fail = [err](const QString& message) {
+        if (err) *err = message;
+        return false;
+    };
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return fail("Не удалось открыть файл");
+    const qint64 size = f.size();
+    if (size < HEADER_SIZE) return fail("Файл не является снимком данных");
+    const uchar* base = f.map(0, size);
+    if (!base) return fail("Не удалось отобразить файл в память");
+    const uchar* end = base + size;
+
+    Reader header(base, end);
+    if (std::memcmp(base, MAGIC, sizeof MAGIC) != 0) return fail("Файл не является снимком данных");
+    header.u64();
+    const quint32 version = header.u32();
+    if (version < 1 || version > VERSION) return fail(QString("Неподдерживаемая версия снимка: %1").arg(version));
+
+    std::unordered_map<quint32, std::pair<quint64, quint64>> table;
+    const quint32 sectionCount = header.u32();
+    for (quint32 i = 0; i < sectionCount && header.ok(); ++i) {
+        const quint32 id = header.u32();
+        const quint64 offset = header.u64();
+        const quint64 length = header.u64();
+        if (offset > quint64(size) || length > quint64(size) - offset) return fail("Повреждена таблица секций");
+        table[id] = {offset, length};
+    }
+    if (!header.ok()) return fail("Повреждён заголовок снимка");
+    for (quint32 id : {SectionStrings, SectionClients, SectionTours, SectionRequests})
+        if (!table.count(id)) return fail("В снимке нет обязательной секции");
+
+    auto section = [&](quint32 id, const std::vector<QString>* dict) {
+        const auto& entry = table.at(id);
+        return Reader(base + entry.first, base + entry.first + entry.second, dict);
+    };
+
+    std::vector<QString> dict;
+    Reader strings = section(SectionStrings, nullptr);
+    const quint32 stringCount = strings.u32();
+    dict.reserve(std::min<quint64>(stringCount, quint64(size)));
+    for (quint32 i = 0; i < stringCount && strings.ok(); ++i) dict.push_back(strings.str());
+    if (!strings.ok()) return fail("Повреждён словарь строк");
+
+    agency.clearAll();
+    try {
+        Reader clients = section(SectionClients, &dict);
+        const quint32 clientCount = clients.u32();
+        for (quint32 i = 0; i < clientCount && clients.ok(); ++i) {
+            const qint32 id = clients.i32();
+            const QString last = clients.str();
+            const QString first = clients.str();
+            const QString middle = clients.str();
+            const QString phone = clients.str();
+            const QString email = clients.str();
+            const QDate dob = clients.date();
+            const QString comments = clients.str();
+            const Address reg = readAddress(clients);
+            const Address actual = readAddress(clients);
+            if (!clients.ok()) break;
+            agency.registerClient(new Client(last, first, middle, phone, email, dob, reg, actual, comments, id));
+        }
+        if (!clients.ok()) return fail("Повреждена секция клиентов");
+
+        Reader tours = section(SectionTours, &dict);
+        const quint32 tourCount = tours.u32();
+        for (quint32 i = 0; i < tourCount && tours.ok(); ++i) {
+            const qint32 id = tours.i32();
+            const QString name = tours.str();
+            const QString country = tours.sym();
+            const QString tourType = tours.sym();
+            const QDate start = tours.date();
+            const qint32 duration = tours.i32();
+            const double price = tours.f64();
+            const quint8 flags = tours.u8();
+            QStringList modes;
+            const quint32 modeCount = tours.u32();
+            for (quint32 m = 0; m < modeCount && tours.ok(); ++m) modes.append(tours.sym());
+            if (!tours.ok()) break;
+            agency.registerTour(new Tour(name, country, tourType, start, duration, price,
+                                         flags & 1, flags & 2, modes, id));
+        }
+        if (!tours.ok()) return fail("Повреждена секция туров");
+
+        Reader requests = section(SectionRequests, &dict);
+        const quint32 requestCount = requests.u32();
+        for (quint32 i = 0; i < requestCount && requests.ok(); ++i) {
+            const qint32 id = requests.i32();
+            Client* c = agency.findClientById(requests.i32());
+            Tour* t = agency.findTourById(requests.i32());
+            if (!c || !t) return fail("Заявка ссылается на отсутствующего клиента или тур");
+            auto r = std::make_unique<TourRequest>(c, t, id);
+            r->setStatus(static_cast<RequestStatus>(requests.u8()));
+            r->setTravelMode(requests.sym());
+            r->setTravelClass(requests.sym());
+
+            const quint8 details = version >= 2 ? requests.u8() : quint8(DetailsInline);
+            if (details == DetailsJson) {
+                TourRequest::DetailsSummary summary;
+                summary.adults = requests.i32();
+                summary.children = requests.i32();
+                summary.animalSurcharge = requests.f64();
+                const QByteArray payload = requests.bytes();
+                if (!requests.ok()) break;
+                r->setPendingDetails(payload, summary);
+                agency.registerRequest(r.release());
+                continue;
+            }
+
+            const quint32 touristCount = requests.u32();
+            for (quint32 k = 0; k < touristCount && requests.ok(); ++k) {
+                const quint8 flags = requests.u8();
+                const QString last = requests.str();
+                const QString first = requests.str();
+                const QString middle = requests.str();
+                const QDate dob = requests.date();
+                if (!requests.ok()) break;
+                if (flags & 1) r->addChild(last, first, middle, dob);
+                else r->addAdult(last, first, middle);
+                Tourist* tourist = r->tourist(static_cast<int>(r->getTourists().size()) - 1);
+                tourist->setHasBenefit(flags & 2);
+                tourist->clearDocuments();
+                const quint32 docCount = requests.u32();
+                for (quint32 d = 0; d < docCount && requests.ok(); ++d) {
+                    auto doc = readDocument(requests);
+                    if (doc) tourist->documents().push_back(std::move(doc));
+                }
+            }
+
+            const quint32 animalCount = requests.u32();
+            for (quint32 k = 0; k < animalCount && requests.ok(); ++k) {
+                const QString type = requests.sym();
+                const double weight = requests.f64();
+                const QString transport = requests.sym();
+                if (requests.ok()) r->addAnimal(type, weight, transport);
+            }
+
+            // Документы заявки — как в JSON-загрузке: по типу поверх сгенерированных
+            r->regenerateDocuments();
+            const quint32 docCount = requests.u32();
+            for (quint32 d = 0; d < docCount && requests.ok(); ++d) {
+                auto doc = readDocument(requests);
+                if (requests.ok()) r->restoreDocument(std::move(doc));
+            }
+            if (!requests.ok()) break;
+            agency.registerRequest(r.release());
+        }
+        if (!requests.ok()) return fail("Повреждена секция заявок");
+    } catch (const std::exception& e) {
+        return fail(QString("Некорректные данные: %1").arg(e.what()));
+    }
+    return true;
+}
+
+bool BinarySnapshot::isSnapshotFile(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    return f.read(sizeof MAGIC) == QByteArray(MAGIC, sizeof MAGIC);
+}
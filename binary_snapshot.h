@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QString>
+
+class TravelAgency;
+
+//=============================================================================
+// BinarySnapshot — двоичный снимок данных агентства
+//=============================================================================
+
+/**
+ * Формат (little-endian), версия 2:
+ *   заголовок: "TAGSNAP\0", версия (u32), число секций (u32);
+ *   таблица секций: id (u32), смещение (u64), размер (u64);
+ *   секции: словарь строк, клиенты, туры, заявки.
+ * Строки хранятся как длина (u32) + UTF-8. Повторяющиеся значения (страны,
+ * типы туров, способы поездки, ключи полей документов, регионы и города)
+ * записываются один раз в словарь и дальше идут индексом.
+ * Версия 2 добавляет признак у заявки: подробности разобраны или хранятся
+ * неразобранной JSON-записью (ленивая загрузка). Файлы версии 1 читаются.
+ * Загрузка читает файл через отображение в память (QFile::map).
+ * JSON остаётся форматом обмена; снимок — быстрый формат для своих файлов.
+ */
+class BinarySnapshot {
+public:
+    static constexpr quint32 VERSION = 2;
+
+    static bool save(const TravelAgency& agency, const QString& path, QString* err = nullptr);
+    static bool load(TravelAgency& agency, const QString& path, QString* err = nullptr);
+    /** Файл начинается с сигнатуры снимка */
+    static bool isSnapshotFile(const QString& path);
+};
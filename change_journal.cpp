@@ -0,0 +1,100 @@
+#include "change_journal.h"
+
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+bool ChangeJournal::replay(const QString& path, const Apply& apply, int* records, QString* err) {
+    if (records) *records = 0;
+    QFile f(path);
+    if (!f.exists()) return true;
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (err) *err = "Не удалось открыть журнал изменений";
+        return false;
+    }
+
+    int count = 0;
+    qint64 validSize = 0;
+    int lineNo = 0;
+    while (!f.atEnd()) {
+        const QByteArray line = f.readLine();
+        ++lineNo;
+        // Без перевода строки может быть только последняя, недописанная запись
+        if (!line.endsWith('\n')) break;
+        const QByteArray body = line.trimmed();
+        if (!body.isEmpty()) {
+            QJsonParseError perr;
+            const QJsonDocument doc = QJsonDocument::fromJson(body, &perr);
+            if (!doc.isObject()) {
+                if (err) *err = QString("Журнал изменений, строка %1: %2")
+                                    .arg(lineNo)
+                                    .arg(doc.isNull() ? perr.errorString() : QString("ожидался объект"));
+                return false;
+            }
+            QString applyErr;
+            if (!apply(doc.object(), &applyErr)) {
+                if (err) *err = QString("Журнал изменений, строка %1: %2").arg(lineNo).arg(applyErr);
+                return false;
+            }
+            ++count;
+        }
+        validSize += line.size();
+    }
+
+    const bool torn = validSize < f.size();
+    f.close();
+    if (torn && !QFile::resize(path, validSize)) {
+        if (err) *err = "Не удалось обрезать повреждённый конец журнала";
+        return false;
+    }
+    if (records) *records = count;
+    return true;
+}
+
+bool ChangeJournal::open(const QString& path, int records, QString* err) {
+    close();
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        if (err) *err = "Не удалось открыть журнал изменений для записи";
+        return false;
+    }
+    records_ = records;
+    return true;
+}
+
+void ChangeJournal::close() {
+    if (file_.isOpen()) file_.close();
+    records_ = 0;
+}
+
+bool ChangeJournal::append(const QJsonObject& record, QString* err) {
+    return append(QJsonDocument(record).toJson(QJsonDocument::Compact), err);
+}
+
+bool ChangeJournal::append(const QByteArray& record, QString* err) {
+    if (!file_.isOpen()) {
+        if (err) *err = "Журнал изменений не открыт";
+        return false;
+    }
+    QByteArray line = record;
+    line.append('\n');
+    // Запись целиком и сразу в ОС: после сбоя приложения строка не потеряется
+    if (file_.write(line) != line.size() || !file_.flush()) {
+        if (err) *err = "Ошибка записи в журнал изменений";
+        return false;
+    }
+    ++records_;
+    return true;
+}
+
+bool ChangeJournal::clear(QString* err) {
+    if (!file_.isOpen()) {
+        if (err) *err = "Журнал изменений не открыт";
+        return false;
+    }
+    if (!file_.resize(0)) {
+        if (err) *err = "Не удалось очистить журнал изменений";
+        return false;
+    }
+    records_ = 0;
+    return true;
+}
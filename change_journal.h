@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+
+#include <functional>
+
+//=============================================================================
+// ChangeJournal — журнал изменений (дозапись в конец файла)
+//=============================================================================
+
+/**
+ * Одна запись — одна строка компактного JSON. Записи только дописываются,
+ * поэтому стоимость сохранения пропорциональна изменению, а не объёму данных.
+ * Строка, оборванная сбоем во время записи, при чтении отбрасывается.
+ */
+class ChangeJournal {
+public:
+    /** Применение записи при воспроизведении; false — журнал повреждён */
+    using Apply = std::function<bool(const QJsonObject& record, QString* err)>;
+
+    /**
+     * Читает записи по порядку. Отсутствующий файл — пустой журнал.
+     * Оборванная последняя строка отрезается, чтобы следующая запись
+     * не склеилась с ней.
+     */
+    static bool replay(const QString& path, const Apply& apply, int* records = nullptr,
+                       QString* err = nullptr);
+
+    /** Открывает файл для дозаписи; records — сколько записей в нём уже есть */
+    bool open(const QString& path, int records = 0, QString* err = nullptr);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+    QString path() const { return file_.fileName(); }
+    int recordCount() const { return records_; }
+
+    bool append(const QJsonObject& record, QString* err = nullptr);
+    /** Запись — уже готовый компактный JSON одной строкой (без перевода строки) */
+    bool append(const QByteArray& record, QString* err = nullptr);
+    /** Очищает журнал после сжатия в снимок */
+    bool clear(QString* err = nullptr);
+
+private:
+    QFile file_;
+    int records_ = 0;
+};
@@ -2,7 +2,7 @@
 
 #include <stdexcept>
 
-int Client::nextId = 1;
+std::atomic<int> Client::nextId{1};
 
 Client::Client(const QString& lastName, const QString& firstName, const QString& middleName,
                const QString& phone, const QString& email, const QDate& dateOfBirth,
@@ -17,8 +17,13 @@ Client::Client(const QString& lastName, const QString& firstName, const QString&
       comments_(comments),
       registrationAddress_(registrationAddress),
       actualAddress_(actualAddress) {
-    if (id > 0) { id_ = id; if (id >= nextId) nextId = id + 1; }
-    else { id_ = nextId++; }
+    if (id > 0) {
+        id_ = id;
+        int next = nextId.load();
+        while (id >= next && !nextId.compare_exchange_weak(next, id + 1)) {}
+    } else {
+        id_ = nextId++;
+    }
     if (lastName.trimmed().isEmpty() || firstName.trimmed().isEmpty())
         throw std::invalid_argument("Фамилия и имя клиента не могут быть пустыми");
 }
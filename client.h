@@ -2,6 +2,7 @@
 
 #include <QDate>
 #include <QString>
+#include <atomic>
 
 #include "address.h"
 
@@ -46,5 +47,5 @@ private:
     QString comments_;
     Address registrationAddress_;
     Address actualAddress_;
-    static int nextId;
+    static std::atomic<int> nextId;  // загрузка может идти в фоновом потоке
 };
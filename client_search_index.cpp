@@ -0,0 +1,137 @@
+#include "client_search_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "client.h"
+
+bool ClientSearchIndex::Entry::matches(const QString& query) const {
+    return fields[FullName].contains(query) || fields[Phone].contains(query)
+        || fields[Email].contains(query);
+}
+
+ClientSearchIndex::Entry ClientSearchIndex::makeEntry(Client* client) {
+    Entry e;
+    e.client = client;
+    e.fields[FullName] = client->getFullName().toLower();
+    e.fields[Phone] = client->getPhone();
+    e.fields[Email] = client->getEmail().toLower();
+    return e;
+}
+
+quint64 ClientSearchIndex::trigramKey(int field, const QString& s, int pos) {
+    return (quint64(field) << 48) | (quint64(s.at(pos).unicode()) << 32)
+         | (quint64(s.at(pos + 1).unicode()) << 16) | quint64(s.at(pos + 2).unicode());
+}
+
+std::vector<quint64> ClientSearchIndex::trigramKeys(int field, const QString& s) {
+    std::vector<quint64> keys;
+    if (s.size() < 3) return keys;
+    keys.reserve(s.size() - 2);
+    for (int i = 0; i + 2 < s.size(); ++i)
+        keys.push_back(trigramKey(field, s, i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+void ClientSearchIndex::indexEntry(quint32 seq, const Entry& entry) {
+    for (int f = 0; f < FieldCount; ++f) {
+        for (quint64 key : trigramKeys(f, entry.fields[f])) {
+            auto& list = postings_[key];
+            // Новые записи получают наибольший номер — обычно это просто push_back
+            if (list.empty() || list.back() < seq) list.push_back(seq);
+            else list.insert(std::lower_bound(list.begin(), list.end(), seq), seq);
+        }
+    }
+}
+
+void ClientSearchIndex::unindexEntry(quint32 seq, const Entry& entry) {
+    for (int f = 0; f < FieldCount; ++f) {
+        for (quint64 key : trigramKeys(f, entry.fields[f])) {
+            auto it = postings_.find(key);
+            if (it == postings_.end()) continue;
+            auto& list = it->second;
+            auto pos = std::lower_bound(list.begin(), list.end(), seq);
+            if (pos != list.end() && *pos == seq) list.erase(pos);
+            if (list.empty()) postings_.erase(it);
+        }
+    }
+}
+
+void ClientSearchIndex::clear() {
+    entries_.clear();
+    seqByClient_.clear();
+    postings_.clear();
+    nextSeq_ = 0;
+}
+
+void ClientSearchIndex::add(Client* client) {
+    const quint32 seq = nextSeq_++;
+    Entry entry = makeEntry(client);
+    indexEntry(seq, entry);
+    entries_.emplace(seq, std::move(entry));
+    seqByClient_[client] = seq;
+}
+
+void ClientSearchIndex::update(Client* client) {
+    auto it = seqByClient_.find(client);
+    if (it == seqByClient_.end()) { add(client); return; }
+    const quint32 seq = it->second;
+    Entry& entry = entries_[seq];
+    unindexEntry(seq, entry);
+    entry = makeEntry(client);
+    indexEntry(seq, entry);
+}
+
+void ClientSearchIndex::remove(Client* client) {
+    auto it = seqByClient_.find(client);
+    if (it == seqByClient_.end()) return;
+    const quint32 seq = it->second;
+    auto entryIt = entries_.find(seq);
+    unindexEntry(seq, entryIt->second);
+    entries_.erase(entryIt);
+    seqByClient_.erase(it);
+}
+
+std::vector<Client*> ClientSearchIndex::search(const QString& query) const {
+    std::vector<Client*> out;
+    if (query.isEmpty()) return out;
+
+    if (query.size() < 3) {
+        for (const auto& item : entries_)
+            if (item.second.matches(query)) out.push_back(item.second.client);
+        return out;
+    }
+
+    std::vector<quint32> matched;
+    for (int f = 0; f < FieldCount; ++f) {
+        std::vector<const std::vector<quint32>*> lists;
+        bool absent = false;
+        for (quint64 key : trigramKeys(f, query)) {
+            auto it = postings_.find(key);
+            if (it == postings_.end()) { absent = true; break; }
+            lists.push_back(&it->second);
+        }
+        if (absent) continue;
+        std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+        std::vector<quint32> candidates = *lists.front();
+        std::vector<quint32> next;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            next.clear();
+            std::set_intersection(candidates.begin(), candidates.end(),
+                                  lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+            candidates.swap(next);
+        }
+        // Триграммы не гарантируют подстроку — проверяем уцелевших кандидатов
+        for (quint32 seq : candidates)
+            if (entries_.at(seq).fields[f].contains(query)) matched.push_back(seq);
+    }
+
+    std::sort(matched.begin(), matched.end());
+    matched.erase(std::unique(matched.begin(), matched.end()), matched.end());
+    out.reserve(matched.size());
+    for (quint32 seq : matched) out.push_back(entries_.at(seq).client);
+    return out;
+}
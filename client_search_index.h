@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class Client;
+
+//=============================================================================
+// ClientSearchIndex — триграммный индекс для поиска клиентов по подстроке
+//=============================================================================
+
+/**
+ * Индексирует ФИО и email в нижнем регистре и телефон как есть.
+ * Запрос из 3+ символов отвечает пересечением списков триграмм с последующей
+ * проверкой кандидатов, более короткий — проходом по сохранённым строкам.
+ * Результаты совпадают с прямым сравнением contains() и идут в порядке добавления.
+ */
+class ClientSearchIndex {
+public:
+    void clear();
+    void add(Client* client);
+    /** Переиндексация после редактирования; позиция клиента в выдаче сохраняется */
+    void update(Client* client);
+    void remove(Client* client);
+    /** query — уже обрезанный и приведённый к нижнему регистру запрос */
+    std::vector<Client*> search(const QString& query) const;
+
+private:
+    enum Field { FullName = 0, Phone = 1, Email = 2, FieldCount = 3 };
+
+    struct Entry {
+        Client* client = nullptr;
+        QString fields[FieldCount];
+        bool matches(const QString& query) const;
+    };
+
+    std::map<quint32, Entry> entries_;                          // порядковый номер → запись
+    std::unordered_map<const Client*, quint32> seqByClient_;
+    std::unordered_map<quint64, std::vector<quint32>> postings_; // (поле, триграмма) → номера
+    quint32 nextSeq_ = 0;
+
+    static Entry makeEntry(Client* client);
+    static quint64 trigramKey(int field, const QString& s, int pos);
+    static std::vector<quint64> trigramKeys(int field, const QString& s);
+    void indexEntry(quint32 seq, const Entry& entry);
+    void unindexEntry(quint32 seq, const Entry& entry);
+};
@@ -1,6 +1,9 @@
 #include "client_service.h"
 
+#include <QtConcurrent>
+
 #include <exception>
+#include <numeric>
 
 #include "client.h"
 #include "validation_service.h"
@@ -25,6 +28,36 @@ bool ClientService::validateClient(const QString& lastName, const QString& first
     return true;
 }
 
+std::vector<FieldError> ClientService::clientErrors(const ClientRecord& record) {
+    std::vector<FieldError> out;
+    QString err;
+    if (!ValidationService::validateNamePart(record.lastName, &err)) out.push_back({"lastName", err});
+    if (!ValidationService::validateNamePart(record.firstName, &err)) out.push_back({"firstName", err});
+    if (!ValidationService::validateOptionalNamePart(record.middleName, &err)) out.push_back({"middleName", err});
+    for (FieldError& e : ValidationService::addressErrors(record.registrationAddress, "registrationAddress."))
+        out.push_back(std::move(e));
+    for (FieldError& e : ValidationService::addressErrors(record.actualAddress, "actualAddress."))
+        out.push_back(std::move(e));
+    if (record.phone.trimmed().isEmpty()) out.push_back({"phone", "Телефон обязателен"});
+    if (record.email.trimmed().isEmpty()) out.push_back({"email", "Email обязателен"});
+    return out;
+}
+
+std::vector<std::vector<FieldError>> ClientService::validateClients(const std::vector<ClientRecord>& records) {
+    const int count = static_cast<int>(records.size());
+    std::vector<std::vector<FieldError>> out(count);
+    // Выражения общие и неизменяемые, каждый элемент пишет только в свою ячейку
+    auto check = [&](int i) { out[i] = clientErrors(records[i]); };
+    if (count < PARALLEL_VALIDATE_MIN) {
+        for (int i = 0; i < count; ++i) check(i);
+    } else {
+        std::vector<int> indices(count);
+        std::iota(indices.begin(), indices.end(), 0);
+        QtConcurrent::blockingMap(indices, check);
+    }
+    return out;
+}
+
 Client* ClientService::createClient(const QString& lastName, const QString& firstName, const QString& middleName,
                                     const QString& phone, const QString& email, const QDate& dateOfBirth,
                                     const Address& registrationAddress, const Address& actualAddress,
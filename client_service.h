@@ -3,17 +3,44 @@
 #include <QString>
 #include <QDate>
 
+#include <vector>
+
 #include "address.h"
+#include "validation_service.h"
 
 class Client;
 
+/** Данные клиента до создания объекта (запись импорта, форма ввода) */
+struct ClientRecord {
+    QString lastName;
+    QString firstName;
+    QString middleName;
+    QString phone;
+    QString email;
+    Address registrationAddress;
+    Address actualAddress;
+};
+
 class ClientService {
 public:
     static bool validateClient(const QString& lastName, const QString& firstName, const QString& middleName,
                                const QString& phone, const QString& email, const Address& registrationAddress,
                                const Address& actualAddress, QString* err = nullptr);
+    /**
+     * Все ошибки одной записи по полям: "lastName", "firstName", "middleName",
+     * "phone", "email", "registrationAddress.city", "actualAddress.house" и т.д.
+     */
+    static std::vector<FieldError> clientErrors(const ClientRecord& record);
+    /**
+     * Пакетная проверка: ошибки по каждой записи в том же порядке (пусто —
+     * запись верна). Большие пакеты проверяются параллельно.
+     */
+    static std::vector<std::vector<FieldError>> validateClients(const std::vector<ClientRecord>& records);
     static Client* createClient(const QString& lastName, const QString& firstName, const QString& middleName,
                                 const QString& phone, const QString& email, const QDate& dateOfBirth,
                                 const Address& registrationAddress, const Address& actualAddress,
                                 const QString& comments, int id = 0, QString* err = nullptr);
+
+private:
+    static constexpr int PARALLEL_VALIDATE_MIN = 256;  // меньше записей — в одном потоке
 };
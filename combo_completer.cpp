@@ -0,0 +1,60 @@
+#include "combo_completer.h"
+
+#include <QAbstractItemView>
+#include <QAbstractProxyModel>
+#include <QComboBox>
+#include <QCompleter>
+#include <QLineEdit>
+
+#include "search_controller.h"
+
+ComboCompleter::ComboCompleter(QComboBox* combo, Search search, Label label)
+    : QObject(combo), combo_(combo), search_(std::move(search)) {
+    results_ = new SearchResultModel({QString()}, [label](int id, int) { return label(id); }, this);
+
+    combo_->setEditable(true);
+    combo_->setInsertPolicy(QComboBox::NoInsert);
+
+    // Модель подсказок уже отобрана поиском: QCompleter её не фильтрует
+    completer_ = new QCompleter(results_, this);
+    completer_->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer_->setCaseSensitivity(Qt::CaseInsensitive);
+    completer_->setCompletionRole(Qt::DisplayRole);
+    combo_->setCompleter(completer_);
+
+    debounce_.setSingleShot(true);
+    debounce_.setInterval(DEBOUNCE_MS);
+    connect(&debounce_, &QTimer::timeout, this, &ComboCompleter::runSearch);
+    connect(combo_->lineEdit(), &QLineEdit::textEdited, &debounce_, qOverload<>(&QTimer::start));
+    connect(combo_->lineEdit(), &QLineEdit::editingFinished, this, &ComboCompleter::restoreText);
+    connect(completer_, qOverload<const QModelIndex&>(&QCompleter::activated),
+            this, &ComboCompleter::onActivated);
+}
+
+void ComboCompleter::runSearch() {
+    const QString text = combo_->lineEdit()->text().trimmed();
+    if (text.size() < MIN_CHARS) {
+        results_->setResults({});
+        completer_->popup()->hide();
+        return;
+    }
+    results_->setResults(search_(text));
+    if (results_->totalCount() > 0) completer_->complete();
+    else completer_->popup()->hide();
+}
+
+void ComboCompleter::onActivated(const QModelIndex& index) {
+    // Индекс — из модели завершения QCompleter, id — в исходной модели подсказок
+    const auto* proxy = qobject_cast<const QAbstractProxyModel*>(completer_->completionModel());
+    const int row = proxy ? proxy->mapToSource(index).row() : index.row();
+    const int id = results_->idAt(row);
+    if (id != 0) emit picked(id);
+    // QCompleter ещё запишет в строку текст подсказки — текст элемента ставится после
+    QTimer::singleShot(0, this, &ComboCompleter::restoreText);
+}
+
+void ComboCompleter::restoreText() {
+    if (completer_->popup()->isVisible()) return;
+    debounce_.stop();
+    combo_->lineEdit()->setText(combo_->itemText(combo_->currentIndex()));
+}
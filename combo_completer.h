@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+#include <vector>
+
+class QComboBox;
+class QCompleter;
+class QModelIndex;
+class SearchResultModel;
+
+//=============================================================================
+// ComboCompleter — подсказки при вводе в выпадающем списке
+//=============================================================================
+
+/**
+ * Делает список редактируемым и подключает к нему QCompleter над найденными id.
+ * После паузы ввода DEBOUNCE_MS вызывается search — в потоке окна, поэтому он
+ * должен отвечать по индексу (например, TravelAgency::searchClients). Строки
+ * подсказок подгружаются страницами SearchResultModel. Выбор подсказки — сигнал
+ * picked; сам список при этом не перебирается.
+ */
+class ComboCompleter : public QObject {
+    Q_OBJECT
+public:
+    using Search = std::function<std::vector<int>(const QString& text)>;
+    /** Текст подсказки для id */
+    using Label = std::function<QString(int id)>;
+
+    static constexpr int DEBOUNCE_MS = 150;  // пауза ввода перед поиском
+    static constexpr int MIN_CHARS = 2;      // более короткий текст не ищется
+
+    ComboCompleter(QComboBox* combo, Search search, Label label);
+
+signals:
+    void picked(int id);
+
+private:
+    QComboBox* combo_;
+    Search search_;
+    SearchResultModel* results_;
+    QCompleter* completer_;
+    QTimer debounce_;
+
+    void runSearch();
+    void onActivated(const QModelIndex& index);
+    /** Ввод брошен без выбора: в строке снова текст текущего элемента */
+    void restoreText();
+};
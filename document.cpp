@@ -2,7 +2,122 @@
 
 #include "document_service.h"
 
-Document::Document(DocumentType type, DocumentStatus status) : type_(type), status_(status) {}
+#include <algorithm>
+
+namespace {
+
+int slotCount(DocumentType type) {
+    return static_cast<int>(DocumentService::fieldsForType(type).size());
+}
+
+QDate parseDate(const QString& text) {
+    const QString t = text.trimmed();
+    if (t.isEmpty()) return QDate();
+    const QDate iso = QDate::fromString(t, Qt::ISODate);
+    return iso.isValid() ? iso : QDate::fromString(t, "dd.MM.yyyy");
+}
+
+bool isDateField(DocumentType type, int index) {
+    return DocumentService::fieldsForType(type)[index].kind == DocumentField::Kind::Date;
+}
+
+} // namespace
+
+Document::Document(DocumentType type, DocumentStatus status) : type_(type), status_(status) {
+    const int n = slotCount(type);
+    if (n > 0) slots_.reset(new Slot[n]);
+}
+
+Document::Document(const Document& other)
+    : type_(other.type_), status_(other.status_), extra_(other.extra_) {
+    const int n = slotCount(type_);
+    if (n > 0) {
+        slots_.reset(new Slot[n]);
+        std::copy(other.slots_.get(), other.slots_.get() + n, slots_.get());
+    }
+}
+
+Document& Document::operator=(const Document& other) {
+    if (this == &other) return *this;
+    const int n = slotCount(other.type_);
+    if (type_ != other.type_) slots_.reset(n > 0 ? new Slot[n] : nullptr);
+    type_ = other.type_;
+    status_ = other.status_;
+    extra_ = other.extra_;
+    std::copy(other.slots_.get(), other.slots_.get() + n, slots_.get());
+    touch();
+    return *this;
+}
+
+QString Document::valueAt(int index) const {
+    if (index < 0 || index >= slotCount(type_)) return QString();
+    const Slot& slot = slots_[index];
+    return slot.text.isEmpty() ? slot.date.toString(Qt::ISODate) : slot.text;
+}
+
+QDate Document::dateAt(int index) const {
+    if (index < 0 || index >= slotCount(type_)) return QDate();
+    return slots_[index].date;
+}
+
+QVariant Document::field(const QString& key) const {
+    const int index = DocumentService::fieldIndex(type_, key);
+    if (index < 0) return extra_.value(key);
+    const QString value = valueAt(index);
+    return value.isEmpty() ? QVariant() : QVariant(value);
+}
+
+QDate Document::date(const QString& key) const {
+    const int index = DocumentService::fieldIndex(type_, key);
+    if (index >= 0 && slots_[index].date.isValid()) return slots_[index].date;
+    return parseDate(field(key).toString());
+}
+
+void Document::setSlot(int index, const QString& text) {
+    Slot& slot = slots_[index];
+    if (isDateField(type_, index)) {
+        slot.date = parseDate(text);
+        // Строку ISO незачем хранить второй раз; прочие возвращаются как введены
+        slot.text = slot.date.isValid() && slot.date.toString(Qt::ISODate) == text ? QString() : text;
+    } else {
+        slot.text = text;
+    }
+}
+
+void Document::setField(const QString& key, const QVariant& value) {
+    const int index = DocumentService::fieldIndex(type_, key);
+    if (index < 0) {
+        extra_.insert(key, value);
+    } else if (value.userType() == QMetaType::QDate) {
+        slots_[index].date = value.toDate();
+        slots_[index].text.clear();
+    } else {
+        setSlot(index, value.toString());
+    }
+    touch();
+}
+
+void Document::setDate(const QString& key, const QDate& date) {
+    setField(key, date);
+}
+
+QVariantMap Document::fields() const {
+    QVariantMap out = extra_;
+    const auto& defs = DocumentService::fieldsForType(type_);
+    for (size_t i = 0; i < defs.size(); ++i) {
+        const QString value = valueAt(static_cast<int>(i));
+        if (!value.isEmpty()) out.insert(defs[i].key, value);
+    }
+    return out;
+}
+
+void Document::setFields(const QVariantMap& fields) {
+    const int n = slotCount(type_);
+    for (int i = 0; i < n; ++i) slots_[i] = Slot();
+    extra_.clear();
+    for (auto it = fields.begin(); it != fields.end(); ++it) setField(it.key(), it.value());
+    touch();
+}
 
 QString Document::typeName(DocumentType t) {
     switch (t) {
@@ -1,30 +1,75 @@
 #pragma once
 
+#include <QDate>
 #include <QString>
 #include <QVariantMap>
 
+#include <memory>
+
 #include "agency_types.h"
 
 //=============================================================================
 // Класс Document — документ с типом и статусом
 //=============================================================================
 
+/**
+ * Поля хранятся в ячейках по номеру поля в DocumentService::fieldsForType(type):
+ * текст — QString, даты — QDate. Ключи, которых нет в схеме типа (старые
+ * файлы), сохраняются отдельно и не теряются при записи.
+ * fields()/setFields() — совместимый вид QVariantMap для JSON и снимка.
+ */
 class Document {
 public:
     Document(DocumentType type, DocumentStatus status = DocumentStatus::Absent);
+    /** Копия не привязана к флагу изменений: владелец привязывает её сам (см. bindChangeFlag) */
+    Document(const Document& other);
+    /** Привязка остаётся прежней, флаг выставляется — присваивание тоже изменение */
+    Document& operator=(const Document& other);
     DocumentType getType() const { return type_; }
     DocumentStatus getStatus() const { return status_; }
-    void setStatus(DocumentStatus s) { status_ = s; }
-    QVariantMap& fields() { return fields_; }
-    const QVariantMap& fields() const { return fields_; }
+    void setStatus(DocumentStatus s) { status_ = s; touch(); }
+
+    // --- Поля по номеру в схеме типа ---
+    /** Текст поля; дата — в том виде, в каком введена (QDate — ISO). Пусто — поле не заполнено */
+    QString valueAt(int index) const;
+    QDate dateAt(int index) const;
+
+    // --- Поля по ключу (как в JSON) ---
+    QVariant field(const QString& key) const;
+    /** Поле-дата (для прочих полей строка разбирается как дата) */
+    QDate date(const QString& key) const;
+    /** Строка для поля-даты разбирается (ISO или dd.MM.yyyy); неразобранная хранится как текст */
+    void setField(const QString& key, const QVariant& value);
+    void setDate(const QString& key, const QDate& date);
+    /** Заполненные поля как QVariantMap (даты — строками, как в valueAt) */
+    QVariantMap fields() const;
+    void setFields(const QVariantMap& fields);
+
     QString displayName() const;
     bool validate(QString* err = nullptr) const;
     /** Возвращает строковое название типа документа */
     static QString typeName(DocumentType t);
     /** Возвращает строковое название статуса */
     static QString statusName(DocumentStatus s);
+    /** Флаг владельца, который выставляется при каждом изменении (кэш полноты заявки) */
+    void bindChangeFlag(bool* changed) { changed_ = changed; }
+
 private:
+    /**
+     * Ячейка поля: для даты заполнена date, text — исходная строка, если она
+     * не ISO (dd.MM.yyyy или не разобралась); ISO восстанавливается из date
+     */
+    struct Slot {
+        QString text;
+        QDate date;
+    };
+
     DocumentType type_;
     DocumentStatus status_;
-    QVariantMap fields_;
+    std::unique_ptr<Slot[]> slots_;  // по числу полей типа
+    QVariantMap extra_;              // ключи вне схемы типа
+    bool* changed_ = nullptr;
+
+    void setSlot(int index, const QString& text);
+    void touch() { if (changed_) *changed_ = true; }
 };
@@ -0,0 +1,139 @@
+#include "document_audit_dialog.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDateEdit>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include <unordered_set>
+
+DocumentAuditDialog::DocumentAuditDialog(const TravelAgency& agency, QWidget* parent)
+    : QDialog(parent), agency_(agency) {
+    setWindowTitle("Аудит документов");
+    resize(980, 560);
+
+    auto* mainLayout = new QVBoxLayout(this);
+
+    auto* filterLayout = new QHBoxLayout();
+    tourCombo_ = new QComboBox(this);
+    tourCombo_->addItem("Все туры", 0);
+    for (const Tour* t : agency_.tours())
+        tourCombo_->addItem(QString("%1 (%2)").arg(t->getName(), t->getStartDate().toString("dd.MM.yyyy")),
+                            t->getId());
+    windowCheck_ = new QCheckBox("Вылет с", this);
+    fromEdit_ = new QDateEdit(QDate::currentDate(), this);
+    toEdit_ = new QDateEdit(QDate::currentDate().addDays(7), this);
+    fromEdit_->setCalendarPopup(true);
+    toEdit_->setCalendarPopup(true);
+    fromEdit_->setEnabled(false);
+    toEdit_->setEnabled(false);
+    runButton_ = new QPushButton("Проверить", this);
+    filterLayout->addWidget(new QLabel("Тур:", this));
+    filterLayout->addWidget(tourCombo_, 1);
+    filterLayout->addWidget(windowCheck_);
+    filterLayout->addWidget(fromEdit_);
+    filterLayout->addWidget(new QLabel("по", this));
+    filterLayout->addWidget(toEdit_);
+    filterLayout->addWidget(runButton_);
+    mainLayout->addLayout(filterLayout);
+
+    table_ = new QTableWidget(this);
+    table_->setColumnCount(5);
+    table_->setHorizontalHeaderLabels({"Заявка", "Тур", "Вылет", "Кому", "Недостающие документы"});
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(table_, 1);
+
+    summaryLabel_ = new QLabel(this);
+    mainLayout->addWidget(summaryLabel_);
+
+    connect(windowCheck_, &QCheckBox::toggled, fromEdit_, &QWidget::setEnabled);
+    connect(windowCheck_, &QCheckBox::toggled, toEdit_, &QWidget::setEnabled);
+    connect(runButton_, &QPushButton::clicked, this, &DocumentAuditDialog::onRunAudit);
+    connect(&auditWatcher_, &QFutureWatcher<std::vector<DocumentAuditEntry>>::finished,
+            this, &DocumentAuditDialog::onAuditFinished);
+    connect(table_, &QTableWidget::cellDoubleClicked, this, [this](int row, int) {
+        selectedRequestId_ = table_->item(row, 0)->data(Qt::UserRole).toInt();
+        accept();
+    });
+
+    onRunAudit();
+}
+
+DocumentAuditDialog::~DocumentAuditDialog() {
+    auditWatcher_.waitForFinished();
+}
+
+void DocumentAuditDialog::reject() {
+    // Рабочий поток читает агентство: окно закрывается после проверки
+    if (auditWatcher_.isRunning()) return;
+    QDialog::reject();
+}
+
+void DocumentAuditDialog::setAuditRunning(bool running) {
+    tourCombo_->setEnabled(!running);
+    windowCheck_->setEnabled(!running);
+    fromEdit_->setEnabled(!running && windowCheck_->isChecked());
+    toEdit_->setEnabled(!running && windowCheck_->isChecked());
+    runButton_->setEnabled(!running);
+    table_->setEnabled(!running);
+    if (running) setCursor(Qt::BusyCursor);
+    else unsetCursor();
+}
+
+void DocumentAuditDialog::onRunAudit() {
+    if (auditWatcher_.isRunning()) return;
+    DocumentAuditFilter filter;
+    filter.tourId = tourCombo_->currentData().toInt();
+    if (windowCheck_->isChecked()) {
+        filter.departureFrom = fromEdit_->date();
+        filter.departureTo = toEdit_->date();
+    }
+
+    setAuditRunning(true);
+    summaryLabel_->setText("Проверка документов...");
+    const TravelAgency* agency = &agency_;
+    auditWatcher_.setFuture(QtConcurrent::run([agency, filter]() { return agency->auditDocuments(filter); }));
+}
+
+void DocumentAuditDialog::onAuditFinished() {
+    setAuditRunning(false);
+    const std::vector<DocumentAuditEntry> entries = auditWatcher_.result();
+
+    table_->setRowCount(0);
+    table_->setRowCount(static_cast<int>(entries.size()));
+    std::unordered_set<int> requests;
+    int row = 0;
+    for (const DocumentAuditEntry& e : entries) {
+        const TourRequest* r = agency_.findRequestById(e.requestId);
+        if (!r) continue;
+        requests.insert(e.requestId);
+        QStringList docs;
+        for (DocumentType type : DocumentRules::typesOf(e.missing)) {
+            docs << (e.unverified & documentBit(type) ? Document::typeName(type) + " (не проверен)"
+                                                      : Document::typeName(type));
+        }
+        const QString owner = e.touristIndex < 0 ? QString("Заявка")
+                                                 : r->getTourists()[e.touristIndex]->getFullName();
+        auto* idItem = new QTableWidgetItem(QString::number(e.requestId));
+        idItem->setData(Qt::UserRole, e.requestId);
+        table_->setItem(row, 0, idItem);
+        table_->setItem(row, 1, new QTableWidgetItem(r->getTour()->getName()));
+        table_->setItem(row, 2, new QTableWidgetItem(r->getTour()->getStartDate().toString("dd.MM.yyyy")));
+        table_->setItem(row, 3, new QTableWidgetItem(owner));
+        table_->setItem(row, 4, new QTableWidgetItem(docs.join(", ")));
+        ++row;
+    }
+    table_->setRowCount(row);
+    table_->resizeColumnsToContents();
+    summaryLabel_->setText(entries.empty() ? QString("Все документы проверены")
+                                           : QString("Заявок с недостающими документами: %1").arg(requests.size()));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+#include <vector>
+
+#include "travel_agency.h"
+
+class QCheckBox;
+class QComboBox;
+class QDateEdit;
+class QLabel;
+class QPushButton;
+class QTableWidget;
+
+//=============================================================================
+// DocumentAuditDialog — отчёт о недостающих документах по всем заявкам
+//=============================================================================
+
+/**
+ * Отбор по туру и окну вылета, результат TravelAgency::auditDocuments таблицей.
+ * Аудит идёт в фоне; окно модальное, поэтому данные агентства в это время не
+ * правятся, а само окно до конца проверки не закрывается.
+ */
+class DocumentAuditDialog : public QDialog {
+    Q_OBJECT
+public:
+    explicit DocumentAuditDialog(const TravelAgency& agency, QWidget* parent = nullptr);
+    ~DocumentAuditDialog() override;
+    /** id заявки, выбранной двойным щелчком (0 — не выбрана) */
+    int selectedRequestId() const { return selectedRequestId_; }
+
+public slots:
+    void reject() override;
+
+private slots:
+    void onRunAudit();
+    void onAuditFinished();
+
+private:
+    const TravelAgency& agency_;
+    QComboBox* tourCombo_ = nullptr;
+    QCheckBox* windowCheck_ = nullptr;
+    QDateEdit* fromEdit_ = nullptr;
+    QDateEdit* toEdit_ = nullptr;
+    QPushButton* runButton_ = nullptr;
+    QTableWidget* table_ = nullptr;
+    QLabel* summaryLabel_ = nullptr;
+    int selectedRequestId_ = 0;
+    QFutureWatcher<std::vector<DocumentAuditEntry>> auditWatcher_;
+
+    void setAuditRunning(bool running);
+};
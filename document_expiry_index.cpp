@@ -0,0 +1,103 @@
+#include "document_expiry_index.h"
+
+#include "document.h"
+#include "tour.h"
+#include "tour_request.h"
+
+namespace {
+
+const char* const VALID_FROM = "validFrom";
+const char* const VALID_TO = "validTo";
+
+void collectFrom(const std::vector<std::unique_ptr<Document>>& docs, int requestId, int touristIndex,
+                 std::vector<DocumentValidity>* out) {
+    for (const auto& doc : docs) {
+        const QDate from = doc->date(VALID_FROM);
+        const QDate to = doc->date(VALID_TO);
+        if (from.isValid() || to.isValid())
+            out->push_back({requestId, touristIndex, doc->getType(), from, to});
+    }
+}
+
+} // namespace
+
+void DocumentExpiryIndex::clear() {
+    byValidTo_.clear();
+    byRequest_.clear();
+    invalid_.clear();
+}
+
+void DocumentExpiryIndex::update(const TourRequest& request) {
+    remove(request.getId());
+    const std::vector<DocumentValidity> entries = collect(request);
+    if (entries.empty()) return;
+    auto& positions = byRequest_[request.getId()];
+    std::vector<DocumentValidity> invalid;
+    for (const DocumentValidity& v : entries) {
+        // Без даты окончания документ бессрочный: в выборку по истечению не входит
+        if (v.validTo.isValid()) positions.push_back(byValidTo_.emplace(v.validTo, v));
+        if (!coversTrip(v, *request.getTour())) invalid.push_back(v);
+    }
+    if (positions.empty()) byRequest_.erase(request.getId());
+    if (!invalid.empty()) invalid_[request.getId()] = std::move(invalid);
+}
+
+void DocumentExpiryIndex::remove(int requestId) {
+    auto it = byRequest_.find(requestId);
+    if (it != byRequest_.end()) {
+        for (auto pos : it->second) byValidTo_.erase(pos);
+        byRequest_.erase(it);
+    }
+    invalid_.erase(requestId);
+}
+
+std::vector<DocumentValidity> DocumentExpiryIndex::invalidForTrip() const {
+    std::vector<DocumentValidity> out;
+    for (const auto& item : invalid_)
+        out.insert(out.end(), item.second.begin(), item.second.end());
+    return out;
+}
+
+std::vector<DocumentValidity> DocumentExpiryIndex::invalidForTrip(int requestId) const {
+    auto it = invalid_.find(requestId);
+    return it != invalid_.end() ? it->second : std::vector<DocumentValidity>();
+}
+
+std::vector<DocumentValidity> DocumentExpiryIndex::expiringWithin(const QDate& from, int days) const {
+    std::vector<DocumentValidity> out;
+    const auto end = byValidTo_.upper_bound(from.addDays(days));
+    for (auto it = byValidTo_.lower_bound(from); it != end; ++it) out.push_back(it->second);
+    return out;
+}
+
+std::vector<DocumentValidity> DocumentExpiryIndex::collect(const TourRequest& request) {
+    std::vector<DocumentValidity> out;
+    const auto& tourists = request.getTourists();
+    for (size_t i = 0; i < tourists.size(); ++i) {
+        const Tourist& t = *tourists[i];
+        collectFrom(t.documents(), request.getId(), static_cast<int>(i), &out);
+    }
+    collectFrom(request.getDocuments(), request.getId(), -1, &out);
+    return out;
+}
+
+bool DocumentExpiryIndex::coversTrip(const DocumentValidity& validity, const Tour& tour) {
+    if (validity.validFrom.isValid() && validity.validFrom > tour.getStartDate()) return false;
+    if (validity.validTo.isValid() && validity.validTo < tour.getEndDate()) return false;
+    return true;
+}
+
+QString DocumentExpiryIndex::describe(const DocumentValidity& validity, const TourRequest& request) {
+    const QString owner = validity.touristIndex >= 0
+        && validity.touristIndex < static_cast<int>(request.getTourists().size())
+            ? request.getTourists()[validity.touristIndex]->getFullName()
+            : QString("Заявка");
+    const Tour& tour = *request.getTour();
+    const QString doc = Document::typeName(validity.type);
+    if (validity.validFrom.isValid() && validity.validFrom > tour.getStartDate()) {
+        return QString("%1: %2 действует только с %3, вылет %4")
+            .arg(owner, doc, validity.validFrom.toString("dd.MM.yyyy"), tour.getStartDate().toString("dd.MM.yyyy"));
+    }
+    return QString("%1: %2 действует до %3, возвращение %4")
+        .arg(owner, doc, validity.validTo.toString("dd.MM.yyyy"), tour.getEndDate().toString("dd.MM.yyyy"));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QDate>
+#include <QString>
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "agency_types.h"
+
+class Tour;
+class TourRequest;
+
+/** Срок действия документа заявки (поля validFrom/validTo) */
+struct DocumentValidity {
+    int requestId;
+    int touristIndex;    // индекс в getTourists(); -1 — документ заявки
+    DocumentType type;
+    QDate validFrom;     // недействительная дата — поле не заполнено
+    QDate validTo;
+};
+
+//=============================================================================
+// DocumentExpiryIndex — индекс сроков действия документов
+//=============================================================================
+
+/**
+ * Документы с датами упорядочены по validTo, поэтому «истекает в ближайшие
+ * N дней» — выборка диапазона. Документы, не покрывающие даты своей поездки,
+ * вычисляются при индексации заявки и хранятся отдельно по заявкам.
+ * Заявка переиндексируется целиком после изменения её документов или тура.
+ */
+class DocumentExpiryIndex {
+public:
+    void clear();
+    /** Переиндексация документов заявки (после правки полей, смены тура) */
+    void update(const TourRequest& request);
+    void remove(int requestId);
+
+    /** Все документы, не покрывающие даты поездки, по возрастанию id заявки */
+    std::vector<DocumentValidity> invalidForTrip() const;
+    std::vector<DocumentValidity> invalidForTrip(int requestId) const;
+    /** Документы, срок которых истекает с from по from + days включительно */
+    std::vector<DocumentValidity> expiringWithin(const QDate& from, int days) const;
+
+    /** Документы заявки с заполненными датами (без индекса) */
+    static std::vector<DocumentValidity> collect(const TourRequest& request);
+    /** Срок действия покрывает поездку: с даты начала тура до даты окончания */
+    static bool coversTrip(const DocumentValidity& validity, const Tour& tour);
+    /** Текст предупреждения: кому, какой документ и почему не подходит */
+    static QString describe(const DocumentValidity& validity, const TourRequest& request);
+
+private:
+    using ByValidTo = std::multimap<QDate, DocumentValidity>;
+
+    ByValidTo byValidTo_;
+    // id заявки → её записи в byValidTo_ (итераторы multimap устойчивы)
+    std::unordered_map<int, std::vector<ByValidTo::iterator>> byRequest_;
+    // id заявки → документы, не покрывающие поездку (только непустые)
+    std::map<int, std::vector<DocumentValidity>> invalid_;
+};
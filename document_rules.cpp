@@ -0,0 +1,211 @@
+#include "document_rules.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+
+#include <atomic>
+
+#include "tour.h"
+
+namespace {
+
+// Имена типов в файле правил, по порядку перечисления DocumentType
+const char* const TYPE_KEYS[DOCUMENT_TYPE_COUNT] = {
+    "Passport", "InternationalPassport", "BirthCertificate", "OMSPolicy", "SNILS", "INN", "Visa",
+    "InsurancePolicy", "BenefitDocument", "Voucher", "Tickets", "ConsentForChildDeparture",
+    "VeterinaryPassport"
+};
+
+// Порядок документов в списках (как до таблицы правил): сначала удостоверения
+// личности, затем документы ребёнка и льготы; у заявки — путёвка, страховка,
+// билеты, ветпаспорт. Не зависит от номеров DocumentType
+const DocumentType DISPLAY_ORDER[DOCUMENT_TYPE_COUNT] = {
+    DocumentType::Passport, DocumentType::InternationalPassport, DocumentType::Visa,
+    DocumentType::BirthCertificate, DocumentType::OMSPolicy, DocumentType::ConsentForChildDeparture,
+    DocumentType::BenefitDocument, DocumentType::SNILS, DocumentType::INN,
+    DocumentType::Voucher, DocumentType::InsurancePolicy, DocumentType::Tickets,
+    DocumentType::VeterinaryPassport
+};
+
+// Признаки в условиях файла правил
+struct FlagKey {
+    const char* key;
+    DocumentRules::Flag flag;
+};
+const FlagKey FLAG_KEYS[] = {
+    {"domestic", DocumentRules::Domestic},
+    {"visa", DocumentRules::VisaRequired},
+    {"child", DocumentRules::Child},
+    {"benefit", DocumentRules::Benefit},
+    {"animals", DocumentRules::Animals},
+    {"travelMode", DocumentRules::HasTravelMode}
+};
+
+DocumentRules::Rule rule(DocumentRules::Scope scope, unsigned care, unsigned value,
+                         std::initializer_list<DocumentType> types, const QString& tourTypeContains = QString()) {
+    DocumentRules::Rule r;
+    r.scope = scope;
+    r.care = care;
+    r.value = value;
+    r.tourTypeContains = tourTypeContains;
+    for (DocumentType t : types) r.documents |= documentBit(t);
+    return r;
+}
+
+DocumentRules& activeStorage() {
+    static DocumentRules rules = DocumentRules::defaults();
+    return rules;
+}
+
+std::atomic<std::uint64_t> activeRevision{0};
+
+} // namespace
+
+DocumentRules DocumentRules::defaults() {
+    using T = DocumentType;
+    const Scope P = Scope::Tourist;
+    const Scope R = Scope::Request;
+    DocumentRules rules;
+    // Внутренний тур: паспорт или свидетельство о рождении, полис ОМС
+    rules.addRule(rule(P, Domestic | Child, Domestic, {T::Passport}));
+    rules.addRule(rule(P, Domestic | Child, Domestic | Child, {T::BirthCertificate}));
+    rules.addRule(rule(P, Domestic, Domestic, {T::OMSPolicy}));
+    // Зарубежный тур: загранпаспорт, виза; детям — свидетельство и согласие на выезд
+    rules.addRule(rule(P, Domestic, 0, {T::InternationalPassport}));
+    rules.addRule(rule(P, Domestic | VisaRequired, VisaRequired, {T::Visa}));
+    rules.addRule(rule(P, Domestic | Child, Child, {T::BirthCertificate, T::ConsentForChildDeparture}));
+    rules.addRule(rule(P, Benefit, Benefit, {T::BenefitDocument}));
+    // Документы заявки
+    rules.addRule(rule(R, Domestic, 0, {T::Voucher, T::InsurancePolicy}));
+    rules.addRule(rule(R, Domestic, Domestic, {T::InsurancePolicy}, "актив"));
+    rules.addRule(rule(R, HasTravelMode, HasTravelMode, {T::Tickets}));
+    rules.addRule(rule(R, Animals, Animals, {T::VeterinaryPassport}));
+    return rules;
+}
+
+const DocumentRules& DocumentRules::active() {
+    return activeStorage();
+}
+
+void DocumentRules::setActive(const DocumentRules& rules) {
+    activeStorage() = rules;
+    ++activeRevision;
+}
+
+std::uint64_t DocumentRules::revision() {
+    return activeRevision.load();
+}
+
+void DocumentRules::addRule(const Rule& rule) {
+    rules_.push_back(rule);
+    compile(rule);
+}
+
+void DocumentRules::compile(const Rule& rule) {
+    const int scope = static_cast<int>(rule.scope);
+    if (!rule.country.isEmpty() || !rule.tourTypeContains.isEmpty() || !rule.travelMode.isEmpty()) {
+        conditional_[scope].push_back(rule);
+        return;
+    }
+    for (unsigned flags = 0; flags < TABLE_SIZE; ++flags) {
+        if ((flags & rule.care) == rule.value) table_[scope][flags] |= rule.documents;
+    }
+}
+
+DocumentMask DocumentRules::required(Scope scope, unsigned flags, const Tour& tour,
+                                     const QString& travelMode) const {
+    const int s = static_cast<int>(scope);
+    DocumentMask mask = table_[s][flags & (TABLE_SIZE - 1)];
+    for (const Rule& r : conditional_[s]) {
+        if ((flags & r.care) != r.value || (mask | r.documents) == mask) continue;
+        if (!r.country.isEmpty() && tour.getCountry().compare(r.country, Qt::CaseInsensitive) != 0) continue;
+        if (!r.tourTypeContains.isEmpty() && !tour.getTourType().contains(r.tourTypeContains, Qt::CaseInsensitive))
+            continue;
+        if (!r.travelMode.isEmpty() && travelMode.compare(r.travelMode, Qt::CaseInsensitive) != 0) continue;
+        mask |= r.documents;
+    }
+    return mask;
+}
+
+bool DocumentRules::loadFile(const QString& path, QString* err) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (err) *err = "Не удалось открыть файл правил документов";
+        return false;
+    }
+    QJsonParseError perr;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &perr);
+    if (!doc.isObject()) {
+        if (err) *err = "Файл правил документов: " + (doc.isNull() ? perr.errorString() : QString("ожидался объект"));
+        return false;
+    }
+
+    std::vector<Rule> parsed;
+    const QJsonArray arr = doc.object()["rules"].toArray();
+    for (int i = 0; i < arr.size(); ++i) {
+        const QJsonObject o = arr.at(i).toObject();
+        auto fail = [&](const QString& message) {
+            if (err) *err = QString("Правило %1: %2").arg(i + 1).arg(message);
+            return false;
+        };
+        Rule r;
+        const QString scope = o["scope"].toString();
+        if (scope == "tourist") r.scope = Scope::Tourist;
+        else if (scope == "request") r.scope = Scope::Request;
+        else return fail("scope должен быть \"tourist\" или \"request\"");
+
+        const QJsonObject when = o["when"].toObject();
+        for (auto it = when.begin(); it != when.end(); ++it) {
+            const QString key = it.key();
+            if (key == "country") { r.country = it.value().toString(); continue; }
+            if (key == "tourType") { r.tourTypeContains = it.value().toString(); continue; }
+            if (key == "travelMode" && it.value().isString()) { r.travelMode = it.value().toString(); continue; }
+            bool known = false;
+            for (const FlagKey& fk : FLAG_KEYS) {
+                if (key != QLatin1String(fk.key)) continue;
+                if (!it.value().isBool()) return fail(QString("условие '%1' должно быть true/false").arg(key));
+                r.care |= fk.flag;
+                if (it.value().toBool()) r.value |= fk.flag;
+                known = true;
+            }
+            if (!known) return fail(QString("неизвестное условие '%1'").arg(key));
+        }
+
+        const QJsonArray require = o["require"].toArray();
+        if (require.isEmpty()) return fail("пустой список require");
+        for (const QJsonValue& v : require) {
+            DocumentType type;
+            if (!typeFromKey(v.toString(), &type)) return fail(QString("неизвестный документ '%1'").arg(v.toString()));
+            r.documents |= documentBit(type);
+        }
+        parsed.push_back(r);
+    }
+
+    for (const Rule& r : parsed) addRule(r);
+    return true;
+}
+
+QString DocumentRules::typeKey(DocumentType type) {
+    const int i = static_cast<int>(type);
+    return i >= 0 && i < DOCUMENT_TYPE_COUNT ? QString::fromLatin1(TYPE_KEYS[i]) : QString();
+}
+
+bool DocumentRules::typeFromKey(const QString& key, DocumentType* type) {
+    for (int i = 0; i < DOCUMENT_TYPE_COUNT; ++i) {
+        if (key == QLatin1String(TYPE_KEYS[i])) {
+            *type = static_cast<DocumentType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<DocumentType> DocumentRules::typesOf(DocumentMask mask) {
+    std::vector<DocumentType> out;
+    for (DocumentType type : DISPLAY_ORDER)
+        if (mask & documentBit(type)) out.push_back(type);
+    return out;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QString>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "agency_types.h"
+
+class Tour;
+
+/** Набор типов документов: бит static_cast<int>(type) */
+using DocumentMask = std::uint32_t;
+static_assert(DOCUMENT_TYPE_COUNT <= 32, "DocumentMask вмещает не больше 32 типов");
+
+inline DocumentMask documentBit(DocumentType type) { return DocumentMask(1) << static_cast<int>(type); }
+
+//=============================================================================
+// DocumentRules — правила обязательных документов
+//=============================================================================
+
+/**
+ * Правило: при выполнении условий требуются документы из его набора.
+ * Условия — признаки поездки и туриста (внутренний тур, виза, ребёнок, льгота,
+ * животные, указан способ поездки) и строки (страна, подстрока типа тура,
+ * способ поездки). Неуказанное условие выполняется всегда.
+ *
+ * Правила без строковых условий компилируются в таблицу «признаки → маска»,
+ * поэтому набор требуемых документов — одно чтение таблицы; строковые правила
+ * проверяются отдельно и добавляют свои биты.
+ *
+ * Файл правил (JSON):
+ *   {"rules": [{"scope": "tourist", "when": {"domestic": false, "country": "Египет"},
+ *               "require": ["Visa"]}, ...]}
+ * scope — "tourist" или "request"; require — имена DocumentType ("Passport", ...).
+ */
+class DocumentRules {
+public:
+    enum class Scope { Tourist, Request };
+
+    /** Признаки поездки, по которым выбираются правила */
+    enum Flag : unsigned {
+        Domestic = 1u << 0,
+        VisaRequired = 1u << 1,
+        Child = 1u << 2,
+        Benefit = 1u << 3,
+        Animals = 1u << 4,
+        HasTravelMode = 1u << 5
+    };
+    static constexpr int FLAG_COUNT = 6;
+
+    struct Rule {
+        Scope scope = Scope::Tourist;
+        unsigned care = 0;   // какие признаки проверяются
+        unsigned value = 0;  // их требуемые значения
+        QString country;          // пусто — любая страна
+        QString tourTypeContains; // пусто — любой тип тура
+        QString travelMode;       // пусто — любой способ поездки
+        DocumentMask documents = 0;
+    };
+
+    /** Встроенные правила (поведение по умолчанию) */
+    static DocumentRules defaults();
+    /** Действующие правила; менять до загрузки данных, не из рабочих потоков */
+    static const DocumentRules& active();
+    static void setActive(const DocumentRules& rules);
+    /** Номер версии действующих правил: растёт при каждом setActive (сброс кэшей полноты) */
+    static std::uint64_t revision();
+
+    void addRule(const Rule& rule);
+    const std::vector<Rule>& rules() const { return rules_; }
+    /** Дополняет правила из JSON-файла; при ошибке правила не меняются */
+    bool loadFile(const QString& path, QString* err = nullptr);
+
+    DocumentMask required(Scope scope, unsigned flags, const Tour& tour, const QString& travelMode) const;
+
+    /** Имя типа в файле правил ("Passport") и обратно; false — имя неизвестно */
+    static QString typeKey(DocumentType type);
+    static bool typeFromKey(const QString& key, DocumentType* type);
+    /** Типы набора в порядке показа (паспорт, виза, ...; путёвка, страховка, билеты, ветпаспорт) */
+    static std::vector<DocumentType> typesOf(DocumentMask mask);
+
+private:
+    static constexpr int TABLE_SIZE = 1 << FLAG_COUNT;
+
+    std::vector<Rule> rules_;
+    // Скомпилированные правила без строковых условий: [scope][flags] → маска
+    std::array<std::array<DocumentMask, TABLE_SIZE>, 2> table_{};
+    // Правила со строковыми условиями, проверяются при каждом вызове
+    std::array<std::vector<Rule>, 2> conditional_;
+
+    void compile(const Rule& rule);
+};
@@ -1,47 +1,103 @@
 #include "document_service.h"
 
+#include <QtConcurrent>
+
 #include <algorithm>
+#include <numeric>
 
 #include "document.h"
 #include "tour_request.h"
 #include "tour.h"
 #include "tourist.h"
 
-std::vector<DocumentField> DocumentService::fieldsForType(DocumentType type) {
+namespace {
+
+// --- Быстрые проверки формата: прямой проход по символам вместо regex ---
+
+bool isAsciiDigit(QChar c) {
+    return c >= QLatin1Char('0') && c <= QLatin1Char('9');
+}
+
+/** Ровно N цифр */
+template <int N>
+bool digits(const QString& v) {
+    if (v.size() != N) return false;
+    for (QChar c : v)
+        if (!isAsciiDigit(c)) return false;
+    return true;
+}
+
+/** Цифры по шаблону: '0' — цифра, остальные символы должны совпасть (' ' — любой пробельный) */
+bool matchesDigitPattern(const QString& v, const char* pattern) {
+    int i = 0;
+    for (; pattern[i]; ++i) {
+        if (i >= v.size()) return false;
+        const QChar c = v[i];
+        if (pattern[i] == '0') { if (!isAsciiDigit(c)) return false; }
+        else if (pattern[i] == ' ') { if (!c.isSpace()) return false; }
+        else if (c != QLatin1Char(pattern[i])) return false;
+    }
+    return i == v.size();
+}
+
+bool issuerCodeShape(const QString& v) { return matchesDigitPattern(v, "000-000"); }
+bool snilsShape(const QString& v) { return matchesDigitPattern(v, "000-000-000 00"); }
+
+/** Цифры значения по порядку (разделители пропускаются) */
+std::vector<int> digitValues(const QString& v) {
+    std::vector<int> out;
+    out.reserve(v.size());
+    for (QChar c : v)
+        if (isAsciiDigit(c)) out.push_back(c.unicode() - '0');
+    return out;
+}
+
+/** Необязательное поле даты: хранится как QDate, в JSON — строкой ISO */
+DocumentField dateField(const char* key, const char* label) {
+    DocumentField field{key, label, QRegularExpression(), "", false, ""};
+    field.kind = DocumentField::Kind::Date;
+    return field;
+}
+
+std::vector<DocumentField> buildFields(DocumentType type) {
     switch (type) {
     case DocumentType::Passport:
         return {
-            {"series", "Серия", QRegularExpression("^\\d{4}$"), "0000", true, "0000"},
-            {"number", "Номер", QRegularExpression("^\\d{6}$"), "000000", true, "000000"},
-            {"issueDate", "Дата выдачи", QRegularExpression(), "", false, ""},
+            {"series", "Серия", QRegularExpression("^\\d{4}$"), "0000", true, "0000", &digits<4>},
+            {"number", "Номер", QRegularExpression("^\\d{6}$"), "000000", true, "000000", &digits<6>},
+            dateField("issueDate", "Дата выдачи"),
             {"issuedBy", "Кем выдан", QRegularExpression(), "", false, ""},
-            {"issuerCode", "Код подразделения", QRegularExpression("^\\d{3}-\\d{3}$"), "000-000", false, "000-000"}
+            {"issuerCode", "Код подразделения", QRegularExpression("^\\d{3}-\\d{3}$"), "000-000", false, "000-000",
+             &issuerCodeShape}
         };
     case DocumentType::InternationalPassport:
-        return {{"number", "Номер", QRegularExpression("^\\d{9}$"), "000000000", true, "000000000"}};
+        return {{"number", "Номер", QRegularExpression("^\\d{9}$"), "000000000", true, "000000000", &digits<9>}};
     case DocumentType::BirthCertificate:
         return {
             {"series", "Серия", QRegularExpression("^[IVX]{1,4}-?[А-ЯЁ]{2}$"), "", true, "IV-АР"},
-            {"number", "Номер", QRegularExpression("^\\d{6}$"), "000000", true, "123456"}
+            {"number", "Номер", QRegularExpression("^\\d{6}$"), "000000", true, "123456", &digits<6>}
         };
     case DocumentType::OMSPolicy:
-        return {{"number", "Номер полиса", QRegularExpression("^\\d{16}$"), "0000 0000 0000 0000", true, "0000 0000 0000 0000"}};
+        return {{"number", "Номер полиса", QRegularExpression("^\\d{16}$"), "0000 0000 0000 0000", true, "0000 0000 0000 0000",
+                 &digits<16>, &DocumentService::isValidOms}};
     case DocumentType::SNILS:
-        return {{"snils", "СНИЛС", QRegularExpression("^\\d{3}-\\d{3}-\\d{3}\\s\\d{2}$"), "000-000-000 00", true, "000-000-000 00"}};
+        return {{"snils", "СНИЛС", QRegularExpression("^\\d{3}-\\d{3}-\\d{3}\\s\\d{2}$"), "000-000-000 00", true, "000-000-000 00",
+                 &snilsShape, &DocumentService::isValidSnils}};
     case DocumentType::INN:
-        return {{"inn", "ИНН", QRegularExpression("^\\d{12}$"), "000000000000", false, "000000000000"}};
+        return {{"inn", "ИНН", QRegularExpression("^\\d{12}$"), "000000000000", false, "000000000000",
+                 &digits<12>, &DocumentService::isValidInn}};
     case DocumentType::Visa:
         return {
             {"visaNumber", "Номер визы", QRegularExpression("^[A-Z0-9]{6,12}$"), "", true, "A1B2C3"},
-            {"validFrom", "Действует с", QRegularExpression(), "", false, ""},
-            {"validTo", "Действует до", QRegularExpression(), "", false, ""}
+            dateField("validFrom", "Действует с"),
+            dateField("validTo", "Действует до")
         };
     case DocumentType::InsurancePolicy:
         return {
             {"policyNumber", "Номер полиса", QRegularExpression("^[A-Z0-9-]{6,20}$"), "", true, "ABC-123"},
             {"company", "Компания", QRegularExpression(), "", false, ""},
-            {"validFrom", "Действует с", QRegularExpression(), "", false, ""},
-            {"validTo", "Действует до", QRegularExpression(), "", false, ""}
+            dateField("validFrom", "Действует с"),
+            dateField("validTo", "Действует до")
         };
     case DocumentType::BenefitDocument:
         return {
@@ -58,122 +114,229 @@ std::vector<DocumentField> DocumentService::fieldsForType(DocumentType type) {
     case DocumentType::ConsentForChildDeparture:
         return {
             {"docNumber", "Номер документа", QRegularExpression("^[A-ZА-Я0-9-]{1,20}$"), "", true, ""},
-            {"docDate", "Дата документа", QRegularExpression(), "", false, ""}
+            dateField("docDate", "Дата документа")
         };
     case DocumentType::VeterinaryPassport:
         return {
             {"vetPassportNumber", "Номер ветпаспорта", QRegularExpression("^[A-ZА-Я0-9-]{1,20}$"), "", true, ""},
-            {"vaccinationDate", "Дата вакцинации", QRegularExpression(), "", false, ""}
+            dateField("vaccinationDate", "Дата вакцинации")
         };
     }
     return {};
 }
 
-static QString normalizedField(const QVariantMap& fields, const QString& key) {
-    return fields.value(key).toString().trimmed();
+} // namespace
+
+const std::vector<DocumentField>& DocumentService::fieldsForType(DocumentType type) {
+    // Реестр строится один раз при первом обращении (инициализация static
+    // потокобезопасна), выражения компилируются сразу, а не при первом match()
+    static const std::vector<std::vector<DocumentField>> registry = [] {
+        std::vector<std::vector<DocumentField>> all;
+        all.reserve(DOCUMENT_TYPE_COUNT);
+        for (int t = 0; t < DOCUMENT_TYPE_COUNT; ++t) {
+            all.push_back(buildFields(static_cast<DocumentType>(t)));
+            for (DocumentField& field : all.back()) {
+                if (!field.regex.pattern().isEmpty()) field.regex.optimize();
+            }
+        }
+        return all;
+    }();
+    static const std::vector<DocumentField> none;
+    const int index = static_cast<int>(type);
+    return index >= 0 && index < DOCUMENT_TYPE_COUNT ? registry[index] : none;
+}
+
+int DocumentService::fieldIndex(DocumentType type, const QString& key) {
+    const auto& defs = fieldsForType(type);
+    for (size_t i = 0; i < defs.size(); ++i)
+        if (defs[i].key == key) return static_cast<int>(i);
+    return -1;
+}
+
+bool DocumentService::validateFieldValue(const DocumentField& field, const QString& value, QString* err) {
+    if (value.isEmpty()) return true;
+    bool shapeOk = true;
+    if (field.shape) {
+        shapeOk = field.shape(value);
+    } else if (field.regex.isValid() && !field.regex.pattern().isEmpty()) {
+        // Свободные поля (визы, ваучеры, билеты) по-прежнему проверяются regex
+        shapeOk = field.regex.match(value).hasMatch();
+    }
+    if (!shapeOk) {
+        if (err) *err = QString("Поле '%1' имеет неверный формат").arg(field.label);
+        return false;
+    }
+    if (field.checksum && !field.checksum(value)) {
+        if (err) *err = QString("Поле '%1': неверная контрольная сумма").arg(field.label);
+        return false;
+    }
+    return true;
 }
 
 bool DocumentService::isMinimumFilled(const Document& document) {
-    const auto defs = fieldsForType(document.getType());
-    for (const auto& def : defs) {
+    const auto& defs = fieldsForType(document.getType());
+    for (size_t i = 0; i < defs.size(); ++i) {
+        const DocumentField& def = defs[i];
         if (!def.required) continue;
-        const QString value = normalizedField(document.fields(), def.key);
-        if (value.isEmpty()) return false;
-        if (def.regex.isValid() && !def.regex.pattern().isEmpty() && !def.regex.match(value).hasMatch())
-            return false;
+        const QString value = document.valueAt(static_cast<int>(i)).trimmed();
+        if (value.isEmpty() || !validateFieldValue(def, value)) return false;
     }
     return true;
 }
 
 bool DocumentService::validateDocument(const Document& document, QString* err) {
-    const auto defs = fieldsForType(document.getType());
-    for (const auto& def : defs) {
-        const QString value = normalizedField(document.fields(), def.key);
+    const auto& defs = fieldsForType(document.getType());
+    for (size_t i = 0; i < defs.size(); ++i) {
+        const DocumentField& def = defs[i];
+        const QString value = document.valueAt(static_cast<int>(i)).trimmed();
         if (def.required && value.isEmpty()) {
             if (err) *err = QString("Поле '%1' обязательно").arg(def.label);
             return false;
         }
-        if (!value.isEmpty() && def.regex.isValid() && !def.regex.pattern().isEmpty()
-            && !def.regex.match(value).hasMatch()) {
-            if (err) *err = QString("Поле '%1' имеет неверный формат").arg(def.label);
-            return false;
-        }
+        if (!validateFieldValue(def, value, err)) return false;
     }
     return true;
 }
 
-std::vector<DocumentType> DocumentService::requiredPersonalDocuments(const TourRequest& request, const Tourist& tourist) {
-    std::vector<DocumentType> out;
-    const bool domestic = request.getTour()->isDomestic();
-    const bool visaRequired = request.getTour()->isVisaRequired();
-
-    if (domestic) {
-        out.push_back(tourist.isChild() ? DocumentType::BirthCertificate : DocumentType::Passport);
-        out.push_back(DocumentType::OMSPolicy);
-        if (tourist.hasBenefit())
-            out.push_back(DocumentType::BenefitDocument);
+std::vector<QString> DocumentService::validateDocuments(const std::vector<const Document*>& documents) {
+    const int count = static_cast<int>(documents.size());
+    std::vector<QString> out(count);
+    // Каждый элемент пишет только в свою ячейку, реестр полей неизменяем
+    auto check = [&](int i) {
+        if (documents[i]) validateDocument(*documents[i], &out[i]);
+    };
+    if (count < PARALLEL_VALIDATE_MIN) {
+        for (int i = 0; i < count; ++i) check(i);
     } else {
-        out.push_back(DocumentType::InternationalPassport);
-        if (visaRequired) out.push_back(DocumentType::Visa);
-        if (tourist.isChild()) {
-            out.push_back(DocumentType::BirthCertificate);
-            out.push_back(DocumentType::ConsentForChildDeparture);
-        }
-        if (tourist.hasBenefit())
-            out.push_back(DocumentType::BenefitDocument);
+        std::vector<int> indices(count);
+        std::iota(indices.begin(), indices.end(), 0);
+        QtConcurrent::blockingMap(indices, check);
     }
-
     return out;
 }
 
-std::vector<DocumentType> DocumentService::requiredRequestDocuments(const TourRequest& request) {
-    std::vector<DocumentType> out;
+bool DocumentService::isValidSnils(const QString& value) {
+    const std::vector<int> d = digitValues(value);
+    if (d.size() != 11) return false;
+    int number = 0;
+    for (int i = 0; i < 9; ++i) number = number * 10 + d[i];
+    // Номера до 001-001-998 выданы без контрольного числа
+    if (number <= 1001998) return true;
+    int sum = 0;
+    for (int i = 0; i < 9; ++i) sum += d[i] * (9 - i);
+    int control = sum;
+    if (sum >= 100) control = sum % 101 == 100 ? 0 : sum % 101;
+    return control == d[9] * 10 + d[10];
+}
 
-    if (!request.getTour()->isDomestic()) {
-        out.push_back(DocumentType::Voucher);
-        out.push_back(DocumentType::InsurancePolicy);
-    } else {
-        if (request.getTour()->getTourType().toLower().contains("актив"))
-            out.push_back(DocumentType::InsurancePolicy);
+bool DocumentService::isValidInn(const QString& value) {
+    static constexpr int W11[] = {7, 2, 4, 10, 3, 5, 9, 4, 6, 8};
+    static constexpr int W12[] = {3, 7, 2, 4, 10, 3, 5, 9, 4, 6, 8};
+    const std::vector<int> d = digitValues(value);
+    if (d.size() != 12 || d.size() != static_cast<size_t>(value.size())) return false;
+    int s11 = 0, s12 = 0;
+    for (int i = 0; i < 10; ++i) s11 += d[i] * W11[i];
+    for (int i = 0; i < 11; ++i) s12 += d[i] * W12[i];
+    return s11 % 11 % 10 == d[10] && s12 % 11 % 10 == d[11];
+}
+
+bool DocumentService::isValidOms(const QString& value) {
+    const std::vector<int> d = digitValues(value);
+    if (d.size() != 16 || d.size() != static_cast<size_t>(value.size())) return false;
+    // Полис единого образца: цифры на нечётных (справа) местах первых 15 как
+    // число умножаются на 2, к ним приписываются цифры чётных мест; контрольная
+    // цифра дополняет сумму всех цифр результата до кратной 10
+    QString odd, even;
+    for (int i = 14; i >= 0; --i) {
+        const int fromRight = 15 - i;  // 1 — последняя из 15
+        (fromRight % 2 ? odd : even).prepend(QChar('0' + d[i]));
     }
+    qulonglong doubled = odd.toULongLong() * 2;
+    const QString combined = even + QString::number(doubled);
+    int sum = 0;
+    for (QChar c : combined) sum += c.unicode() - '0';
+    return (10 - sum % 10) % 10 == d[15];
+}
 
-    if (!request.getTravelMode().trimmed().isEmpty())
-        out.push_back(DocumentType::Tickets);
+namespace {
 
-    if (!request.getAnimals().empty())
-        out.push_back(DocumentType::VeterinaryPassport);
+unsigned requestFlags(const TourRequest& request) {
+    unsigned flags = 0;
+    if (request.getTour()->isDomestic()) flags |= DocumentRules::Domestic;
+    if (request.getTour()->isVisaRequired()) flags |= DocumentRules::VisaRequired;
+    if (!request.getAnimals().empty()) flags |= DocumentRules::Animals;
+    if (!request.getTravelMode().trimmed().isEmpty()) flags |= DocumentRules::HasTravelMode;
+    return flags;
+}
 
-    return out;
+unsigned touristFlags(const Tourist& tourist) {
+    unsigned flags = 0;
+    if (tourist.isChild()) flags |= DocumentRules::Child;
+    if (tourist.hasBenefit()) flags |= DocumentRules::Benefit;
+    return flags;
 }
 
-QStringList DocumentService::missingDocumentsSummary(const TourRequest& request) {
-    QStringList missing;
+} // namespace
 
-    for (const auto& t : request.getTourists()) {
-        auto required = requiredPersonalDocuments(request, *t);
-        for (const auto& docType : required) {
-            bool found = false;
-            for (const auto& doc : t->documents()) {
-                if (doc->getType() == docType && doc->getStatus() == DocumentStatus::Verified) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) missing << QString("%1: %2").arg(t->getFullName(), Document::typeName(docType));
-        }
-    }
+DocumentMask DocumentService::requiredPersonalMask(const TourRequest& request, const Tourist& tourist) {
+    return DocumentRules::active().required(DocumentRules::Scope::Tourist,
+                                            requestFlags(request) | touristFlags(tourist),
+                                            *request.getTour(), request.getTravelMode());
+}
 
-    auto requestRequired = requiredRequestDocuments(request);
-    for (const auto& docType : requestRequired) {
-        bool found = false;
-        for (const auto& doc : request.getDocuments()) {
-            if (doc->getType() == docType && doc->getStatus() == DocumentStatus::Verified) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) missing << QString("Заявка: %1").arg(Document::typeName(docType));
+DocumentMask DocumentService::requiredRequestMask(const TourRequest& request) {
+    return DocumentRules::active().required(DocumentRules::Scope::Request, requestFlags(request),
+                                            *request.getTour(), request.getTravelMode());
+}
+
+std::vector<DocumentType> DocumentService::requiredPersonalDocuments(const TourRequest& request, const Tourist& tourist) {
+    return DocumentRules::typesOf(requiredPersonalMask(request, tourist));
+}
+
+std::vector<DocumentType> DocumentService::requiredRequestDocuments(const TourRequest& request) {
+    return DocumentRules::typesOf(requiredRequestMask(request));
+}
+
+DocumentMask DocumentService::statusMask(const std::vector<std::unique_ptr<Document>>& documents,
+                                         DocumentStatus status) {
+    DocumentMask mask = 0;
+    for (const auto& doc : documents)
+        if (doc->getStatus() == status) mask |= documentBit(doc->getType());
+    return mask;
+}
+
+void DocumentService::missingDocuments(const TourRequest& request, std::vector<DocumentMask>* byTourist,
+                                       DocumentMask* requestLevel) {
+    // Недостающее — требуемое минус проверенное; только константный доступ,
+    // чтобы не отметить заявку изменённой
+    const unsigned flags = requestFlags(request);
+    const DocumentRules& rules = DocumentRules::active();
+    const auto& tourists = request.getTourists();
+    byTourist->assign(tourists.size(), 0);
+    for (size_t i = 0; i < tourists.size(); ++i) {
+        const Tourist& t = *tourists[i];
+        const DocumentMask required = rules.required(DocumentRules::Scope::Tourist, flags | touristFlags(t),
+                                                     *request.getTour(), request.getTravelMode());
+        (*byTourist)[i] = required & ~verifiedMask(t.documents());
     }
+    *requestLevel = requiredRequestMask(request) & ~verifiedMask(request.getDocuments());
+}
 
+QStringList DocumentService::formatMissing(const TourRequest& request, const std::vector<DocumentMask>& byTourist,
+                                           DocumentMask requestLevel) {
+    QStringList missing;
+    const auto& tourists = request.getTourists();
+    for (size_t i = 0; i < byTourist.size() && i < tourists.size(); ++i) {
+        if (!byTourist[i]) continue;
+        const QString name = tourists[i]->getFullName();
+        for (DocumentType type : DocumentRules::typesOf(byTourist[i]))
+            missing << QString("%1: %2").arg(name, Document::typeName(type));
+    }
+    for (DocumentType type : DocumentRules::typesOf(requestLevel))
+        missing << QString("Заявка: %1").arg(Document::typeName(type));
     return missing;
 }
+
+QStringList DocumentService::missingDocumentsSummary(const TourRequest& request) {
+    return request.missingDocumentsSummary();
+}
@@ -5,14 +5,19 @@
 #include <QString>
 #include <QStringList>
 #include <QVariantMap>
+#include <memory>
 #include <vector>
 
 #include "agency_types.h"
+#include "document_rules.h"
 
 class Document;
 class TourRequest;
 class Tourist;
 
+/** Проверка значения поля без регулярного выражения */
+using FieldCheck = bool (*)(const QString& value);
+
 struct DocumentField {
     QString key;
     QString label;
@@ -20,16 +25,53 @@ struct DocumentField {
     QString inputMask;
     bool required = true;
     QString placeholder;
+    FieldCheck shape = nullptr;     // быстрая проверка формата; без неё — regex
+    FieldCheck checksum = nullptr;  // контрольное число (СНИЛС, ИНН, полис ОМС)
+    enum class Kind { Text, Date };
+    Kind kind = Kind::Text;         // даты хранятся в Document как QDate
 };
 
 class DocumentService {
 public:
-    static std::vector<DocumentField> fieldsForType(DocumentType type);
+    /** Поля типа документа из реестра, построенного один раз; ссылка действительна всегда */
+    static const std::vector<DocumentField>& fieldsForType(DocumentType type);
+    /** Номер поля key в fieldsForType(type); -1 — такого поля у типа нет */
+    static int fieldIndex(DocumentType type, const QString& key);
     static bool validateDocument(const Document& document, QString* err = nullptr);
+    /**
+     * Пакетная проверка: результат по каждому документу в том же порядке,
+     * пустая строка — документ верен. Большие пакеты проверяются параллельно.
+     */
+    static std::vector<QString> validateDocuments(const std::vector<const Document*>& documents);
+    /** Проверка одного значения (формат и контрольное число); пустое значение не проверяется */
+    static bool validateFieldValue(const DocumentField& field, const QString& value, QString* err = nullptr);
+
+    // Контрольные числа; на вход — только цифры (и разделители для СНИЛС)
+    static bool isValidSnils(const QString& value);
+    static bool isValidInn(const QString& value);
+    static bool isValidOms(const QString& value);
     static bool isMinimumFilled(const Document& document);
 
+    // Требования берутся из DocumentRules::active()
     static std::vector<DocumentType> requiredPersonalDocuments(const TourRequest& request, const Tourist& tourist);
     static std::vector<DocumentType> requiredRequestDocuments(const TourRequest& request);
+    static DocumentMask requiredPersonalMask(const TourRequest& request, const Tourist& tourist);
+    static DocumentMask requiredRequestMask(const TourRequest& request);
+    /** Типы документов с указанным статусом */
+    static DocumentMask statusMask(const std::vector<std::unique_ptr<Document>>& documents, DocumentStatus status);
+    static DocumentMask verifiedMask(const std::vector<std::unique_ptr<Document>>& documents) {
+        return statusMask(documents, DocumentStatus::Verified);
+    }
 
+    /** Недостающие (требуемые и не проверенные) типы: по туристам в их порядке и по заявке */
+    static void missingDocuments(const TourRequest& request, std::vector<DocumentMask>* byTourist,
+                                 DocumentMask* requestLevel);
+    /** Текст по недостающим типам, найденным missingDocuments */
+    static QStringList formatMissing(const TourRequest& request, const std::vector<DocumentMask>& byTourist,
+                                     DocumentMask requestLevel);
+    /** То же, что TourRequest::missingDocumentsSummary (берётся из кэша заявки) */
     static QStringList missingDocumentsSummary(const TourRequest& request);
+
+private:
+    static constexpr int PARALLEL_VALIDATE_MIN = 256;  // меньше документов — в одном потоке
 };
@@ -84,8 +84,7 @@ Tourist* DocumentsDialog::currentTourist() const {
     if (!request_) return nullptr;
     const int idx = ownerCombo_->currentData().toInt();
     if (idx < 0) return nullptr;
-    if (idx >= (int)request_->getTourists().size()) return nullptr;
-    return request_->tourists()[idx].get();
+    return request_->tourist(idx);
 }
 
 Document* DocumentsDialog::currentDocument() const {
@@ -97,8 +96,7 @@ Document* DocumentsDialog::currentDocument() const {
         return tourist->documents()[row].get();
     }
     if (!request_) return nullptr;
-    if (row >= (int)request_->documents().size()) return nullptr;
-    return request_->documents()[row].get();
+    return request_->getDocument(row);
 }
 
 void DocumentsDialog::refreshDocumentList() {
@@ -109,7 +107,7 @@ void DocumentsDialog::refreshDocumentList() {
             docList_->addItem(doc->displayName() + " — " + Document::statusName(doc->getStatus()));
         }
     } else if (request_) {
-        for (const auto& doc : request_->documents()) {
+        for (const auto& doc : request_->getDocuments()) {
             docList_->addItem(doc->displayName() + " — " + Document::statusName(doc->getStatus()));
         }
     }
@@ -174,22 +172,23 @@ void DocumentsDialog::rebuildForm(Document* document) {
         return;
     }
 
-    const auto fields = DocumentService::fieldsForType(document->getType());
+    const auto& fields = DocumentService::fieldsForType(document->getType());
     for (const auto& def : fields) {
         auto* editorContainer = new QWidget(this);
         auto* editorLayout = new QVBoxLayout(editorContainer);
         editorLayout->setContentsMargins(0, 0, 0, 0);
 
         QWidget* editor = nullptr;
-        if (def.key.contains("Date")) {
+        if (def.kind == DocumentField::Kind::Date) {
             auto* dateEdit = new QDateEdit(this);
             dateEdit->setCalendarPopup(true);
-            const QString existing = document->fields().value(def.key).toString();
-            if (!existing.isEmpty())
-                dateEdit->setDate(QDate::fromString(existing, Qt::ISODate));
+            const QDate existing = document->date(def.key);
+            if (existing.isValid())
+                dateEdit->setDate(existing);
             editor = dateEdit;
-            connect(dateEdit, &QDateEdit::dateChanged, this, [this, document, def](const QDate& date) {
-                document->fields()[def.key] = date.toString(Qt::ISODate);
+            // def — элемент реестра DocumentService, живёт до конца программы
+            connect(dateEdit, &QDateEdit::dateChanged, this, [this, document, &def](const QDate& date) {
+                document->setDate(def.key, date);
                 updateDocumentStatus(document);
                 updateErrorState(def.key, true, "");
             });
@@ -201,10 +200,10 @@ void DocumentsDialog::rebuildForm(Document* document) {
                 line->setValidator(new QRegularExpressionValidator(def.regex, line));
             }
             line->setPlaceholderText(def.placeholder);
-            const QString existing = document->fields().value(def.key).toString();
+            const QString existing = document->field(def.key).toString();
             line->setText(existing);
             editor = line;
-            connect(line, &QLineEdit::textChanged, this, [this, document, def, line](const QString& text) {
+            connect(line, &QLineEdit::textChanged, this, [this, document, &def, line](const QString& text) {
                 const bool hasMask = !def.inputMask.isEmpty();
                 QString normalized = hasMask ? text : normalizeInput(text, def);
                 if (hasMask && def.regex.pattern() == "^\\d{16}$") {
@@ -214,18 +213,18 @@ void DocumentsDialog::rebuildForm(Document* document) {
                     QSignalBlocker blocker(line);
                     line->setText(normalized);
                 }
-                document->fields()[def.key] = normalized;
+                document->setField(def.key, normalized);
                 bool ok = true;
                 QString error;
                 const QString valueForCheck = normalized;
                 if (def.required && valueForCheck.trimmed().isEmpty()) {
                     ok = false;
                     error = "Обязательное поле";
-                } else if (!valueForCheck.trimmed().isEmpty() && def.regex.isValid()
-                           && !def.regex.pattern().isEmpty()
-                           && !def.regex.match(valueForCheck).hasMatch()) {
+                } else if (!DocumentService::validateFieldValue(def, valueForCheck.trimmed())) {
                     ok = false;
-                    error = "Неверный формат";
+                    error = def.checksum && (!def.shape || def.shape(valueForCheck.trimmed()))
+                                ? "Неверная контрольная сумма"
+                                : "Неверный формат";
                 }
                 updateErrorState(def.key, ok, error);
                 updateDocumentStatus(document);
@@ -286,13 +285,13 @@ void DocumentsDialog::onAddDocument() {
         }
         tourist->documents().push_back(std::move(doc));
     } else {
-        for (const auto& existing : request_->documents()) {
+        for (const auto& existing : request_->getDocuments()) {
             if (existing->getType() == chosen) {
                 QMessageBox::information(this, "Документы", "Этот документ уже добавлен.");
                 return;
             }
         }
-        request_->documents().push_back(std::move(doc));
+        request_->addDocument(std::move(doc));
     }
     refreshDocumentList();
 }
@@ -310,8 +309,7 @@ void DocumentsDialog::onRemoveDocument() {
         if (row >= 0 && row < (int)tourist->documents().size())
             tourist->documents().erase(tourist->documents().begin() + row);
     } else if (request_) {
-        if (row >= 0 && row < (int)request_->documents().size())
-            request_->documents().erase(request_->documents().begin() + row);
+        request_->removeDocument(row);
     }
     refreshDocumentList();
 }
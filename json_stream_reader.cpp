@@ -0,0 +1,162 @@
+#include "json_stream_reader.h"
+
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+JsonStreamReader::JsonStreamReader(QIODevice* device)
+    : device_(device), bufferOffset_(device->pos()) {}
+
+bool JsonStreamReader::fill() {
+    if (capture_) {
+        capture_->append(buf_.constData() + captureStart_, pos_ - captureStart_);
+        captureStart_ = 0;
+    }
+    bufferOffset_ += buf_.size();
+    buf_ = device_->read(CHUNK_SIZE);
+    pos_ = 0;
+    return !buf_.isEmpty();
+}
+
+int JsonStreamReader::peekByte() {
+    if (pos_ >= buf_.size() && !fill()) return -1;
+    return static_cast<unsigned char>(buf_.at(pos_));
+}
+
+int JsonStreamReader::getByte() {
+    if (pos_ >= buf_.size() && !fill()) return -1;
+    return static_cast<unsigned char>(buf_.at(pos_++));
+}
+
+void JsonStreamReader::skipWhitespace() {
+    for (int ch = peekByte(); ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t'; ch = peekByte())
+        ++pos_;
+}
+
+bool JsonStreamReader::fail(const QString& message) {
+    if (error_.isEmpty())
+        error_ = QString("%1 (позиция %2)").arg(message).arg(position());
+    return false;
+}
+
+bool JsonStreamReader::expect(char ch) {
+    skipWhitespace();
+    const int got = getByte();
+    if (got == ch) return true;
+    return fail(got < 0 ? QString("Неожиданный конец файла")
+                        : QString("Ожидался символ '%1'").arg(QLatin1Char(ch)));
+}
+
+bool JsonStreamReader::scanString() {
+    // Открывающая кавычка уже прочитана
+    bool escape = false;
+    for (;;) {
+        const int ch = getByte();
+        if (ch < 0) return fail("Незакрытая строка");
+        if (escape) escape = false;
+        else if (ch == '\\') escape = true;
+        else if (ch == '"') return true;
+    }
+}
+
+bool JsonStreamReader::scanValue() {
+    skipWhitespace();
+    const int first = getByte();
+    if (first < 0) return fail("Неожиданный конец файла");
+    if (first == ',' || first == '}' || first == ']' || first == ':') return fail("Ожидалось значение");
+    if (first == '"') return scanString();
+    if (first == '{' || first == '[') {
+        int depth = 1;
+        while (depth > 0) {
+            const int ch = getByte();
+            if (ch < 0) return fail("Неожиданный конец файла");
+            if (ch == '"') { if (!scanString()) return false; }
+            else if (ch == '{' || ch == '[') ++depth;
+            else if (ch == '}' || ch == ']') --depth;
+        }
+        return true;
+    }
+    // Число, true/false/null — до разделителя
+    for (int ch = peekByte(); ch >= 0; ch = peekByte()) {
+        if (ch == ',' || ch == '}' || ch == ']' || ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t')
+            break;
+        ++pos_;
+    }
+    return true;
+}
+
+bool JsonStreamReader::captureValue(QByteArray* out) {
+    out->clear();
+    skipWhitespace();
+    capture_ = out;
+    captureStart_ = pos_;
+    const bool ok = scanValue();
+    if (ok) out->append(buf_.constData() + captureStart_, pos_ - captureStart_);
+    capture_ = nullptr;
+    return ok;
+}
+
+/** Переход к следующему члену контейнера: после первого обязательна ',' */
+bool JsonStreamReader::nextMember(char close) {
+    skipWhitespace();
+    int ch = peekByte();
+    if (ch == close) {
+        ++pos_;
+        if (!firstMember_.empty()) firstMember_.pop_back();
+        return false;
+    }
+    if (!firstMember_.empty() && !firstMember_.back()) {
+        if (ch != ',') {
+            return fail(ch < 0 ? QString("Неожиданный конец файла")
+                               : QString("Ожидался символ ',' или '%1'").arg(QLatin1Char(close)));
+        }
+        ++pos_;
+        skipWhitespace();
+        if (peekByte() == close) return fail(QString("Лишняя ',' перед '%1'").arg(QLatin1Char(close)));
+    }
+    if (!firstMember_.empty()) firstMember_.back() = false;
+    return true;
+}
+
+bool JsonStreamReader::beginObject() {
+    if (!expect('{')) return false;
+    firstMember_.push_back(true);
+    return true;
+}
+
+bool JsonStreamReader::nextKey(QString* key) {
+    if (!nextMember('}')) return false;
+    const int ch = peekByte();
+    if (ch != '"') return fail(ch < 0 ? QString("Неожиданный конец файла") : QString("Ожидался ключ"));
+
+    QByteArray raw;
+    if (!captureValue(&raw)) return false;
+    // Ключи короткие: экранирование разбирает QJsonDocument
+    const QJsonArray wrapped = QJsonDocument::fromJson("[" + raw + "]").array();
+    if (wrapped.isEmpty()) return fail("Некорректный ключ");
+    *key = wrapped.first().toString();
+    return expect(':');
+}
+
+bool JsonStreamReader::beginArray() {
+    skipWhitespace();
+    if (peekByte() != '[') {
+        skipValue();
+        return false;
+    }
+    ++pos_;
+    firstMember_.push_back(true);
+    return true;
+}
+
+bool JsonStreamReader::nextElement(QByteArray* element) {
+    if (!nextMember(']')) return false;
+    const int ch = peekByte();
+    if (ch < 0) return fail("Неожиданный конец файла");
+    if (ch == ',') return fail("Ожидался элемент массива");
+    return captureValue(element);
+}
+
+bool JsonStreamReader::skipValue() {
+    return scanValue();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include <vector>
+
+class QIODevice;
+
+//=============================================================================
+// JsonStreamReader — потоковое чтение JSON-файла по элементам массивов
+//=============================================================================
+
+/**
+ * Читает устройство блоками и отдаёт ключи корневого объекта и «сырые» байты
+ * отдельных элементов массивов, не строя DOM всего файла. Дополнительная память
+ * ограничена размером блока и самого крупного элемента.
+ *
+ * Типичный порядок: beginObject(), затем nextKey() → beginArray() →
+ * nextElement() ... или skipValue() для ненужных значений.
+ */
+class JsonStreamReader {
+public:
+    explicit JsonStreamReader(QIODevice* device);
+
+    bool beginObject();
+    /** Следующий ключ корневого объекта; false — объект закончился или ошибка */
+    bool nextKey(QString* key);
+    /** Входит в массив; если значение не массив — пропускает его и возвращает false */
+    bool beginArray();
+    /** Байты следующего элемента массива; false — массив закончился или ошибка */
+    bool nextElement(QByteArray* element);
+    /** Байты значения после nextKey() (без разбора вложенных объектов и массивов) */
+    bool nextValue(QByteArray* value) { return captureValue(value); }
+    bool skipValue();
+
+    /** Смещение в устройстве первого ещё не прочитанного байта */
+    qint64 position() const { return bufferOffset_ + pos_; }
+    bool hasError() const { return !error_.isEmpty(); }
+    QString errorString() const { return error_; }
+
+private:
+    static constexpr int CHUNK_SIZE = 64 * 1024;
+
+    QIODevice* device_;
+    QByteArray buf_;
+    int pos_ = 0;
+    qint64 bufferOffset_ = 0;
+    // Захват значения: байты, вытесняемые из буфера, дописываются сюда
+    QByteArray* capture_ = nullptr;
+    int captureStart_ = 0;
+    // Открытые контейнеры: true — ещё не прочитано ни одного члена
+    std::vector<bool> firstMember_;
+    QString error_;
+
+    bool fill();
+    int peekByte();
+    int getByte();
+    void skipWhitespace();
+    bool expect(char ch);
+    bool nextMember(char close);
+    bool scanValue();
+    bool scanString();
+    bool captureValue(QByteArray* out);
+    bool fail(const QString& message);
+};
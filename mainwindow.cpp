@@ -11,19 +11,62 @@
 #include <QDialog>
 #include <QDialogButtonBox>
 #include <QLineEdit>
-#include <QTableWidget>
+#include <QLabel>
+#include <QTableView>
 #include <QVBoxLayout>
 #include <QAbstractItemView>
 #include <QToolButton>
 #include <QRegularExpressionValidator>
+#include <QtConcurrent>
+#include <QFile>
+#include <QApplication>
+#include <QDir>
+#include <QProgressBar>
+#include <QStandardPaths>
+#include <QTimer>
 
+#include <memory>
+#include <utility>
+
+#include "agency_table_models.h"
+#include "combo_completer.h"
+#include "document_audit_dialog.h"
 #include "documents_dialog.h"
 #include "validation_service.h"
 #include "document_service.h"
 #include "request_service.h"
+#include "search_controller.h"
 #include "client_service.h"
 // Для режима редактирования клиента/тура (0 = добавление)
 static const int NO_EDIT_ID = 0;
+// Рабочее хранилище: снимок + журнал изменений (см. TravelAgency::openStore)
+static const char* const STORE_FILE = "agency_store.snap";
+// Дополнительные правила обязательных документов (см. DocumentRules), если файл есть
+static const char* const RULES_FILE = "document_rules.json";
+// Поиск туров в окне выбора проверяет отмену раз в столько строк
+static const int SEARCH_CANCEL_CHECK = 1024;
+// Загруженные данные подменяются, когда закрыто модальное окно; проверка раз в столько мс
+static const int LOAD_APPLY_RETRY_MS = 200;
+// Сжатие хранилища тоже ждёт закрытия модального окна (оно может править данные)
+static const int COMPACT_RETRY_MS = 200;
+// Списки клиентов и туров новой заявки подгружают строки порциями такого размера
+static const int COMBO_PAGE_SIZE = 100;
+
+// Служебные файлы лежат рядом с программой, а не в текущем каталоге
+static QString besideApplication(const char* fileName) {
+    return QDir(QCoreApplication::applicationDirPath()).filePath(fileName);
+}
+
+// Хранилище пишется постоянно, а каталог установленной программы обычно только
+// для чтения: файл лежит в каталоге данных пользователя; пусто — каталог не создан
+static QString inAppDataDir(const char* fileName, QString* err) {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty() || !QDir().mkpath(dir)) {
+        *err = "Не удалось создать каталог данных " + dir;
+        return QString();
+    }
+    return QDir(dir).filePath(fileName);
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -31,15 +74,64 @@ MainWindow::MainWindow(QWidget *parent)
 
     ui->setupUi(this);
 
-    // --- Заголовки таблиц ---
-    ui->clientsTable->setHorizontalHeaderLabels({"ID", "ФИО", "Телефон", "Email", "Дата рождения", "Комментарии"});
+    // --- Таблицы: модели читают данные агентства, текст ячеек — только для видимых строк ---
+    clientsModel_ = new ClientTableModel(agency_, this);
+    ui->clientsTable->setModel(clientsModel_);
     ui->clientsTable->horizontalHeader()->setStretchLastSection(true);
 
-    ui->toursTable->setHorizontalHeaderLabels({"ID", "Название", "Страна", "Тип", "Начало", "Дней", "Цена", "Внутр.", "Виза"});
+    toursModel_ = new TourTableModel(agency_, this);
+    ui->toursTable->setModel(toursModel_);
     ui->toursTable->horizontalHeader()->setStretchLastSection(true);
 
-    ui->requestsTable->setHorizontalHeaderLabels({"ID", "Клиент", "Тур", "Статус", "Стоимость"});
+    requestsModel_ = new RequestTableModel(agency_, this);
+    ui->requestsTable->setModel(requestsModel_);
     ui->requestsTable->horizontalHeader()->setStretchLastSection(true);
+    // Итоги по статусам обновляются вместе со строками заявок
+    connect(requestsModel_, &QAbstractItemModel::dataChanged, this, &MainWindow::refreshRevenueLabel);
+    connect(requestsModel_, &QAbstractItemModel::rowsInserted, this, &MainWindow::refreshRevenueLabel);
+    connect(requestsModel_, &QAbstractItemModel::rowsRemoved, this, &MainWindow::refreshRevenueLabel);
+    connect(requestsModel_, &QAbstractItemModel::modelReset, this, &MainWindow::refreshRevenueLabel);
+
+    // --- Списки новой заявки: модели над агентством, подсказки при вводе ---
+    clientComboModel_ = new ClientTableModel(agency_, this);
+    clientComboModel_->setPageSize(COMBO_PAGE_SIZE);
+    ui->newRequestClientCombo->setModel(clientComboModel_);
+    ui->newRequestClientCombo->setModelColumn(1);  // ФИО
+    auto* clientCompleter = new ComboCompleter(ui->newRequestClientCombo,
+        [this](const QString& text) {
+            std::vector<int> ids;
+            for (const Client* c : agency_.searchClients(text)) ids.push_back(c->getId());
+            return ids;
+        },
+        [this](int id) {
+            const Client* c = agency_.findClientById(id);
+            return c ? QString("%1, %2").arg(c->getFullName(), c->getPhone()) : QString();
+        });
+    connect(clientCompleter, &ComboCompleter::picked, this, [this](int id) {
+        selectComboItem(ui->newRequestClientCombo, clientComboModel_, id);
+    });
+
+    tourComboModel_ = new TourTableModel(agency_, this);
+    tourComboModel_->setPageSize(COMBO_PAGE_SIZE);
+    ui->newRequestTourCombo->setModel(tourComboModel_);
+    ui->newRequestTourCombo->setModelColumn(1);  // название
+    auto* tourCompleter = new ComboCompleter(ui->newRequestTourCombo,
+        [this](const QString& text) {
+            std::vector<int> ids;
+            for (const Tour* t : agency_.tours())
+                if (t->getName().contains(text, Qt::CaseInsensitive) || t->getCountry().contains(text, Qt::CaseInsensitive))
+                    ids.push_back(t->getId());
+            return ids;
+        },
+        [this](int id) {
+            const Tour* t = agency_.findTourById(id);
+            return t ? QString("%1 (%2, %3)").arg(t->getName(), t->getCountry(),
+                                                   t->getStartDate().toString("dd.MM.yyyy"))
+                     : QString();
+        });
+    connect(tourCompleter, &ComboCompleter::picked, this, [this](int id) {
+        selectComboItem(ui->newRequestTourCombo, tourComboModel_, id);
+    });
 
     // --- Типы туров ---
     ui->tourType->addItems({
@@ -136,6 +228,7 @@ MainWindow::MainWindow(QWidget *parent)
     // --- Заявки ---
     connect(ui->createRequestButton, &QPushButton::clicked, this, &MainWindow::onCreateRequest);
     connect(ui->deleteRequestButton, &QPushButton::clicked, this, &MainWindow::onDeleteRequest);
+    connect(ui->documentAuditButton, &QPushButton::clicked, this, &MainWindow::onDocumentAudit);
     connect(ui->newRequestClientSearchButton, &QPushButton::clicked, this, &MainWindow::onSelectRequestClient);
     connect(ui->newRequestTourSearchButton, &QPushButton::clicked, this, &MainWindow::onSelectRequestTour);
 
@@ -172,43 +265,71 @@ MainWindow::MainWindow(QWidget *parent)
     // --- Файл ---
     connect(ui->saveButton, &QPushButton::clicked, this, &MainWindow::onSaveFile);
     connect(ui->loadButton, &QPushButton::clicked, this, &MainWindow::onLoadFile);
+    connect(&saveWatcher_, &QFutureWatcher<QString>::finished, this, &MainWindow::onSaveFinished);
+    connect(ui->cancelLoadButton, &QPushButton::clicked, this, &MainWindow::onCancelLoad);
+    connect(&loadWatcher_, &QFutureWatcher<LoadResult>::finished, this, &MainWindow::onLoadFinished);
+    connect(&compactWatcher_, &QFutureWatcher<QString>::finished, this, &MainWindow::onCompactFinished);
 
     Q_UNUSED(NO_EDIT_ID);
 
-    refreshClientsTable();
-    refreshToursTable();
-    refreshRequestsTable();
-    refreshNewRequestCombos();
+    // Подробности заявок разбираются, только когда заявку открывают
+    agency_.setLazyRequestDetails(true);
+
+    // Правила документов подключаются до загрузки данных: по ним создаются документы
+    const QString rulesPath = besideApplication(RULES_FILE);
+    if (QFile::exists(rulesPath)) {
+        DocumentRules rules = DocumentRules::defaults();
+        QString rulesErr;
+        if (rules.loadFile(rulesPath, &rulesErr))
+            DocumentRules::setActive(rules);
+        else
+            QMessageBox::warning(this, "Ошибка", "Правила документов не загружены: " + rulesErr);
+    }
+
+    // --- Данные с прошлого запуска; дальше каждое изменение сразу пишется в журнал ---
+    QString storeErr;
+    const QString storePath = inAppDataDir(STORE_FILE, &storeErr);
+    if (storePath.isEmpty())
+        QMessageBox::warning(this, "Ошибка", "Не удалось открыть хранилище: " + storeErr);
+    else
+        openStoreInBackground(storePath);
+    // Ошибка записи и сжатие журнала обрабатываются после правки, а не посреди неё
+    agency_.setJournalListener([this](const QString& err) {
+        if (!err.isEmpty() && journalError_.isEmpty()) journalError_ = err;
+        if (storeCheckQueued_) return;
+        storeCheckQueued_ = true;
+        QMetaObject::invokeMethod(this, &MainWindow::checkStore, Qt::QueuedConnection);
+    });
+
+    reloadTables();
 }
 
 MainWindow::~MainWindow() {
+    // Файл не должен остаться недописанным при закрытии окна
+    saveWatcher_.waitForFinished();
+    // Недописанная подмена снимка не страшна: журнал ещё не очищен
+    compactWatcher_.waitForFinished();
+    if (loadCancelled_) loadCancelled_->store(true);
+    loadWatcher_.waitForFinished();
     delete ui;
 }
 
 //-----------------------------------------------------------------------------
 // Клиенты
 //-----------------------------------------------------------------------------
-void MainWindow::refreshClientsTable() {
-    refreshClientsTable(agency_.clients());
-}
-
-void MainWindow::refreshClientsTable(const std::vector<Client*>& list) {
-    ui->clientsTable->setRowCount((int)list.size());
-    for (int i = 0; i < (int)list.size(); ++i) {
-        Client* c = list[i];
-        ui->clientsTable->setItem(i, 0, new QTableWidgetItem(QString::number(c->getId())));
-        ui->clientsTable->setItem(i, 1, new QTableWidgetItem(c->getFullName()));
-        ui->clientsTable->setItem(i, 2, new QTableWidgetItem(c->getPhone()));
-        ui->clientsTable->setItem(i, 3, new QTableWidgetItem(c->getEmail()));
-        ui->clientsTable->setItem(i, 4, new QTableWidgetItem(c->getDateOfBirth().toString(Qt::ISODate)));
-        ui->clientsTable->setItem(i, 5, new QTableWidgetItem(c->getComments()));
-    }
+void MainWindow::reloadTables() {
+    clientsModel_->clearFilter();
+    clientsModel_->reload();
+    toursModel_->reload();
+    requestsModel_->reload();
+    clientComboModel_->reload();
+    tourComboModel_->reload();
 }
 
 void MainWindow::onSearch() {
     const QString q = ui->searchEdit->text().trimmed();
-    if (q.isEmpty()) refreshClientsTable();
-    else refreshClientsTable(agency_.searchClients(q));
+    if (q.isEmpty()) clientsModel_->clearFilter();
+    else clientsModel_->setFilter(agency_.searchClients(q));
 }
 
 void MainWindow::onAddClient() {
@@ -286,6 +407,8 @@ void MainWindow::onDeleteClient() {
 
     if (QMessageBox::question(this, "Подтверждение", "Удалить клиента?") != QMessageBox::Yes) return;
 
+    const int row = clientsModel_->rowOf(id);
+    const int comboRow = clientComboModel_->rowOf(id);
     QString err;
     if (!agency_.deleteClient(id, &err)) {
         QMessageBox::warning(this, "Ошибка", err);
@@ -293,8 +416,8 @@ void MainWindow::onDeleteClient() {
     }
 
     showClientForm(false, false);
-    refreshClientsTable();
-    refreshNewRequestCombos();
+    clientsModel_->rowRemoved(row);
+    clientComboModel_->rowRemoved(comboRow);
     ui->salesHistoryList->clear();
 }
 
@@ -348,16 +471,21 @@ void MainWindow::onClientSave() {
     if (editId == 0) {
         Client* c = agency_.addClient(last, first, middle, ph, em, dob, reg, act, cm, &err);
         if (!c) { ui->clientErrorLabel->setText(err.isEmpty() ? "Не удалось добавить клиента." : err); return; }
+        // Новый клиент показывается в общем списке, отбор поиска снимается
+        clientsModel_->clearFilter();
+        clientsModel_->rowsAppended();
+        clientComboModel_->rowsAppended();
     } else {
         if (!agency_.editClient(editId, last, first, middle, ph, em, dob, reg, act, cm, &err)) {
             ui->clientErrorLabel->setText(err);
             return;
         }
+        clientsModel_->rowChanged(editId);
+        clientComboModel_->rowChanged(editId);
+        requestsModel_->allChanged();  // ФИО клиента в его заявках
     }
 
     showClientForm(false, false);
-    refreshClientsTable();
-    refreshNewRequestCombos();
 }
 
 void MainWindow::onClientCancel() {
@@ -386,22 +514,6 @@ void MainWindow::showClientForm(bool show, bool forEdit, int editId) {
 //-----------------------------------------------------------------------------
 // Туры
 //-----------------------------------------------------------------------------
-void MainWindow::refreshToursTable() {
-    ui->toursTable->setRowCount((int)agency_.tours().size());
-    for (int i = 0; i < (int)agency_.tours().size(); ++i) {
-        Tour* t = agency_.tours()[i];
-        ui->toursTable->setItem(i, 0, new QTableWidgetItem(QString::number(t->getId())));
-        ui->toursTable->setItem(i, 1, new QTableWidgetItem(t->getName()));
-        ui->toursTable->setItem(i, 2, new QTableWidgetItem(t->getCountry()));
-        ui->toursTable->setItem(i, 3, new QTableWidgetItem(t->getTourType()));
-        ui->toursTable->setItem(i, 4, new QTableWidgetItem(t->getStartDate().toString(Qt::ISODate)));
-        ui->toursTable->setItem(i, 5, new QTableWidgetItem(QString::number(t->getDurationDays())));
-        ui->toursTable->setItem(i, 6, new QTableWidgetItem(QString::number(t->getBasePrice(), 'f', 2)));
-        ui->toursTable->setItem(i, 7, new QTableWidgetItem(t->isDomestic() ? "Да" : "Нет"));
-        ui->toursTable->setItem(i, 8, new QTableWidgetItem(t->isVisaRequired() ? "Да" : "Нет"));
-    }
-}
-
 void MainWindow::onAddTour() {
     showTourForm(true, false);
 
@@ -453,12 +565,14 @@ void MainWindow::onDeleteTour() {
 
     if (QMessageBox::question(this, "Подтверждение", "Удалить тур?") != QMessageBox::Yes) return;
 
+    const int row = toursModel_->rowOf(id);
+    const int comboRow = tourComboModel_->rowOf(id);
     QString err;
     if (!agency_.deleteTour(id, &err)) { QMessageBox::warning(this, "Ошибка", err); return; }
 
     showTourForm(false, false);
-    refreshToursTable();
-    refreshNewRequestCombos();
+    toursModel_->rowRemoved(row);
+    tourComboModel_->rowRemoved(comboRow);
 }
 
 void MainWindow::onTourSave() {
@@ -483,17 +597,20 @@ void MainWindow::onTourSave() {
     if (editId == 0) {
         Tour* t = agency_.addTour(nm, co, tt, sd, dur, pr, dom, visa, travelModes);
         if (!t) { QMessageBox::warning(this, "Ошибка", "Не удалось добавить тур."); return; }
+        toursModel_->rowsAppended();
+        tourComboModel_->rowsAppended();
     } else {
         QString err;
         if (!agency_.editTour(editId, nm, co, tt, sd, dur, pr, dom, visa, travelModes, &err)) {
             QMessageBox::warning(this, "Ошибка", err);
             return;
         }
+        toursModel_->rowChanged(editId);
+        tourComboModel_->rowChanged(editId);
+        requestsModel_->allChanged();  // название и цена тура в заявках
     }
 
     showTourForm(false, false);
-    refreshToursTable();
-    refreshNewRequestCombos();
 }
 
 void MainWindow::onTourCancel() {
@@ -508,36 +625,18 @@ void MainWindow::showTourForm(bool show, bool forEdit, int editId) {
 //-----------------------------------------------------------------------------
 // Заявки
 //-----------------------------------------------------------------------------
-void MainWindow::refreshRequestsTable() {
-    ui->requestsTable->setRowCount((int)agency_.requests().size());
-    for (int i = 0; i < (int)agency_.requests().size(); ++i) {
-        TourRequest* r = agency_.requests()[i];
-
-        QString statusStr;
-        switch (r->getStatus()) {
-        case RequestStatus::Draft:     statusStr = "Черновик"; break;
-        case RequestStatus::Completed: statusStr = "Оформлена"; break;
-        case RequestStatus::Paid:      statusStr = "Оплачена"; break;
-        case RequestStatus::Canceled:  statusStr = "Отменена"; break;
-        }
-
-        ui->requestsTable->setItem(i, 0, new QTableWidgetItem(QString::number(r->getId())));
-        ui->requestsTable->setItem(i, 1, new QTableWidgetItem(r->getClient()->getFullName()));
-        ui->requestsTable->setItem(i, 2, new QTableWidgetItem(r->getTour()->getName()));
-        ui->requestsTable->setItem(i, 3, new QTableWidgetItem(statusStr));
-        ui->requestsTable->setItem(i, 4, new QTableWidgetItem(QString::number(r->calculateTotalCost(), 'f', 2)));
-    }
+void MainWindow::refreshRevenueLabel() {
+    const auto money = [this](RequestStatus status) {
+        return QString::number(agency_.revenue(status), 'f', 2);
+    };
+    ui->requestsRevenueLabel->setText(QString("Оплачено: %1 руб. | Оформлено: %2 руб. | Черновики: %3 руб.")
+                                          .arg(money(RequestStatus::Paid), money(RequestStatus::Completed),
+                                               money(RequestStatus::Draft)));
 }
 
-void MainWindow::refreshNewRequestCombos() {
-    ui->newRequestClientCombo->clear();
-    ui->newRequestTourCombo->clear();
-
-    for (Client* c : agency_.clients())
-        ui->newRequestClientCombo->addItem(c->getFullName(), c->getId());
-
-    for (Tour* t : agency_.tours())
-        ui->newRequestTourCombo->addItem(t->getName(), t->getId());
+void MainWindow::selectComboItem(QComboBox* combo, AgencyTableModel* model, int id) {
+    const int row = model->fetchRowOf(id);
+    if (row >= 0) combo->setCurrentIndex(row);
 }
 
 void MainWindow::refreshTravelModeOptions(TourRequest* request) {
@@ -610,15 +709,10 @@ void MainWindow::onCreateRequest() {
     TourRequest* r = agency_.createRequest(cid, tid, &err);
     if (!r) { QMessageBox::warning(this, "Ошибка", err); return; }
 
-    refreshRequestsTable();
+    requestsModel_->rowsAppended();
 
     // Выбрать новую заявку и показать детали
-    for (int i = 0; i < ui->requestsTable->rowCount(); ++i) {
-        if (ui->requestsTable->item(i, 0)->text().toInt() == r->getId()) {
-            ui->requestsTable->selectRow(i);
-            break;
-        }
-    }
+    ui->requestsTable->selectRow(requestsModel_->rowOf(r->getId()));
     refreshRequestDetails();
 }
 
@@ -628,27 +722,22 @@ void MainWindow::onDeleteRequest() {
 
     if (QMessageBox::question(this, "Подтверждение", "Удалить заявку?") != QMessageBox::Yes) return;
 
+    const int row = requestsModel_->rowOf(id);
     QString err;
     if (!agency_.deleteRequest(id, &err)) { QMessageBox::warning(this, "Ошибка", err); return; }
 
     showRequestDetails(false);
-    refreshRequestsTable();
+    requestsModel_->rowRemoved(row);
 }
 
 void MainWindow::onSelectRequestClient() {
     const int id = selectClientFromDialog();
-    if (id == 0) return;
-
-    const int idx = ui->newRequestClientCombo->findData(id);
-    if (idx >= 0) ui->newRequestClientCombo->setCurrentIndex(idx);
+    if (id != 0) selectComboItem(ui->newRequestClientCombo, clientComboModel_, id);
 }
 
 void MainWindow::onSelectRequestTour() {
     const int id = selectTourFromDialog();
-    if (id == 0) return;
-
-    const int idx = ui->newRequestTourCombo->findData(id);
-    if (idx >= 0) ui->newRequestTourCombo->setCurrentIndex(idx);
+    if (id != 0) selectComboItem(ui->newRequestTourCombo, tourComboModel_, id);
 }
 
 void MainWindow::onRequestSelectionChanged() {
@@ -664,7 +753,8 @@ void MainWindow::onRequestStatusChanged(int index) {
 
     const RequestStatus s = (RequestStatus)ui->requestStatusCombo->itemData(index).toInt();
     r->setStatus(s);
-    refreshRequestsTable();
+    agency_.noteRequestChanged(id);
+    requestsModel_->rowChanged(id);
 }
 
 void MainWindow::onTravelModeChanged(int index) {
@@ -674,8 +764,10 @@ void MainWindow::onTravelModeChanged(int index) {
     if (!r) return;
 
     const QString mode = ui->travelModeCombo->currentText().trimmed();
-    if (!mode.isEmpty())
+    if (!mode.isEmpty()) {
         r->setTravelMode(mode);
+        agency_.noteRequestChanged(r->getId());
+    }
 
     refreshAnimalTransportOptions();
     refreshTravelClassOptions(r);
@@ -692,8 +784,10 @@ void MainWindow::onTravelClassChanged(int index) {
     if (!clsCb) return;
 
     const QString travelClass = clsCb->currentText().trimmed();
-    if (!travelClass.isEmpty())
+    if (!travelClass.isEmpty()) {
         r->setTravelClass(travelClass);
+        agency_.noteRequestChanged(r->getId());
+    }
 }
 
 void MainWindow::refreshRequestDetails() {
@@ -705,6 +799,14 @@ void MainWindow::refreshRequestDetails() {
         return;
     }
 
+    // Повреждённая запись не открывается для правки и сохраняется как была
+    QString detailsErr;
+    if (!r->materialize(&detailsErr)) {
+        showRequestDetails(false);
+        QMessageBox::warning(this, "Ошибка", detailsErr);
+        return;
+    }
+
     ui->requestDetailsGroup->setProperty("requestId", r->getId());
     showRequestDetails(true);
     ui->requestErrorLabel->clear();
@@ -713,18 +815,12 @@ void MainWindow::refreshRequestDetails() {
     ui->requestTourName->setText(r->getTour()->getName());
     ui->requestCostLabel->setText(QString::number(r->calculateTotalCost(), 'f', 2) + " руб.");
 
-    int adults = 0;
-    int children = 0;
-    for (const auto& t : r->getTourists()) {
-        if (t->isChild()) ++children;
-        else ++adults;
-    }
-
+    const TourRequest::DetailsSummary& totals = r->totals();
     const int animalsCount = (int)r->getAnimals().size();
     const QString breakdown = QString("Взр.: %1 × %2, Дет.: %3 × %2 × 0.5, Жив.: %4 (1000 + 5×кг)")
-                                  .arg(adults)
+                                  .arg(totals.adults)
                                   .arg(QString::number(r->getTour()->getBasePrice(), 'f', 2))
-                                  .arg(children)
+                                  .arg(totals.children)
                                   .arg(animalsCount);
     ui->requestCostBreakdownLabel->setText(breakdown);
 
@@ -795,13 +891,16 @@ void MainWindow::onAddAdult() {
 
     try {
         r->addAdult(last, first, middle);
-        r->tourists().back()->setHasBenefit(ui->touristBenefitCheck->isChecked());
+        const int added = static_cast<int>(r->getTourists().size()) - 1;
+        r->tourist(added)->setHasBenefit(ui->touristBenefitCheck->isChecked());
+        r->regenerateTouristDocuments(added);
+        agency_.noteRequestChanged(r->getId());
         ui->touristLastNameEdit->clear();
         ui->touristFirstNameEdit->clear();
         ui->touristMiddleNameEdit->clear();
         ui->touristBenefitCheck->setChecked(false);
         refreshRequestDetails();
-        refreshRequestsTable();
+        requestsModel_->rowChanged(r->getId());
     } catch (const std::exception& e) {
         QMessageBox::warning(this, "Ошибка", e.what());
     }
@@ -835,13 +934,16 @@ void MainWindow::onAddChild() {
 
     try {
         r->addChild(last, first, middle, dob);
-        r->tourists().back()->setHasBenefit(ui->touristBenefitCheck->isChecked());
+        const int added = static_cast<int>(r->getTourists().size()) - 1;
+        r->tourist(added)->setHasBenefit(ui->touristBenefitCheck->isChecked());
+        r->regenerateTouristDocuments(added);
+        agency_.noteRequestChanged(r->getId());
         ui->touristLastNameEdit->clear();
         ui->touristFirstNameEdit->clear();
         ui->touristMiddleNameEdit->clear();
         ui->touristBenefitCheck->setChecked(false);
         refreshRequestDetails();
-        refreshRequestsTable();
+        requestsModel_->rowChanged(r->getId());
     } catch (const std::exception& e) {
         QMessageBox::warning(this, "Ошибка", e.what());
     }
@@ -855,8 +957,9 @@ void MainWindow::onRemoveTourist() {
     if (row < 0) { QMessageBox::information(this, "Ошибка", "Выберите туриста в списке."); return; }
 
     r->removeTourist(row);
+    agency_.noteRequestChanged(r->getId());
     refreshRequestDetails();
-    refreshRequestsTable();
+    requestsModel_->rowChanged(r->getId());
 }
 
 void MainWindow::onAddAnimal() {
@@ -872,10 +975,11 @@ void MainWindow::onAddAnimal() {
 
     try {
         r->addAnimal(type, w, tr);
+        agency_.noteRequestChanged(r->getId());
         ui->animalTypeEdit->clear();
         ui->animalTransportCombo->setCurrentIndex(0);
         refreshRequestDetails();
-        refreshRequestsTable();
+        requestsModel_->rowChanged(r->getId());
     } catch (const std::exception& e) {
         QMessageBox::warning(this, "Ошибка", e.what());
     }
@@ -889,8 +993,9 @@ void MainWindow::onRemoveAnimal() {
     if (row < 0) { QMessageBox::information(this, "Ошибка", "Выберите животное в списке."); return; }
 
     r->removeAnimal(row);
+    agency_.noteRequestChanged(r->getId());
     refreshRequestDetails();
-    refreshRequestsTable();
+    requestsModel_->rowChanged(r->getId());
 }
 
 void MainWindow::showRequestDetails(bool show) {
@@ -929,7 +1034,9 @@ void MainWindow::refreshRequiredDocuments(TourRequest* request) {
         ui->requiredDocsList->addItem("Заявка: " + Document::typeName(docType));
     }
 
-    const QStringList missing = DocumentService::missingDocumentsSummary(*request);
+    // Недостающие документы и документы, срок которых не покрывает поездку
+    const QStringList missing = DocumentService::missingDocumentsSummary(*request)
+                                + agency_.documentValidityWarnings(request->getId());
     ui->missingDocsText->setPlainText(missing.join("\n"));
 }
 
@@ -983,9 +1090,18 @@ void MainWindow::onOpenDocumentsDialog() {
     if (!r) { QMessageBox::information(this, "Ошибка", "Сначала выберите заявку."); return; }
     DocumentsDialog dialog(r, this);
     dialog.exec();
+    agency_.noteRequestChanged(r->getId());
     refreshRequestDetails();
 }
 
+void MainWindow::onDocumentAudit() {
+    DocumentAuditDialog dialog(agency_, this);
+    if (dialog.exec() != QDialog::Accepted || !dialog.selectedRequestId()) return;
+    // Двойной щелчок по строке отчёта открывает заявку
+    const int row = requestsModel_->rowOf(dialog.selectedRequestId());
+    if (row >= 0) ui->requestsTable->selectRow(row);
+}
+
 //-----------------------------------------------------------------------------
 // Файл
 //-----------------------------------------------------------------------------
@@ -994,12 +1110,49 @@ void MainWindow::onSaveFile() {
     ? "agency_data.json"
     : ui->dataFilePath->text().trimmed();
 
-    QString err;
-    if (!agency_.saveToFile(path, &err)) {
+    if (saveWatcher_.isRunning()) {
+        ui->fileStatusLabel->setText("Сохранение уже выполняется: " + savingPath_);
+        return;
+    }
+
+    // Файл пишется прямо из agency_, без копии в потоке окна: до конца
+    // записи правка данных запрещена
+    blockEditing(true);
+    savingPath_ = path;
+    ui->fileStatusLabel->setText("Сохранение: " + path);
+
+    saveWatcher_.setFuture(QtConcurrent::run([this, path]() -> QString {
+        // Расширение .snap — двоичный снимок, .jsonl — только заявки, иначе JSON
+        QString err;
+        if (path.endsWith(".snap", Qt::CaseInsensitive)) {
+            agency_.saveSnapshot(path, &err);
+            return err;
+        }
+        if (path.endsWith(".jsonl", Qt::CaseInsensitive)) {
+            agency_.exportRequestsJsonl(path, &err);
+            return err;
+        }
+        const auto progress = [this, path](qint64 done, qint64 total) {
+            const int percent = total > 0 ? int(done * 100 / total) : 100;
+            QMetaObject::invokeMethod(this, [this, path, percent]() {
+                if (saveWatcher_.isRunning())
+                    ui->fileStatusLabel->setText(QString("Сохранение: %1 (%2%)").arg(path).arg(percent));
+            }, Qt::QueuedConnection);
+        };
+        agency_.saveToFile(path, progress, &err);
+        return err;
+    }));
+}
+
+void MainWindow::onSaveFinished() {
+    blockEditing(false);
+    const QString err = saveWatcher_.result();
+    if (!err.isEmpty()) {
+        ui->fileStatusLabel->setText("Не сохранено: " + savingPath_);
         QMessageBox::warning(this, "Ошибка", err);
         return;
     }
-    ui->fileStatusLabel->setText("Сохранено: " + path);
+    ui->fileStatusLabel->setText("Сохранено: " + savingPath_);
 }
 
 void MainWindow::onLoadFile() {
@@ -1007,170 +1160,375 @@ void MainWindow::onLoadFile() {
     ? "agency_data.json"
     : ui->dataFilePath->text().trimmed();
 
-    QString err;
-    if (!agency_.loadFromFile(path, &err)) {
-        QMessageBox::warning(this, "Ошибка", err);
+    // Импорт меняет данные, а подготовленный снимок загрузки пишется туда же, куда сжатие
+    if (editBlocks_ > 0) {
+        ui->fileStatusLabel->setText("Дождитесь окончания фоновой работы с данными");
         return;
     }
 
-    ui->fileStatusLabel->setText("Загружено: " + path);
+    if (path.endsWith(".jsonl", Qt::CaseInsensitive)) {
+        importRequests(path);
+        return;
+    }
 
-    refreshClientsTable();
-    refreshToursTable();
-    refreshRequestsTable();
-    refreshNewRequestCombos();
-    showClientForm(false, false);
-    showTourForm(false, false);
-    showRequestDetails(false);
-    ui->clientErrorLabel->clear();
-    ui->requestErrorLabel->clear();
-}
+    if (loadWatcher_.isRunning() || loadApplyPending_) {
+        ui->fileStatusLabel->setText("Загрузка уже выполняется: " + loadingPath_);
+        return;
+    }
 
-//-----------------------------------------------------------------------------
-// Вспомогательные
-//-----------------------------------------------------------------------------
-int MainWindow::selectClientFromDialog() const {
-    QDialog dialog(const_cast<MainWindow*>(this));
-    dialog.setWindowTitle("Поиск клиента");
-    dialog.resize(600, 400);
+    // Файл читается в фоне в отдельный объект; текущие данные остаются
+    // доступными и подменяются только после успешной загрузки
+    loadingPath_ = path;
+    loadCancelled_ = std::make_shared<std::atomic<bool>>(false);
+    setLoadInProgress(true);
+    ui->fileStatusLabel->setText("Загрузка: " + path);
+
+    const bool lazy = agency_.lazyRequestDetails();
+    const QString storePath = agency_.storePath();
+    const auto cancelled = loadCancelled_;
+    loadWatcher_.setFuture(QtConcurrent::run([this, path, lazy, storePath, cancelled]() {
+        const auto progress = [this](qint64 done, qint64 total) {
+            const int percent = total > 0 ? int(done * 100 / total) : 100;
+            QMetaObject::invokeMethod(this, [this, percent]() {
+                if (loadWatcher_.isRunning()) ui->loadProgressBar->setValue(percent);
+            }, Qt::QueuedConnection);
+        };
+        LoadResult result;
+        std::unique_ptr<TravelAgency> loaded =
+            TravelAgency::loadDetached(path, lazy, progress, cancelled.get(), &result.error);
+        // Снимок хранилища тоже пишется здесь, а не при подмене в потоке окна;
+        // не удалось — adoptData запишет его сам
+        if (loaded && !storePath.isEmpty()) loaded->stageStoreSnapshot(storePath);
+        result.agency = std::move(loaded);
+        return result;
+    }));
+}
 
-    QVBoxLayout* layout = new QVBoxLayout(&dialog);
-    QLineEdit* searchEdit = new QLineEdit(&dialog);
-    searchEdit->setPlaceholderText("Введите имя, телефон или email...");
-    layout->addWidget(searchEdit);
+void MainWindow::onCancelLoad() {
+    if (!loadWatcher_.isRunning()) return;
+    loadCancelled_->store(true);
+    ui->cancelLoadButton->setEnabled(false);
+}
 
-    QTableWidget* table = new QTableWidget(&dialog);
-    table->setColumnCount(4);
-    table->setHorizontalHeaderLabels({"ID", "ФИО", "Телефон", "Email"});
-    table->setSelectionBehavior(QAbstractItemView::SelectRows);
-    table->setSelectionMode(QAbstractItemView::SingleSelection);
-    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    table->horizontalHeader()->setStretchLastSection(true);
-    layout->addWidget(table);
+void MainWindow::openStoreInBackground(const QString& storePath) {
+    // Тот же путь, что у загрузки файла: снимок и журнал читаются в отдельный
+    // объект, подмена — в applyLoadedData. Правки до неё не попали бы в журнал
+    loadingPath_ = storePath;
+    loadCancelled_ = std::make_shared<std::atomic<bool>>(false);
+    blockEditing(true);
+    ui->fileStatusLabel->setText("Открытие хранилища: " + storePath);
+
+    const bool lazy = agency_.lazyRequestDetails();
+    loadWatcher_.setFuture(QtConcurrent::run([storePath, lazy]() {
+        LoadResult result;
+        result.store = true;
+        result.agency = TravelAgency::loadStoreDetached(storePath, lazy, &result.journalRecords, &result.error);
+        return result;
+    }));
+}
 
-    auto refresh = [this, table](const QString& query) {
-        const std::vector<Client*> list = query.trimmed().isEmpty()
-        ? agency_.clients()
-        : agency_.searchClients(query);
-
-        table->setRowCount((int)list.size());
-        for (int i = 0; i < (int)list.size(); ++i) {
-            Client* c = list[i];
-            table->setItem(i, 0, new QTableWidgetItem(QString::number(c->getId())));
-            table->setItem(i, 1, new QTableWidgetItem(c->getFullName()));
-            table->setItem(i, 2, new QTableWidgetItem(c->getPhone()));
-            table->setItem(i, 3, new QTableWidgetItem(c->getEmail()));
+void MainWindow::onLoadFinished() {
+    setLoadInProgress(false);
+    const LoadResult result = loadWatcher_.result();
+    if (!result.agency) {
+        // Сжатие, отложенное на время загрузки
+        startCompaction();
+        if (result.store) {
+            blockEditing(false);
+            ui->fileStatusLabel->setText("Хранилище не открыто: " + loadingPath_);
+            QMessageBox::warning(this, "Ошибка", "Не удалось открыть хранилище: " + result.error);
+            return;
         }
-    };
+        if (loadCancelled_->load()) {
+            ui->fileStatusLabel->setText("Загрузка отменена: " + loadingPath_);
+            return;
+        }
+        ui->fileStatusLabel->setText("Не загружено: " + loadingPath_);
+        QMessageBox::warning(this, "Ошибка", result.error);
+        return;
+    }
+    loadApplyPending_ = true;
+    applyLoadedData();
+}
 
-    refresh("");
+void MainWindow::applyLoadedData() {
+    // Окна выбора клиента и тура показывают строки текущих данных по id: пока
+    // открыто модальное окно, данные не подменяются. Фоновая запись читает
+    // agency_ — подмена ждёт и её
+    const bool writing = saveWatcher_.isRunning() || compactWatcher_.isRunning();
+    if (QApplication::activeModalWidget() || writing) {
+        ui->fileStatusLabel->setText(QString("Загружено, данные будут обновлены после %1: %2")
+                                         .arg(writing ? "записи данных" : "закрытия окна", loadingPath_));
+        QTimer::singleShot(LOAD_APPLY_RETRY_MS, this, &MainWindow::applyLoadedData);
+        return;
+    }
 
-    connect(searchEdit, &QLineEdit::textChanged, &dialog, [&refresh](const QString& text) {
-        refresh(text);
-    });
+    loadApplyPending_ = false;
+    const LoadResult result = loadWatcher_.result();
+    const std::shared_ptr<TravelAgency> loaded = result.agency;
+    QString storeErr;
+    const bool stored = result.store
+        ? agency_.adoptStore(*loaded, loadingPath_, result.journalRecords, &storeErr)
+        : agency_.adoptData(*loaded, &storeErr);
+    // Результат хранится в future до следующей загрузки: прежние данные
+    // переносятся из него в отдельный объект
+    auto previous = std::make_shared<TravelAgency>();
+    previous->adoptData(*loaded);
+
+    // Таблицы перестраиваются до любых сообщений: модели уже смотрят на новые данные
+    reloadTables();
+    showClientForm(false, false);
+    showTourForm(false, false);
+    showRequestDetails(false);
+    ui->clientErrorLabel->clear();
+    ui->requestErrorLabel->clear();
+
+    // Прежние данные больше ни на что не ссылаются: освобождаются в фоне
+    (void)QtConcurrent::run([previous = std::move(previous)]() mutable { previous.reset(); });
+
+    if (result.store) {
+        blockEditing(false);
+        if (stored) {
+            ui->fileStatusLabel->setText(QString("Данные: %1 (сохраняются автоматически)").arg(loadingPath_));
+            startCompaction();  // журнал мог дорасти до сжатия в прошлый раз
+        } else {
+            ui->fileStatusLabel->setText("Хранилище не открыто: " + loadingPath_);
+            QMessageBox::warning(this, "Ошибка", "Не удалось открыть хранилище: " + storeErr);
+        }
+    } else {
+        ui->fileStatusLabel->setText("Загружено: " + loadingPath_);
+        if (!stored)
+            QMessageBox::warning(this, "Ошибка", "Данные загружены, но хранилище не обновлено: " + storeErr);
+    }
 
-    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
-    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
-    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
-    layout->addWidget(buttons);
+    const auto& issues = agency_.loadIssues();
+    if (!issues.empty()) {
+        QStringList lines;
+        for (const LoadIssue& issue : issues) lines << issue.message();
+        QMessageBox box(QMessageBox::Warning, "Загрузка",
+                        QString("Файл загружен, но часть заявок пропущена (замечаний: %1).").arg(issues.size()),
+                        QMessageBox::Ok, this);
+        box.setDetailedText(lines.join("\n"));
+        box.exec();
+    }
+}
 
-    connect(table, &QTableWidget::cellDoubleClicked, &dialog, [&dialog](int, int) {
-        dialog.accept();
-    });
+void MainWindow::checkStore() {
+    storeCheckQueued_ = false;
+    if (!journalError_.isEmpty()) {
+        const QString err = std::exchange(journalError_, QString());
+        ui->fileStatusLabel->setText("Изменения не записаны в хранилище: " + agency_.storePath());
+        QMessageBox::warning(this, "Ошибка", "Изменение не сохранено в хранилище: " + err);
+    }
+    startCompaction();
+}
 
-    if (dialog.exec() != QDialog::Accepted) return 0;
-    const int row = table->currentRow();
-    if (row < 0) return 0;
+void MainWindow::startCompaction() {
+    if (!agency_.compactionDue() || compactWatcher_.isRunning()) return;
+    // Подготовленный снимок пишет и фоновая загрузка: сжатие продолжится после неё
+    if (loadWatcher_.isRunning() || loadApplyPending_) return;
+    if (QApplication::activeModalWidget()) {
+        QTimer::singleShot(COMPACT_RETRY_MS, this, &MainWindow::startCompaction);
+        return;
+    }
+
+    // Снимок пишется из самих данных, без копии: до конца записи они не меняются
+    blockEditing(true);
+    const QString staged = TravelAgency::stagedPathFor(agency_.storePath());
+    compactWatcher_.setFuture(QtConcurrent::run([this, staged]() {
+        QString err;
+        agency_.saveSnapshot(staged, &err);
+        return err;
+    }));
+}
+
+void MainWindow::onCompactFinished() {
+    QString err = compactWatcher_.result();
+    if (err.isEmpty()) agency_.commitStagedSnapshot(&err);
+    blockEditing(false);
+    if (!err.isEmpty()) {
+        ui->fileStatusLabel->setText("Журнал хранилища не сжат: " + agency_.storePath());
+        QMessageBox::warning(this, "Ошибка", "Не удалось сжать журнал хранилища: " + err);
+    }
+}
 
-    QTableWidgetItem* it = table->item(row, 0);
-    return it ? it->text().toInt() : 0;
+void MainWindow::blockEditing(bool block) {
+    editBlocks_ += block ? 1 : -1;
+    // Вкладка «Файл» остаётся доступной: сохранение только читает данные
+    for (int i = 0; i < ui->tabWidget->count(); ++i) {
+        QWidget* page = ui->tabWidget->widget(i);
+        if (page != ui->tabFile) page->setEnabled(editBlocks_ == 0);
+    }
+}
+
+void MainWindow::setLoadInProgress(bool busy) {
+    ui->loadButton->setEnabled(!busy);
+    ui->loadProgressBar->setValue(0);
+    ui->loadProgressBar->setVisible(busy);
+    ui->cancelLoadButton->setEnabled(busy);
+    ui->cancelLoadButton->setVisible(busy);
+}
+
+void MainWindow::importRequests(const QString& path) {
+    JsonlImportResult result;
+    QString err;
+    if (!agency_.importRequestsJsonl(path, &result, {}, &err)) {
+        QMessageBox::warning(this, "Ошибка", err);
+        return;
+    }
+
+    ui->fileStatusLabel->setText(QString("Импортировано заявок: %1, строк с ошибками: %2 (%3)")
+                                     .arg(result.imported).arg(result.errors.size()).arg(path));
+    requestsModel_->rowsAppended();
+    onClientSelectionChanged();
+
+    if (!result.errors.empty()) {
+        QStringList lines;
+        for (const auto& e : result.errors) lines << QString("Строка %1: %2").arg(e.line).arg(e.message);
+        QMessageBox box(QMessageBox::Warning, "Импорт",
+                        QString("Часть строк не импортирована (ошибок: %1).").arg(result.errors.size()),
+                        QMessageBox::Ok, this);
+        box.setDetailedText(lines.join("\n"));
+        box.exec();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Вспомогательные
+//-----------------------------------------------------------------------------
+int MainWindow::selectClientFromDialog() const {
+    // Снимок строк клиентов в том виде, в каком их сравнивает индекс поиска:
+    // рабочий поток не обращается к агентству и прерывается посреди прохода
+    struct ClientRow {
+        int id;
+        QString fullName;  // в нижнем регистре
+        QString phone;
+        QString email;     // в нижнем регистре
+    };
+    auto rows = std::make_shared<std::vector<ClientRow>>();
+    rows->reserve(agency_.clients().size());
+    for (const Client* c : agency_.clients())
+        rows->push_back({c->getId(), c->getFullName().toLower(), c->getPhone(), c->getEmail().toLower()});
+
+    SearchController search([rows](const QString& text, const std::atomic<bool>& cancelled) {
+        const QString q = text.trimmed().toLower();
+        std::vector<int> ids;
+        for (size_t i = 0; i < rows->size(); ++i) {
+            if (i % SEARCH_CANCEL_CHECK == 0 && cancelled) return std::vector<int>();
+            const ClientRow& c = (*rows)[i];
+            if (q.isEmpty() || c.fullName.contains(q) || c.phone.contains(q) || c.email.contains(q))
+                ids.push_back(c.id);
+        }
+        return ids;
+    });
+    SearchResultModel model({"ID", "ФИО", "Телефон", "Email"}, [this](int id, int column) {
+        const Client* c = agency_.findClientById(id);
+        if (!c) return QString();
+        switch (column) {
+        case 0: return QString::number(c->getId());
+        case 1: return c->getFullName();
+        case 2: return c->getPhone();
+        case 3: return c->getEmail();
+        }
+        return QString();
+    });
+    return pickFromSearchDialog("Поиск клиента", "Введите имя, телефон или email...", &model, &search);
 }
 
 int MainWindow::selectTourFromDialog() const {
+    // Снимок строк туров: строки Qt разделяются неявно, копия дешёвая
+    struct TourRow {
+        int id;
+        QString name;
+        QString country;
+        QString type;
+    };
+    auto rows = std::make_shared<std::vector<TourRow>>();
+    rows->reserve(agency_.tours().size());
+    for (const Tour* t : agency_.tours())
+        rows->push_back({t->getId(), t->getName(), t->getCountry(), t->getTourType()});
+
+    SearchController search([rows](const QString& text, const std::atomic<bool>& cancelled) {
+        const QString q = text.trimmed();
+        std::vector<int> ids;
+        for (size_t i = 0; i < rows->size(); ++i) {
+            if (i % SEARCH_CANCEL_CHECK == 0 && cancelled) return std::vector<int>();
+            const TourRow& t = (*rows)[i];
+            if (q.isEmpty() || t.name.contains(q, Qt::CaseInsensitive)
+                || t.country.contains(q, Qt::CaseInsensitive) || t.type.contains(q, Qt::CaseInsensitive))
+                ids.push_back(t.id);
+        }
+        return ids;
+    });
+    SearchResultModel model({"ID", "Название", "Страна", "Тип"}, [this](int id, int column) {
+        const Tour* t = agency_.findTourById(id);
+        if (!t) return QString();
+        switch (column) {
+        case 0: return QString::number(t->getId());
+        case 1: return t->getName();
+        case 2: return t->getCountry();
+        case 3: return t->getTourType();
+        }
+        return QString();
+    });
+    return pickFromSearchDialog("Поиск тура", "Введите название, страну или тип тура...", &model, &search);
+}
+
+int MainWindow::pickFromSearchDialog(const QString& title, const QString& placeholder,
+                                     SearchResultModel* model, SearchController* search) const {
     QDialog dialog(const_cast<MainWindow*>(this));
-    dialog.setWindowTitle("Поиск тура");
+    dialog.setWindowTitle(title);
     dialog.resize(600, 400);
 
     QVBoxLayout* layout = new QVBoxLayout(&dialog);
     QLineEdit* searchEdit = new QLineEdit(&dialog);
-    searchEdit->setPlaceholderText("Введите название, страну или тип тура...");
+    searchEdit->setPlaceholderText(placeholder);
     layout->addWidget(searchEdit);
 
-    QTableWidget* table = new QTableWidget(&dialog);
-    table->setColumnCount(4);
-    table->setHorizontalHeaderLabels({"ID", "Название", "Страна", "Тип"});
+    QTableView* table = new QTableView(&dialog);
+    table->setModel(model);
     table->setSelectionBehavior(QAbstractItemView::SelectRows);
     table->setSelectionMode(QAbstractItemView::SingleSelection);
     table->setEditTriggers(QAbstractItemView::NoEditTriggers);
     table->horizontalHeader()->setStretchLastSection(true);
     layout->addWidget(table);
 
-    auto refresh = [this, table](const QString& query) {
-        const QString q = query.trimmed().toLower();
-        std::vector<Tour*> list;
-        list.reserve((size_t)agency_.tours().size());
-
-        for (Tour* t : agency_.tours()) {
-            if (q.isEmpty() ||
-                t->getName().toLower().contains(q) ||
-                t->getCountry().toLower().contains(q) ||
-                t->getTourType().toLower().contains(q)) {
-                list.push_back(t);
-            }
-        }
+    QLabel* statusLabel = new QLabel("Поиск...", &dialog);
+    layout->addWidget(statusLabel);
 
-        table->setRowCount((int)list.size());
-        for (int i = 0; i < (int)list.size(); ++i) {
-            Tour* t = list[i];
-            table->setItem(i, 0, new QTableWidgetItem(QString::number(t->getId())));
-            table->setItem(i, 1, new QTableWidgetItem(t->getName()));
-            table->setItem(i, 2, new QTableWidgetItem(t->getCountry()));
-            table->setItem(i, 3, new QTableWidgetItem(t->getTourType()));
-        }
-    };
-
-    refresh("");
-
-    connect(searchEdit, &QLineEdit::textChanged, &dialog, [&refresh](const QString& text) {
-        refresh(text);
+    // Каждое нажатие только перезапускает паузу; поиск — в рабочем потоке
+    connect(searchEdit, &QLineEdit::textChanged, search, [search, statusLabel](const QString& text) {
+        statusLabel->setText("Поиск...");
+        search->setQuery(text);
     });
+    connect(search, &SearchController::resultsReady, &dialog,
+            [model, statusLabel](const QString&, const std::vector<int>& ids) {
+                model->setResults(ids);
+                statusLabel->setText(QString("Найдено: %1").arg(ids.size()));
+            });
+    search->runNow(QString());
 
     QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
     connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
     connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
     layout->addWidget(buttons);
 
-    connect(table, &QTableWidget::cellDoubleClicked, &dialog, [&dialog](int, int) {
-        dialog.accept();
-    });
+    connect(table, &QTableView::doubleClicked, &dialog, &QDialog::accept);
 
     if (dialog.exec() != QDialog::Accepted) return 0;
-    const int row = table->currentRow();
-    if (row < 0) return 0;
-
-    QTableWidgetItem* it = table->item(row, 0);
-    return it ? it->text().toInt() : 0;
+    return model->idAt(table->currentIndex().row());
 }
 
 int MainWindow::getSelectedClientId() const {
-    const int row = ui->clientsTable->currentRow();
-    if (row < 0) return 0;
-    QTableWidgetItem* it = ui->clientsTable->item(row, 0);
-    return it ? it->text().toInt() : 0;
+    return clientsModel_->idAt(ui->clientsTable->currentIndex().row());
 }
 
 int MainWindow::getSelectedTourId() const {
-    const int row = ui->toursTable->currentRow();
-    if (row < 0) return 0;
-    QTableWidgetItem* it = ui->toursTable->item(row, 0);
-    return it ? it->text().toInt() : 0;
+    return toursModel_->idAt(ui->toursTable->currentIndex().row());
 }
 
 int MainWindow::getSelectedRequestId() const {
-    const int row = ui->requestsTable->currentRow();
-    if (row < 0) return 0;
-    QTableWidgetItem* it = ui->requestsTable->item(row, 0);
-    return it ? it->text().toInt() : 0;
+    return requestsModel_->idAt(ui->requestsTable->currentIndex().row());
 }
 
 int MainWindow::getActiveRequestId() const {
@@ -6,7 +6,10 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QFutureWatcher>
 #include <QMainWindow>
+#include <atomic>
+#include <memory>
 #include "agency.h"
 #include "address.h"
 
@@ -15,6 +18,12 @@ namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
 class QComboBox;
+class AgencyTableModel;
+class ClientTableModel;
+class TourTableModel;
+class RequestTableModel;
+class SearchController;
+class SearchResultModel;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -55,25 +64,69 @@ private slots:
     void onAddAnimal();
     void onRemoveAnimal();
     void onOpenDocumentsDialog();
+    void onDocumentAudit();
     void onSameAddressToggled(bool checked);
     // Файл
     void onSaveFile();
+    void onSaveFinished();
     void onLoadFile();
+    void onCancelLoad();
+    void onLoadFinished();
+    void onCompactFinished();
 
 private:
     Ui::MainWindow *ui;
     TravelAgency agency_;
+    // Фоновое сохранение: результат — текст ошибки (пусто при успехе)
+    QFutureWatcher<QString> saveWatcher_;
+    QString savingPath_;
+    // Фоновая загрузка: данные или текст ошибки — результат future
+    struct LoadResult {
+        std::shared_ptr<TravelAgency> agency;  // nullptr — ошибка или отмена
+        QString error;
+        bool store = false;      // рабочее хранилище при запуске (loadStoreDetached)
+        int journalRecords = 0;  // для store: записей в журнале
+    };
+    QFutureWatcher<LoadResult> loadWatcher_;
+    bool loadApplyPending_ = false;  // данные ждут закрытия модального окна
+    std::shared_ptr<std::atomic<bool>> loadCancelled_;
+    QString loadingPath_;
+    // Фоновое сжатие журнала: снимок пишется прямо из agency_ — правка в это
+    // время запрещена (blockEditing); результат — текст ошибки
+    QFutureWatcher<QString> compactWatcher_;
+    QString journalError_;           // ошибка записи в журнал, ещё не показанная
+    bool storeCheckQueued_ = false;  // checkStore уже поставлен в очередь
+    int editBlocks_ = 0;             // фоновых задач, читающих agency_
+    // Модели таблиц вкладок; после правок окно сообщает им изменённые строки
+    ClientTableModel* clientsModel_ = nullptr;
+    TourTableModel* toursModel_ = nullptr;
+    RequestTableModel* requestsModel_ = nullptr;
+    // Модели выпадающих списков новой заявки (без отбора, строки подгружаются порциями)
+    ClientTableModel* clientComboModel_ = nullptr;
+    TourTableModel* tourComboModel_ = nullptr;
 
-    void refreshClientsTable();
-    void refreshClientsTable(const std::vector<Client*>& list);
-    void refreshToursTable();
-    void refreshRequestsTable();
+    /** Полная перестройка таблиц и списков новой заявки (загрузка данных) */
+    void reloadTables();
+    /** Выручка по статусам под таблицей заявок (TravelAgency::revenue) */
+    void refreshRevenueLabel();
     void refreshRequestDetails();
-    void refreshNewRequestCombos();
     void refreshAnimalTransportOptions();
     void refreshTravelModeOptions(TourRequest* request);
     void refreshTravelClassOptions(TourRequest* request);
     void refreshRequiredDocuments(TourRequest* request);
+    /** Добавляет заявки из JSONL-файла и показывает ошибки по строкам */
+    void importRequests(const QString& path);
+    /** Подменяет данные агентства загруженными (результат loadWatcher_) и перестраивает окно */
+    void applyLoadedData();
+    void setLoadInProgress(bool busy);
+    /** Открывает рабочее хранилище в фоне через loadWatcher_; до подмены данных правка запрещена */
+    void openStoreInBackground(const QString& storePath);
+    /** После записей в журнал: показывает ошибку записи и запускает сжатие */
+    void checkStore();
+    /** Сжатие журнала в снимок в фоне, когда журнал дорос до TravelAgency::COMPACT_EVERY */
+    void startCompaction();
+    /** Правка данных запрещена, пока фоновая задача читает agency_; вызовы парные */
+    void blockEditing(bool block);
     Address collectRegistrationAddress() const;
     Address collectActualAddress() const;
     void applyActualAddressEnabled(bool enabled);
@@ -82,11 +135,16 @@ private:
     void showRequestDetails(bool show);
     int selectClientFromDialog() const;
     int selectTourFromDialog() const;
+    /** Окно выбора с поиском по мере ввода; 0 — ничего не выбрано */
+    int pickFromSearchDialog(const QString& title, const QString& placeholder,
+                             SearchResultModel* model, SearchController* search) const;
     int getSelectedClientId() const;
     int getSelectedTourId() const;
     int getSelectedRequestId() const;
     int getActiveRequestId() const;
     QComboBox* travelClassCombo() const;
+    /** Выбирает в списке элемент id, подгрузив строки до него */
+    void selectComboItem(QComboBox* combo, AgencyTableModel* model, int id);
 };
 
 #endif // MAINWINDOW_H
@@ -8,10 +8,34 @@ bool RequestService::validateRequest(const TourRequest& request, QString* err) {
         if (err) *err = "Добавьте хотя бы одного туриста";
         return false;
     }
-    const auto missing = DocumentService::missingDocumentsSummary(request);
-    if (!missing.isEmpty()) {
+    if (!request.isComplete()) {
         if (err) *err = "Есть незаполненные обязательные документы";
         return false;
     }
     return true;
 }
+
+bool RequestService::validateForImport(const TourRequest& request, QString* err) {
+    if (request.getTourists().empty()) {
+        if (err) *err = "Добавьте хотя бы одного туриста";
+        return false;
+    }
+    auto checkDocument = [err](const Document& doc, const QString& owner) {
+        if (doc.getStatus() == DocumentStatus::Absent) return true;
+        QString docErr;
+        if (DocumentService::validateDocument(doc, &docErr)) return true;
+        if (err) *err = QString("%1, %2: %3").arg(owner, Document::typeName(doc.getType()), docErr);
+        return false;
+    };
+    for (const auto& t : request.getTourists()) {
+        for (const auto& doc : t->documents())
+            if (!checkDocument(*doc, t->getFullName())) return false;
+    }
+    for (const auto& doc : request.getDocuments())
+        if (!checkDocument(*doc, "Заявка")) return false;
+
+    const RequestStatus status = request.getStatus();
+    if (status == RequestStatus::Completed || status == RequestStatus::Paid)
+        return validateRequest(request, err);
+    return true;
+}
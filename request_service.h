@@ -7,4 +7,10 @@ class TourRequest;
 class RequestService {
 public:
     static bool validateRequest(const TourRequest& request, QString* err = nullptr);
+    /**
+     * Проверка заявки, пришедшей извне (импорт): есть туристы, документы со
+     * статусом «Имеется»/«Проверен» заполнены верно, а оформленная или
+     * оплаченная заявка проходит и validateRequest. Черновик может быть неполным.
+     */
+    static bool validateForImport(const TourRequest& request, QString* err = nullptr);
 };
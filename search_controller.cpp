@@ -0,0 +1,103 @@
+#include "search_controller.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// SearchController
+//-----------------------------------------------------------------------------
+SearchController::SearchController(Query query, QObject* parent)
+    : QObject(parent), query_(std::move(query)) {
+    debounce_.setSingleShot(true);
+    debounce_.setInterval(DEBOUNCE_MS);
+    connect(&debounce_, &QTimer::timeout, this, &SearchController::startPending);
+    connect(&watcher_, &QFutureWatcher<std::vector<int>>::finished, this, &SearchController::onFinished);
+}
+
+SearchController::~SearchController() {
+    if (cancelled_) cancelled_->store(true);
+    watcher_.waitForFinished();
+}
+
+void SearchController::setQuery(const QString& text) {
+    pendingText_ = text;
+    hasPending_ = true;
+    if (cancelled_) cancelled_->store(true);
+    debounce_.start();
+}
+
+void SearchController::runNow(const QString& text) {
+    debounce_.stop();
+    pendingText_ = text;
+    hasPending_ = true;
+    if (cancelled_) cancelled_->store(true);
+    startPending();
+}
+
+void SearchController::startPending() {
+    // Отменённый запрос ещё работает: следующий стартует в onFinished
+    if (!hasPending_ || watcher_.isRunning()) return;
+    hasPending_ = false;
+    runningText_ = pendingText_;
+    cancelled_ = std::make_shared<std::atomic<bool>>(false);
+    const Query query = query_;
+    const QString text = runningText_;
+    const std::shared_ptr<std::atomic<bool>> cancelled = cancelled_;
+    watcher_.setFuture(QtConcurrent::run([query, text, cancelled]() {
+        return query(text, *cancelled);
+    }));
+}
+
+void SearchController::onFinished() {
+    if (!cancelled_->load()) emit resultsReady(runningText_, watcher_.result());
+    if (!debounce_.isActive()) startPending();
+}
+
+//-----------------------------------------------------------------------------
+// SearchResultModel
+//-----------------------------------------------------------------------------
+SearchResultModel::SearchResultModel(const QStringList& headers, Cell cell, QObject* parent)
+    : QAbstractTableModel(parent), headers_(headers), cell_(std::move(cell)) {}
+
+void SearchResultModel::setResults(const std::vector<int>& ids) {
+    beginResetModel();
+    ids_ = ids;
+    shown_ = std::min(totalCount(), PAGE_SIZE);
+    endResetModel();
+}
+
+int SearchResultModel::idAt(int row) const {
+    return row >= 0 && row < shown_ ? ids_[row] : 0;
+}
+
+int SearchResultModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : shown_;
+}
+
+int SearchResultModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(headers_.size());
+}
+
+QVariant SearchResultModel::data(const QModelIndex& index, int role) const {
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= shown_) return QVariant();
+    return cell_(ids_[index.row()], index.column());
+}
+
+QVariant SearchResultModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal && section >= 0 && section < headers_.size())
+        return headers_.at(section);
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool SearchResultModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && shown_ < totalCount();
+}
+
+void SearchResultModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) return;
+    const int next = std::min(totalCount(), shown_ + PAGE_SIZE);
+    beginInsertRows(QModelIndex(), shown_, next - 1);
+    shown_ = next;
+    endInsertRows();
+}
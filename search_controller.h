@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <QTimer>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//=============================================================================
+// SearchController — поиск по мере ввода в рабочем потоке
+//=============================================================================
+
+/**
+ * Текст запроса уходит в работу после паузы ввода DEBOUNCE_MS. Запрос
+ * выполняется в пуле потоков над снимком данных, захваченным функцией query;
+ * новый ввод отменяет текущий запрос (флаг cancelled), а его результат
+ * отбрасывается. В работе не больше одного запроса: следующий стартует, когда
+ * отменённый вернёт управление. resultsReady приходит в потоке владельца.
+ */
+class SearchController : public QObject {
+    Q_OBJECT
+public:
+    /** Ищет text, время от времени проверяя cancelled; возвращает id найденного */
+    using Query = std::function<std::vector<int>(const QString& text, const std::atomic<bool>& cancelled)>;
+
+    static constexpr int DEBOUNCE_MS = 250;  // пауза ввода перед запуском запроса
+
+    explicit SearchController(Query query, QObject* parent = nullptr);
+    /** Отменяет текущий запрос и дожидается его возврата */
+    ~SearchController() override;
+
+    /** Новый текст (каждое нажатие): запрос — после паузы ввода */
+    void setQuery(const QString& text);
+    /** Запрос без паузы (первый показ списка) */
+    void runNow(const QString& text);
+    bool isBusy() const { return watcher_.isRunning() || debounce_.isActive(); }
+
+signals:
+    /** Результат последнего введённого текста; устаревшие запросы его не присылают */
+    void resultsReady(const QString& text, const std::vector<int>& ids);
+
+private:
+    Query query_;
+    QTimer debounce_;
+    QFutureWatcher<std::vector<int>> watcher_;
+    std::shared_ptr<std::atomic<bool>> cancelled_;  // флаг запроса в работе
+    QString runningText_;
+    QString pendingText_;
+    bool hasPending_ = false;
+
+    void startPending();
+    void onFinished();
+};
+
+//=============================================================================
+// SearchResultModel — найденные id, текст строк формируется при показе
+//=============================================================================
+
+/**
+ * Строки отдаются представлению страницами по PAGE_SIZE (canFetchMore/fetchMore):
+ * после нового результата сразу видна первая страница, остальные подгружаются
+ * при прокрутке. Текст ячеек берётся из cell по id только для видимых строк.
+ */
+class SearchResultModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    using Cell = std::function<QString(int id, int column)>;
+
+    static constexpr int PAGE_SIZE = 200;  // строк в одной подгрузке
+
+    SearchResultModel(const QStringList& headers, Cell cell, QObject* parent = nullptr);
+
+    void setResults(const std::vector<int>& ids);
+    /** id в строке; 0 — строки нет */
+    int idAt(int row) const;
+    int totalCount() const { return static_cast<int>(ids_.size()); }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private:
+    QStringList headers_;
+    Cell cell_;
+    std::vector<int> ids_;
+    int shown_ = 0;  // строк, уже отданных представлению
+};
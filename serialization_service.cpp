@@ -0,0 +1,313 @@
+#include "serialization_service.h"
+
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStringList>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+
+#include "client.h"
+#include "document.h"
+#include "json_stream_reader.h"
+#include "tour.h"
+#include "tour_request.h"
+#include "tourist.h"
+
+static std::tuple<QString, QString, QString> parseLegacyName(const QString& fullName) {
+    QStringList parts = fullName.split(' ', Qt::SkipEmptyParts);
+    QString last = parts.value(0);
+    QString first = parts.value(1);
+    QString middle = parts.mid(2).join(' ');
+    return std::tuple<QString, QString, QString>(last, first, middle);
+}
+
+static std::tuple<QString, QString, QString> readName(const QJsonObject& o) {
+    QString last = o["lastName"].toString();
+    QString first = o["firstName"].toString();
+    QString middle = o["middleName"].toString();
+    if (last.isEmpty() && first.isEmpty() && o.contains("fullName"))
+        return parseLegacyName(o["fullName"].toString());
+    return std::tuple<QString, QString, QString>(last, first, middle);
+}
+
+QJsonObject SerializationService::clientToJson(const Client& c) {
+    QJsonObject o;
+    o["id"] = c.getId();
+    o["lastName"] = c.getLastName();
+    o["firstName"] = c.getFirstName();
+    o["middleName"] = c.getMiddleName();
+    o["fullName"] = c.getFullName();
+    o["phone"] = c.getPhone();
+    o["email"] = c.getEmail();
+    o["dateOfBirth"] = c.getDateOfBirth().toString(Qt::ISODate);
+    o["comments"] = c.getComments();
+    o["registrationAddress"] = c.getRegistrationAddress().toJson();
+    o["actualAddress"] = c.getActualAddress().toJson();
+    return o;
+}
+
+Client* SerializationService::clientFromJson(const QJsonObject& o) {
+    const auto name = readName(o);
+    Address reg = Address::fromJson(o["registrationAddress"].toObject());
+    Address actual = Address::fromJson(o["actualAddress"].toObject());
+    if (actual.isEmpty() && !reg.isEmpty()) actual = reg;
+    return new Client(
+        std::get<0>(name),
+        std::get<1>(name),
+        std::get<2>(name),
+        o["phone"].toString(),
+        o["email"].toString(),
+        QDate::fromString(o["dateOfBirth"].toString(), Qt::ISODate),
+        reg,
+        actual,
+        o["comments"].toString(),
+        o["id"].toInt()
+        );
+}
+
+QJsonObject SerializationService::tourToJson(const Tour& t) {
+    QJsonObject o;
+    o["id"] = t.getId();
+    o["name"] = t.getName();
+    o["country"] = t.getCountry();
+    o["tourType"] = t.getTourType();
+    o["startDate"] = t.getStartDate().toString(Qt::ISODate);
+    o["durationDays"] = t.getDurationDays();
+    o["basePrice"] = t.getBasePrice();
+    o["isDomestic"] = t.isDomestic();
+    o["visaRequired"] = t.isVisaRequired();
+    QJsonArray travelModes;
+    for (const QString& mode : t.getTravelModes())
+        travelModes.append(mode);
+    o["travelModes"] = travelModes;
+    return o;
+}
+
+Tour* SerializationService::tourFromJson(const QJsonObject& o) {
+    QStringList modes;
+    for (const QJsonValue& mv : o["travelModes"].toArray())
+        modes.append(mv.toString());
+    return new Tour(
+        o["name"].toString(),
+        o["country"].toString(),
+        o["tourType"].toString(),
+        QDate::fromString(o["startDate"].toString(), Qt::ISODate),
+        o["durationDays"].toInt(),
+        o["basePrice"].toDouble(),
+        o["isDomestic"].toBool(),
+        o["visaRequired"].toBool(),
+        modes,
+        o["id"].toInt()
+        );
+}
+
+QJsonObject SerializationService::documentToJson(const Document& d) {
+    QJsonObject docObj;
+    docObj["type"] = static_cast<int>(d.getType());
+    docObj["status"] = static_cast<int>(d.getStatus());
+    docObj["fields"] = QJsonObject::fromVariantMap(d.fields());
+    return docObj;
+}
+
+static const char* const DETAILS_KEYS[] = {"tourists", "animals", "documents"};
+static const char* const HEADER_KEYS[] = {"id", "clientId", "tourId", "status", "travelMode", "travelClass", "totals"};
+
+static QJsonObject requestHeaderToJson(const TourRequest& r) {
+    QJsonObject o;
+    o["id"] = r.getId();
+    o["clientId"] = r.getClient()->getId();
+    o["tourId"] = r.getTour()->getId();
+    o["status"] = static_cast<int>(r.getStatus());
+    o["travelMode"] = r.getTravelMode();
+    o["travelClass"] = r.getTravelClass();
+    const TourRequest::DetailsSummary& summary = r.totals();
+    QJsonObject totals;
+    totals["adults"] = summary.adults;
+    totals["children"] = summary.children;
+    totals["animalSurcharge"] = summary.animalSurcharge;
+    o["totals"] = totals;
+    return o;
+}
+
+QJsonObject SerializationService::requestToJson(const TourRequest& r) {
+    QJsonObject o = requestHeaderToJson(r);
+
+    // Неразобранные подробности переносятся без создания объектов
+    if (r.hasPendingDetails()) {
+        const QJsonObject details = QJsonDocument::fromJson(r.pendingDetails()).object();
+        for (const char* key : DETAILS_KEYS)
+            o[key] = details[key].isArray() ? details[key] : QJsonArray();
+        return o;
+    }
+
+    QJsonArray tourists, animals, documents;
+
+    for (const auto& t : r.getTourists()) {
+        QJsonObject to;
+        to["isChild"] = t->isChild();
+        to["lastName"] = t->getLastName();
+        to["firstName"] = t->getFirstName();
+        to["middleName"] = t->getMiddleName();
+        to["fullName"] = t->getFullName();
+        to["hasBenefit"] = t->hasBenefit();
+        if (t->isChild()) {
+            to["dateOfBirth"] = static_cast<ChildTourist*>(t.get())->getDateOfBirth().toString(Qt::ISODate);
+        }
+        QJsonArray touristDocs;
+        for (const auto& doc : t->documents())
+            touristDocs.append(documentToJson(*doc));
+        to["documents"] = touristDocs;
+        tourists.append(to);
+    }
+
+    for (const auto& a : r.getAnimals()) {
+        QJsonObject ao;
+        ao["type"] = a->getType();
+        ao["weight"] = a->getWeight();
+        ao["transport"] = a->getTransport();
+        animals.append(ao);
+    }
+
+    for (const auto& d : r.getDocuments())
+        documents.append(documentToJson(*d));
+
+    o["tourists"] = tourists;
+    o["animals"] = animals;
+    o["documents"] = documents;
+    return o;
+}
+
+QByteArray SerializationService::requestToJsonBytes(const TourRequest& r) {
+    if (!r.hasPendingDetails()) return QJsonDocument(requestToJson(r)).toJson(QJsonDocument::Compact);
+    // {заголовок} + члены объекта подробностей: "{...}" и "{...}" → "{...,...}"
+    QByteArray out = QJsonDocument(requestHeaderToJson(r)).toJson(QJsonDocument::Compact);
+    const QByteArray& details = r.pendingDetails();
+    const int open = details.indexOf('{');
+    const int close = details.lastIndexOf('}');
+    const QByteArray members = open >= 0 && close > open ? details.mid(open + 1, close - open - 1).trimmed()
+                                                         : QByteArray();
+    if (!members.isEmpty()) {
+        out.chop(1);
+        out += ',' + members + '}';
+    }
+    return out;
+}
+
+bool SerializationService::splitRequestJson(const QByteArray& raw, QJsonObject* header, QByteArray* details,
+                                            QString* err) {
+    QBuffer buffer;
+    buffer.setData(raw);
+    buffer.open(QIODevice::ReadOnly);
+    JsonStreamReader reader(&buffer);
+    QByteArray head = "{";
+    QByteArray body = "{";
+    auto append = [](QByteArray& out, const QString& key, const QByteArray& value) {
+        if (out.size() > 1) out += ',';
+        out += '"' + key.toUtf8() + "\":" + value;
+    };
+    QString key;
+    QByteArray value;
+    if (reader.beginObject()) {
+        while (reader.nextKey(&key) && reader.nextValue(&value)) {
+            if (std::find(std::begin(DETAILS_KEYS), std::end(DETAILS_KEYS), key) != std::end(DETAILS_KEYS))
+                append(body, key, value);
+            else if (std::find(std::begin(HEADER_KEYS), std::end(HEADER_KEYS), key) != std::end(HEADER_KEYS))
+                append(head, key, value);
+        }
+    }
+    if (reader.hasError()) {
+        if (err) *err = "Ошибка JSON: " + reader.errorString();
+        return false;
+    }
+    // Заголовок короткий: разбирается целиком
+    QJsonParseError perr;
+    const QJsonDocument doc = QJsonDocument::fromJson(head + '}', &perr);
+    if (!doc.isObject()) {
+        if (err) *err = "Ошибка JSON: " + perr.errorString();
+        return false;
+    }
+    *header = doc.object();
+    *details = body + '}';
+    return true;
+}
+
+static std::unique_ptr<TourRequest> requestHeaderFromJson(const QJsonObject& o, Client* client, Tour* tour) {
+    auto r = std::make_unique<TourRequest>(client, tour, o["id"].toInt());
+    r->setStatus(static_cast<RequestStatus>(o["status"].toInt()));
+    if (o.contains("travelMode"))
+        r->setTravelMode(o["travelMode"].toString());
+    if (o.contains("travelClass"))
+        r->setTravelClass(o["travelClass"].toString());
+    return r;
+}
+
+TourRequest* SerializationService::requestFromJson(const QJsonObject& o, Client* client, Tour* tour) {
+    auto r = requestHeaderFromJson(o, client, tour);
+    readRequestDetails(*r, o);
+    return r.release();
+}
+
+TourRequest* SerializationService::requestFromJsonLazy(const QJsonObject& header, const QByteArray& details,
+                                                       Client* client, Tour* tour) {
+    auto r = requestHeaderFromJson(header, client, tour);
+    TourRequest::DetailsSummary summary;
+    if (header["totals"].isObject()) {
+        const QJsonObject totals = header["totals"].toObject();
+        summary.adults = totals["adults"].toInt();
+        summary.children = totals["children"].toInt();
+        summary.animalSurcharge = totals["animalSurcharge"].toDouble();
+    } else {
+        const QJsonObject o = QJsonDocument::fromJson(details).object();
+        for (const QJsonValue& tv : o["tourists"].toArray()) {
+            if (tv.toObject()["isChild"].toBool()) ++summary.children;
+            else ++summary.adults;
+        }
+        for (const QJsonValue& av : o["animals"].toArray())
+            summary.animalSurcharge += TourRequest::animalSurcharge(av.toObject()["weight"].toDouble());
+    }
+    r->setPendingDetails(details, summary);
+    return r.release();
+}
+
+void SerializationService::readRequestDetails(TourRequest& request, const QJsonObject& o) {
+    TourRequest* r = &request;
+    for (const QJsonValue& tv : o["tourists"].toArray()) {
+        QJsonObject to = tv.toObject();
+        const auto name = readName(to);
+        if (to["isChild"].toBool()) {
+            r->addChild(std::get<0>(name), std::get<1>(name), std::get<2>(name),
+                        QDate::fromString(to["dateOfBirth"].toString(), Qt::ISODate));
+        } else {
+            r->addAdult(std::get<0>(name), std::get<1>(name), std::get<2>(name));
+        }
+        Tourist* tourist = r->tourist(static_cast<int>(r->getTourists().size()) - 1);
+        tourist->setHasBenefit(to["hasBenefit"].toBool());
+        tourist->clearDocuments();
+        for (const QJsonValue& dv : to["documents"].toArray()) {
+            QJsonObject dobj = dv.toObject();
+            auto doc = std::make_unique<Document>(static_cast<DocumentType>(dobj["type"].toInt()));
+            doc->setStatus(static_cast<DocumentStatus>(dobj["status"].toInt()));
+            doc->setFields(dobj["fields"].toObject().toVariantMap());
+            tourist->documents().push_back(std::move(doc));
+        }
+    }
+
+    for (const QJsonValue& av : o["animals"].toArray()) {
+        QJsonObject ao = av.toObject();
+        r->addAnimal(ao["type"].toString(), ao["weight"].toDouble(), ao["transport"].toString());
+    }
+
+    // Документы заявки: поверх сгенерированных, по типу — порядок в старых
+    // файлах может отличаться от текущего
+    r->regenerateDocuments();
+    for (const QJsonValue& dv : o["documents"].toArray()) {
+        QJsonObject dobj = dv.toObject();
+        auto doc = std::make_unique<Document>(static_cast<DocumentType>(dobj["type"].toInt()));
+        doc->setStatus(static_cast<DocumentStatus>(dobj["status"].toInt()));
+        doc->setFields(dobj["fields"].toObject().toVariantMap());
+        r->restoreDocument(std::move(doc));
+    }
+}
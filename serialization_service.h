@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+class Client;
+class Document;
+class Tour;
+class TourRequest;
+
+//=============================================================================
+// SerializationService — перевод сущностей в JSON и обратно
+//=============================================================================
+
+/**
+ * Общий формат записей для сохранения/загрузки файла данных.
+ * Методы *FromJson создают новые объекты и бросают std::invalid_argument
+ * при некорректных данных (как конструкторы сущностей).
+ */
+class SerializationService {
+public:
+    static QJsonObject clientToJson(const Client& client);
+    /** Поддерживает старые записи, где есть только "fullName" */
+    static Client* clientFromJson(const QJsonObject& obj);
+
+    static QJsonObject tourToJson(const Tour& tour);
+    static Tour* tourFromJson(const QJsonObject& obj);
+
+    static QJsonObject documentToJson(const Document& document);
+
+    /**
+     * Запись заявки; "totals" — сводка для стоимости (см. requestFromJsonLazy).
+     * Отложенные подробности разбираются из сохранённых байтов.
+     */
+    static QJsonObject requestToJson(const TourRequest& request);
+    /** Компактный JSON записи; отложенные подробности дописываются байтами, без разбора */
+    static QByteArray requestToJsonBytes(const TourRequest& request);
+    /** Клиент и тур уже найдены по "clientId"/"tourId" вызывающей стороной */
+    static TourRequest* requestFromJson(const QJsonObject& obj, Client* client, Tour* tour);
+    /**
+     * Делит JSON-запись заявки без разбора вложенных массивов: поля заголовка
+     * (id, clientId, tourId, status, travelMode, travelClass, totals) — в header,
+     * tourists/animals/documents — байтами объекта в details.
+     */
+    static bool splitRequestJson(const QByteArray& raw, QJsonObject* header, QByteArray* details,
+                                 QString* err = nullptr);
+    /**
+     * Ленивый вариант: заявка из заголовка, подробности details остаются
+     * байтами до первого обращения. Сводка берётся из "totals"; в записях
+     * прежних версий без неё подробности разбираются для подсчёта.
+     */
+    static TourRequest* requestFromJsonLazy(const QJsonObject& header, const QByteArray& details,
+                                            Client* client, Tour* tour);
+    /** Туристы, животные и документы заявки из её JSON-записи */
+    static void readRequestDetails(TourRequest& request, const QJsonObject& obj);
+};
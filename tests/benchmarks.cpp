@@ -0,0 +1,300 @@
+/**
+ * @file benchmarks.cpp
+ * @brief Замеры производительности для приложения «Туристическое агентство».
+ * Не входит в ctest: запускается вручную (./turism_project_bench в каталоге сборки).
+ */
+#include "agency.h"
+#include "client_service.h"
+#include "document_service.h"
+#include "validation_service.h"
+#include <QCoreApplication>
+#include <QDate>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <cstdio>
+
+#define RUN_BENCH(name) do { \
+    fprintf(stderr, "  [BENCH] %s\n", #name); \
+    name(); \
+} while(0)
+
+static Address makeAddress() {
+    Address reg;
+    reg.region = "Московская";
+    reg.city = "Москва";
+    reg.street = "Тверская";
+    reg.house = "1";
+    reg.postalCode = "123456";
+    return reg;
+}
+
+/** Новое выражение с тем же шаблоном: компилируется при первом сопоставлении, как раньше */
+static QRegularExpression freshRegex(const QRegularExpression& re) {
+    return QRegularExpression(re.pattern());
+}
+
+/** Адрес, как его проверял validateAddress до общих выражений: каждое поле — своё выражение */
+static bool legacyValidateAddress(const Address& a) {
+    auto matches = [](const QRegularExpression& re, const QString& v) { return freshRegex(re).match(v).hasMatch(); };
+    return !a.region.trimmed().isEmpty() && matches(ValidationService::addressTextRegex(), a.region)
+        && !a.city.trimmed().isEmpty() && matches(ValidationService::addressTextRegex(), a.city)
+        && !a.street.trimmed().isEmpty() && matches(ValidationService::addressTextRegex(), a.street)
+        && !a.house.trimmed().isEmpty() && matches(ValidationService::houseRegex(), a.house)
+        && (a.building.trimmed().isEmpty() || matches(ValidationService::houseRegex(), a.building))
+        && (a.apartment.trimmed().isEmpty() || matches(ValidationService::houseRegex(), a.apartment))
+        && !a.postalCode.trimmed().isEmpty() && matches(ValidationService::postalCodeRegex(), a.postalCode);
+}
+
+/** Клиент, как его проверял validateClient до общих выражений */
+static bool legacyValidateClient(const ClientRecord& r) {
+    auto name = [](const QString& v) { return freshRegex(ValidationService::nameRegex()).match(v).hasMatch(); };
+    return !r.lastName.trimmed().isEmpty() && name(r.lastName)
+        && !r.firstName.trimmed().isEmpty() && name(r.firstName)
+        && (r.middleName.trimmed().isEmpty() || name(r.middleName))
+        && legacyValidateAddress(r.registrationAddress) && legacyValidateAddress(r.actualAddress)
+        && !r.phone.trimmed().isEmpty() && !r.email.trimmed().isEmpty();
+}
+
+/** Заполняет агентство синтетическими клиентами, турами и заявками */
+static void fillAgency(TravelAgency& a, int clients, int tours, int requests) {
+    const Address reg = makeAddress();
+    for (int i = 0; i < clients; ++i) {
+        a.addClient("Иванов", "Иван", "Иванович", QString("+7 900 %1").arg(i),
+                    QString("client%1@mail.ru").arg(i), QDate(1980, 1, 1), reg, reg, "");
+    }
+    for (int i = 0; i < tours; ++i) {
+        a.addTour(QString("Тур %1").arg(i), "Турция", "Пляжный", QDate::currentDate().addDays(30),
+                  7, 30000.0, false, true, {"Самолёт", "Поезд"});
+    }
+    for (int i = 0; i < requests; ++i) {
+        a.createRequest(a.clients()[i % clients]->getId(), a.tours()[i % tours]->getId());
+    }
+}
+
+/** Добавляет в каждую заявку двух туристов с заполненными документами */
+static void fillTourists(TravelAgency& a) {
+    for (auto* r : a.requests()) {
+        r->addAdult("Петров", "Пётр", "Петрович");
+        r->addChild("Петрова", "Мария", "", QDate::currentDate().addYears(-8));
+        for (const auto& t : r->getTourists()) {
+            for (const auto& doc : t->documents()) {
+                doc->setField("number", "123456789");
+                doc->setField("series", "IV-АР");
+                doc->setStatus(DocumentStatus::Available);
+            }
+        }
+    }
+}
+
+/** Резидентная память процесса (VmRSS), байт; -1 — недоступно (не Linux) */
+static long long residentBytes() {
+    QFile f("/proc/self/status");
+    if (!f.open(QIODevice::ReadOnly)) return -1;
+    for (const QByteArray& line : f.readAll().split('\n')) {
+        if (!line.startsWith("VmRSS:")) continue;
+        return line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024;
+    }
+    return -1;
+}
+
+// --- Поиск заявки по id: хеш-индекс против линейного прохода ---
+void bench_lookup_by_id() {
+    for (int n : {1000, 10000, 100000, 200000}) {
+        TravelAgency a;
+        fillAgency(a, 100, 10, n);
+        const auto& reqs = a.requests();
+        const int firstId = reqs.front()->getId();
+
+        quint32 seed = 12345;
+        auto nextId = [&]() {
+            seed = seed * 1664525u + 1013904223u;
+            return firstId + static_cast<int>(seed % static_cast<quint32>(n));
+        };
+
+        const int hashLookups = 1000000;
+        QElapsedTimer timer;
+        timer.start();
+        qint64 found = 0;
+        for (int i = 0; i < hashLookups; ++i)
+            if (a.findRequestById(nextId())) ++found;
+        const double hashNs = double(timer.nsecsElapsed()) / hashLookups;
+
+        const int scanLookups = 2000;
+        timer.restart();
+        for (int i = 0; i < scanLookups; ++i) {
+            const int id = nextId();
+            for (auto* r : reqs)
+                if (r->getId() == id) { ++found; break; }
+        }
+        const double scanNs = double(timer.nsecsElapsed()) / scanLookups;
+
+        fprintf(stderr, "    n=%7d  индекс: %8.1f нс/поиск  линейно: %12.1f нс/поиск  (%lld)\n",
+                n, hashNs, scanNs, static_cast<long long>(found));
+    }
+}
+
+// --- Сохранение/загрузка: JSON против двоичного снимка ---
+void bench_snapshot_vs_json() {
+    QTemporaryDir dir;
+    const QString jsonPath = dir.filePath("agency.json");
+    const QString snapPath = dir.filePath("agency.snap");
+
+    TravelAgency a;
+    fillAgency(a, 5000, 200, 20000);
+    fillTourists(a);
+
+    QElapsedTimer timer;
+    timer.start();
+    a.saveToFile(jsonPath);
+    const qint64 jsonSave = timer.elapsed();
+    timer.restart();
+    a.saveSnapshot(snapPath);
+    const qint64 snapSave = timer.elapsed();
+
+    TravelAgency b, c;
+    timer.restart();
+    b.loadFromFile(jsonPath);
+    const qint64 jsonLoad = timer.elapsed();
+    timer.restart();
+    c.loadSnapshot(snapPath);
+    const qint64 snapLoad = timer.elapsed();
+
+    fprintf(stderr, "    JSON:   запись %6lld мс, чтение %6lld мс, %10lld байт\n",
+            static_cast<long long>(jsonSave), static_cast<long long>(jsonLoad),
+            static_cast<long long>(QFileInfo(jsonPath).size()));
+    fprintf(stderr, "    снимок: запись %6lld мс, чтение %6lld мс, %10lld байт\n",
+            static_cast<long long>(snapSave), static_cast<long long>(snapLoad),
+            static_cast<long long>(QFileInfo(snapPath).size()));
+}
+
+// --- validateDocument: реестр схем против сборки полей при каждом вызове ---
+void bench_validate_document() {
+    std::vector<Document> docs;
+    auto add = [&docs](DocumentType type, const QVariantMap& fields) {
+        Document d(type, DocumentStatus::Available);
+        d.setFields(fields);
+        docs.push_back(d);
+    };
+    add(DocumentType::Passport, {{"series", "4510"}, {"number", "123456"}, {"issuerCode", "770-001"}});
+    add(DocumentType::InternationalPassport, {{"number", "751234567"}});
+    add(DocumentType::BirthCertificate, {{"series", "IV-АР"}, {"number", "654321"}});
+    add(DocumentType::OMSPolicy, {{"number", "1234567890123452"}});
+    add(DocumentType::SNILS, {{"snils", "112-233-445 95"}});
+    add(DocumentType::INN, {{"inn", "500123456750"}});
+    add(DocumentType::Visa, {{"visaNumber", "AB12345"}});
+
+    const int rounds = 200000;
+    QElapsedTimer timer;
+    timer.start();
+    int valid = 0;
+    for (int i = 0; i < rounds; ++i)
+        if (DocumentService::validateDocument(docs[i % docs.size()])) ++valid;
+    const double cachedNs = double(timer.nsecsElapsed()) / rounds;
+
+    // Как было: копия описаний и новое выражение, компилируемое при каждом вызове
+    timer.restart();
+    for (int i = 0; i < rounds; ++i) {
+        const Document& d = docs[i % docs.size()];
+        const std::vector<DocumentField> defs = DocumentService::fieldsForType(d.getType());
+        bool ok = true;
+        for (const auto& def : defs) {
+            const QString value = d.field(def.key).toString().trimmed();
+            if (def.required && value.isEmpty()) { ok = false; break; }
+            const QRegularExpression fresh(def.regex.pattern());
+            if (!value.isEmpty() && !fresh.pattern().isEmpty() && !fresh.match(value).hasMatch()) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok) ++valid;
+    }
+    const double freshNs = double(timer.nsecsElapsed()) / rounds;
+
+    fprintf(stderr, "    реестр: %8.1f нс/документ  без кэша: %8.1f нс/документ  (%d)\n",
+            cachedNs, freshNs, valid);
+}
+
+// --- validateClients: общие выражения и пакет против построения regex на каждое поле ---
+void bench_validate_clients() {
+    const int count = 100000;
+    Address address = makeAddress();
+    address.building = "2";
+    address.apartment = "15";
+    const ClientRecord record{"Иванов", "Иван", "Иванович", "+7 900 000-00-00", "ivan@mail.ru",
+                              address, address};
+    const std::vector<ClientRecord> records(count, record);
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto results = ClientService::validateClients(records);
+    const qint64 batchMs = timer.elapsed();
+
+    // Как было: та же проверка всех полей, каждое поле компилирует своё выражение заново
+    timer.restart();
+    int valid = 0;
+    for (const ClientRecord& r : records)
+        if (legacyValidateClient(r)) ++valid;
+    const qint64 freshMs = timer.elapsed();
+
+    fprintf(stderr, "    %d клиентов: пакет %6lld мс, regex на каждую запись %6lld мс  (%zu/%d)\n",
+            count, static_cast<long long>(batchMs), static_cast<long long>(freshMs), results.size(), valid);
+}
+
+// --- Память документов: типизированные ячейки против QVariantMap ---
+void bench_document_memory() {
+    const int count = 1000000;
+    auto number = [](int i) { return QString("%1").arg(i % 1000000, 6, 10, QChar('0')); };
+    const QDate issued(2015, 3, 12);
+
+    long long before = residentBytes();
+    if (before < 0) {
+        fprintf(stderr, "    VmRSS недоступен, замер пропущен\n");
+        return;
+    }
+    std::vector<Document> typed;
+    typed.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        typed.emplace_back(DocumentType::Passport, DocumentStatus::Available);
+        Document& d = typed.back();
+        d.setField("series", QString::number(4500 + i % 100));
+        d.setField("number", number(i));
+        d.setField("issueDate", issued.addDays(i % 3650).toString(Qt::ISODate));
+        d.setField("issuerCode", "770-001");
+    }
+    const long long typedBytes = residentBytes() - before;
+
+    // Как было: тип, статус и QVariantMap со строками (даты — ISO-строки)
+    struct LegacyDocument {
+        DocumentType type;
+        DocumentStatus status;
+        QVariantMap fields;
+    };
+    before = residentBytes();
+    std::vector<LegacyDocument> legacy;
+    legacy.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        legacy.push_back({DocumentType::Passport, DocumentStatus::Available, {}});
+        QVariantMap& f = legacy.back().fields;
+        f.insert("series", QString::number(4500 + i % 100));
+        f.insert("number", number(i));
+        f.insert("issueDate", issued.addDays(i % 3650).toString(Qt::ISODate));
+        f.insert("issuerCode", QString("770-001"));
+    }
+    const long long legacyBytes = residentBytes() - before;
+
+    fprintf(stderr, "    %d паспортов: ячейки %6.1f байт/док, QVariantMap %6.1f байт/док\n",
+            count, double(typedBytes) / count, double(legacyBytes) / count);
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    fprintf(stderr, "Замеры: Туристическое агентство\n");
+    RUN_BENCH(bench_lookup_by_id);
+    RUN_BENCH(bench_snapshot_vs_json);
+    RUN_BENCH(bench_validate_document);
+    RUN_BENCH(bench_validate_clients);
+    RUN_BENCH(bench_document_memory);
+    return 0;
+}
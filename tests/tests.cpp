@@ -4,8 +4,25 @@
  * Проверка: валидация, расчёт стоимости, документы, CRUD.
  */
 #include "agency.h"
+#include "agency_table_models.h"
+#include "binary_snapshot.h"
+#include "client_service.h"
+#include "document_service.h"
+#include "search_controller.h"
 #include <QCoreApplication>
 #include <QDate>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
 #include <cstdio>
 #include <cassert>
 
@@ -139,6 +156,1281 @@ void test_document_warnings() {
     assert(!w.isEmpty());
 }
 
+// --- 10. TravelAgency: индексы по id синхронизируются с удалением ---
+void test_agency_lookup_index() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c = a.addClient("Петров", "Пётр", "", "3", "p@r.ru", QDate(1970,3,3), reg, reg, "");
+    Tour* t = a.addTour("Казань", "Россия", "Экскурсионный", QDate::currentDate().addDays(5),
+                        3, 15000.0, true, false, {"Поезд"});
+    TourRequest* r = a.createRequest(c->getId(), t->getId());
+    const int cid = c->getId(), tid = t->getId(), rid = r->getId();
+    assert(a.findClientById(cid) == c);
+    assert(a.findTourById(tid) == t);
+    assert(a.findRequestById(rid) == r);
+    assert(!a.deleteClient(cid));              // есть заявка
+    assert(a.deleteRequest(rid));
+    assert(a.findRequestById(rid) == nullptr);
+    assert(a.deleteClient(cid) && a.deleteTour(tid));
+    assert(a.findClientById(cid) == nullptr);
+    assert(a.findTourById(tid) == nullptr);
+    assert(a.clients().empty() && a.tours().empty());
+}
+
+// --- 11. TravelAgency: заявки по клиенту и по туру ---
+void test_agency_request_indexes() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c1 = a.addClient("Орлов", "Олег", "", "4", "o@r.ru", QDate(1981,4,4), reg, reg, "");
+    Client* c2 = a.addClient("Котов", "Кирилл", "", "5", "k@r.ru", QDate(1982,5,5), reg, reg, "");
+    Tour* t1 = a.addTour("Сочи", "Россия", "Пляжный", QDate::currentDate().addDays(9),
+                         7, 20000.0, true, false, {"Самолёт"});
+    Tour* t2 = a.addTour("Анталья", "Турция", "Пляжный", QDate::currentDate().addDays(20),
+                         10, 40000.0, false, false, {"Самолёт"});
+    TourRequest* r1 = a.createRequest(c1->getId(), t1->getId());
+    TourRequest* r2 = a.createRequest(c1->getId(), t2->getId());
+    TourRequest* r3 = a.createRequest(c2->getId(), t2->getId());
+    auto hist = a.getSalesHistoryForClient(c1->getId());
+    assert(hist.size() == 2 && hist[0] == r1 && hist[1] == r2);
+    assert(a.getRequestsForTour(t2->getId()).size() == 2);
+    assert(!a.deleteTour(t2->getId()));
+    assert(a.deleteRequest(r2->getId()) && a.deleteRequest(r3->getId()));
+    assert(a.getSalesHistoryForClient(c2->getId()).empty());
+    assert(a.getRequestsForTour(t2->getId()).empty());
+    assert(a.deleteTour(t2->getId()));
+    assert(a.deleteClient(c2->getId()));
+    assert(a.getSalesHistoryForClient(c1->getId()).size() == 1);
+}
+
+// --- 12. Поиск клиентов по индексу совпадает с прямым сравнением подстрок ---
+void test_search_clients_index() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c1 = a.addClient("Сидоров", "Иван", "", "+7 900 111-22-33", "Sid@Mail.ru", QDate(1975,2,2), reg, reg, "");
+    a.addClient("Сидорова", "Анна", "Петровна", "+7 900 444-55-66", "anna@yandex.ru", QDate(1979,3,3), reg, reg, "");
+    a.addClient("Ким", "Ли", "", "8 800 000", "kim@ya.ru", QDate(1990,1,1), reg, reg, "");
+
+    auto reference = [&a](const QString& query) {
+        std::vector<Client*> out;
+        const QString q = query.trimmed().toLower();
+        if (q.isEmpty()) return out;
+        for (auto* c : a.clients())
+            if (c->getFullName().toLower().contains(q) || c->getPhone().contains(q)
+                || c->getEmail().toLower().contains(q))
+                out.push_back(c);
+        return out;
+    };
+    const QStringList queries = {"сидор", "СИДОРОВА", "ан", "900", "mail", "ya.ru", "  ким ", "и", "zzz", "55-6"};
+    for (const QString& q : queries) assert(a.searchClients(q) == reference(q));
+
+    a.editClient(c1->getId(), "Смирнов", "Иван", "", "+7 900 111-22-33", "ivan@mail.ru",
+                 QDate(1975,2,2), reg, reg, "");
+    assert(a.searchClients("сидор").size() == 1);
+    assert(a.searchClients("смирн").size() == 1 && a.searchClients("смирн")[0] == c1);
+    for (const QString& q : queries) assert(a.searchClients(q) == reference(q));
+
+    a.deleteClient(c1->getId());
+    assert(a.searchClients("смирн").empty());
+    for (const QString& q : queries) assert(a.searchClients(q) == reference(q));
+}
+
+// --- 13. Потоковая загрузка читает тот же файл, что и обычная ---
+void test_streaming_load() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("agency.json");
+    {
+        TravelAgency a;
+        Address reg = makeAddress();
+        Client* c = a.addClient("Белов", "Борис", "", "6", "b@r.ru", QDate(1977,6,6), reg, reg, "");
+        Tour* t = a.addTour("Рим", "Италия", "Экскурсионный", QDate::currentDate().addDays(40),
+                            8, 60000.0, false, true, {"Самолёт"});
+        TourRequest* r = a.createRequest(c->getId(), t->getId());
+        r->addAdult("Белов", "Борис", "");
+        r->addChild("Белова", "Вера", "", QDate::currentDate().addYears(-7));
+        r->getTourists()[0]->documents()[0]->setStatus(DocumentStatus::Verified);
+        r->getTourists()[0]->documents()[0]->setField("number", "123456789");
+        assert(a.saveToFile(path));
+    }
+    // Заявки записаны после туров — потоковая загрузка читает файл один раз
+    QFile saved(path);
+    assert(saved.open(QIODevice::ReadOnly));
+    const QByteArray text = saved.readAll();
+    saved.close();
+    assert(text.indexOf("\"tours\"") >= 0 && text.indexOf("\"tours\"") < text.indexOf("\"requests\""));
+
+    TravelAgency dom, stream;
+    assert(dom.loadFromFile(path));
+    qint64 lastDone = -1, lastTotal = 0;
+    assert(stream.loadFromFileStreaming(path, [&](qint64 done, qint64 total) {
+        assert(done >= lastDone);
+        lastDone = done;
+        lastTotal = total;
+    }));
+    assert(lastDone == lastTotal && lastTotal > 0);
+    assert(stream.clients().size() == 1 && stream.tours().size() == 1 && stream.requests().size() == 1);
+    const TourRequest* a = dom.requests()[0];
+    const TourRequest* b = stream.requests()[0];
+    assert(a->getId() == b->getId() && a->getTourists().size() == b->getTourists().size());
+    assert(b->getTourists()[0]->documents()[0]->getStatus() == DocumentStatus::Verified);
+    assert(b->getTourists()[0]->documents()[0]->field("number").toString() == "123456789");
+    assert(a->calculateTotalCost() == b->calculateTotalCost());
+
+    // Старый формат: только fullName, ключи в произвольном порядке
+    const QString legacyPath = dir.filePath("legacy.json");
+    QFile f(legacyPath);
+    assert(f.open(QIODevice::WriteOnly));
+    f.write(R"({"tours": [{"id": 7, "name": "Сочи", "country": "Россия", "tourType": "Пляжный",
+                "startDate": "2030-07-01", "durationDays": 7, "basePrice": 1000, "isDomestic": true}],
+               "comment": {"note": "ключ \"в кавычках\" и скобки ]}"},
+               "requests": [{"id": 9, "clientId": 5, "tourId": 7,
+                             "tourists": [{"fullName": "Ильин Илья Ильич"}]}],
+               "clients": [{"id": 5, "fullName": "Ильин Илья Ильич", "phone": "1", "email": "i@i.ru"}]})");
+    f.close();
+    TravelAgency legacy;
+    QString err;
+    assert(legacy.loadFromFileStreaming(legacyPath, {}, &err));
+    assert(legacy.findClientById(5)->getMiddleName() == "Ильич");
+    assert(legacy.findRequestById(9)->getTourists()[0]->getFirstName() == "Илья");
+
+    // Обрезанный файл — ошибка, а не падение
+    assert(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write(R"({"clients": [{"id": 1, "lastName": "Обрыв")");
+    f.close();
+    assert(!legacy.loadFromFileStreaming(legacyPath, {}, &err) && !err.isEmpty());
+
+    // Пропущенная или лишняя запятая между членами — ошибка, а не догадка
+    for (const char* malformed : {R"({"a": 1 "b": 2})", R"({"clients": [1 2]})",
+                                  R"({"clients": [], "tours": [],})", R"({"clients": [,]})"}) {
+        assert(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        f.write(malformed);
+        f.close();
+        err.clear();
+        assert(!legacy.loadFromFileStreaming(legacyPath, {}, &err) && !err.isEmpty());
+    }
+}
+
+// --- 14. Двоичный снимок: сохранение и загрузка без потерь ---
+void test_binary_snapshot() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("agency.snap");
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c = a.addClient("Титов", "Тимур", "Тимурович", "7", "t@r.ru", QDate(1988,8,8), reg, reg, "комментарий");
+    Tour* t = a.addTour("Сочи", "Россия", "Активный", QDate::currentDate().addDays(15),
+                        5, 12500.5, true, false, {"Поезд", "Самолёт"});
+    TourRequest* r = a.createRequest(c->getId(), t->getId());
+    r->setStatus(RequestStatus::Paid);
+    r->setTravelMode("Поезд");
+    r->setTravelClass("Плацкарт");
+    r->addAdult("Титов", "Тимур", "");
+    r->addChild("Титова", "Таня", "", QDate::currentDate().addYears(-4));
+    r->addAnimal("Кот", 3.5, "Переноска");
+    r->getTourists()[0]->setHasBenefit(true);
+    r->getTourists()[0]->documents()[0]->setField("series", "1234");
+    r->getTourists()[0]->documents()[0]->setStatus(DocumentStatus::Available);
+    assert(a.saveSnapshot(path));
+    assert(BinarySnapshot::isSnapshotFile(path));
+
+    TravelAgency b;
+    QString err;
+    assert(b.loadSnapshot(path, &err));
+    const Client* bc = b.findClientById(c->getId());
+    assert(bc && bc->getFullName() == c->getFullName() && bc->getComments() == "комментарий");
+    assert(bc->getRegistrationAddress().city == "Москва");
+    const Tour* bt = b.findTourById(t->getId());
+    assert(bt && bt->getBasePrice() == 12500.5 && bt->getTravelModes() == t->getTravelModes());
+    const TourRequest* br = b.findRequestById(r->getId());
+    assert(br && br->getStatus() == RequestStatus::Paid && br->getTravelClass() == "Плацкарт");
+    assert(br->getTourists().size() == 2 && br->getTourists()[0]->hasBenefit());
+    assert(br->getTourists()[0]->documents()[0]->field("series").toString() == "1234");
+    assert(br->getDocuments().size() == r->getDocuments().size());
+    assert(br->calculateTotalCost() == r->calculateTotalCost());
+
+    // JSON-файл снимком не считается
+    const QString jsonPath = dir.filePath("agency.json");
+    assert(a.saveToFile(jsonPath));
+    assert(!BinarySnapshot::isSnapshotFile(jsonPath));
+    assert(!b.loadSnapshot(jsonPath, &err) && !err.isEmpty());
+}
+
+// --- 15. Журнал изменений: правки переживают перезапуск, сжатие, обрыв записи ---
+void test_change_journal() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("store.snap");
+    const QString journalPath = TravelAgency::journalPathFor(path);
+    Address reg = makeAddress();
+    int clientId = 0, tourId = 0, requestId = 0, removedId = 0;
+    {
+        TravelAgency a;
+        assert(a.openStore(path));
+        Client* c = a.addClient("Орлов", "Олег", "", "8", "o@r.ru", QDate(1975,5,5), reg, reg, "");
+        Client* gone = a.addClient("Лишний", "Лев", "", "9", "l@r.ru", QDate(1970,1,1), reg, reg, "");
+        Tour* t = a.addTour("Казань", "Россия", "Экскурсионный", QDate::currentDate().addDays(20),
+                            3, 9000, true, false, {"Поезд"});
+        TourRequest* r = a.createRequest(c->getId(), t->getId());
+        r->addAdult("Орлов", "Олег", "");
+        r->setStatus(RequestStatus::Completed);
+        a.noteRequestChanged(r->getId());
+        assert(a.editClient(c->getId(), "Орлов", "Олег", "Олегович", "8", "o@r.ru",
+                            QDate(1975,5,5), reg, reg, "постоянный"));
+        removedId = gone->getId();
+        assert(a.deleteClient(removedId));
+        clientId = c->getId(); tourId = t->getId(); requestId = r->getId();
+        // Снимка ещё нет: всё только в журнале
+        assert(!QFile::exists(path) && QFile::exists(journalPath));
+    }
+
+    auto check = [&](TravelAgency& b) {
+        assert(b.findClientById(clientId)->getMiddleName() == "Олегович");
+        assert(b.findClientById(clientId)->getComments() == "постоянный");
+        assert(!b.findClientById(removedId));
+        assert(b.findTourById(tourId)->getName() == "Казань");
+        const TourRequest* br = b.findRequestById(requestId);
+        assert(br && br->getStatus() == RequestStatus::Completed && br->getTourists().size() == 1);
+        assert(b.getSalesHistoryForClient(clientId).size() == 1);
+    };
+
+    {
+        TravelAgency b;
+        QString err;
+        assert(b.openStore(path, &err));
+        check(b);
+        assert(b.compactStore(&err));
+        assert(QFile::exists(path) && QFileInfo(journalPath).size() == 0);
+    }
+
+    // Оборванная последняя строка отбрасывается, остальное применяется
+    QFile f(journalPath);
+    assert(f.open(QIODevice::WriteOnly | QIODevice::Append));
+    f.write(R"({"op":"deleteTour","id":)");
+    f.close();
+    {
+        TravelAgency c;
+        QString err;
+        assert(c.openStore(path, &err));
+        check(c);
+        assert(c.deleteRequest(requestId));
+    }
+    {
+        TravelAgency d;
+        assert(d.openStore(path));
+        assert(!d.findRequestById(requestId) && d.findClientById(clientId));
+    }
+}
+
+// --- 16. Копия агентства для фонового сохранения ---
+void test_agency_clone() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c = a.addClient("Зуев", "Захар", "", "10", "z@r.ru", QDate(1982,2,2), reg, reg, "");
+    Tour* t = a.addTour("Рим", "Италия", "Экскурсионный", QDate::currentDate().addDays(40),
+                        8, 80000, false, true, {"Самолёт"});
+    TourRequest* r = a.createRequest(c->getId(), t->getId());
+    r->addAdult("Зуев", "Захар", "");
+    r->getTourists()[0]->documents()[0]->setField("number", "111");
+    r->setStatus(RequestStatus::Paid);
+    const int requestId = r->getId();
+
+    std::unique_ptr<TravelAgency> copy = a.clone();
+    // Правки оригинала после снятия копии её не затрагивают
+    a.editClient(c->getId(), "Зуев", "Захар", "Петрович", "10", "z@r.ru", QDate(1982,2,2), reg, reg, "");
+    r->addChild("Зуева", "Зоя", "", QDate::currentDate().addYears(-3));
+    r->getTourists()[0]->documents()[0]->setField("number", "222");
+    assert(a.deleteRequest(requestId));
+
+    const TourRequest* cr = copy->findRequestById(requestId);
+    assert(cr && cr->getStatus() == RequestStatus::Paid && cr->getTourists().size() == 1);
+    assert(cr->getTourists()[0]->documents()[0]->field("number").toString() == "111");
+    assert(cr->getClient() == copy->findClientById(c->getId()));
+    assert(copy->findClientById(c->getId())->getMiddleName().isEmpty());
+    assert(copy->getSalesHistoryForClient(c->getId()).size() == 1);
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("copy.json");
+    qint64 last = -1, lastTotal = 0;
+    assert(copy->saveToFile(path, [&](qint64 done, qint64 total) {
+        assert(done >= last);
+        last = done;
+        lastTotal = total;
+    }));
+    assert(last == 3 && lastTotal == 3);
+    TravelAgency b;
+    assert(b.loadFromFile(path) && b.requests().size() == 1);
+}
+
+// --- 17. Параллельный разбор заявок при загрузке: порядок и id как в файле ---
+void test_parallel_request_load() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c = a.addClient("Юдин", "Юрий", "", "11", "u@r.ru", QDate(1979,9,9), reg, reg, "");
+    Tour* t = a.addTour("Минск", "Беларусь", "Экскурсионный", QDate::currentDate().addDays(12),
+                        4, 15000, false, false, {"Поезд"});
+    for (int i = 0; i < 600; ++i) {
+        TourRequest* r = a.createRequest(c->getId(), t->getId());
+        r->addAdult("Юдин", "Юрий", "");
+        if (i % 3 == 0) r->addChild("Юдина", "Юлия", "", QDate::currentDate().addYears(-6));
+        r->getTourists()[0]->documents()[0]->setField("number", QString::number(i));
+    }
+    // Пропуски в id: удалённые заявки
+    std::vector<int> removed;
+    for (int i = 0; i < 600; i += 7) removed.push_back(a.requests()[i]->getId());
+    for (int id : removed) assert(a.deleteRequest(id));
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("many.json");
+    assert(a.saveToFile(path));
+    TravelAgency b;
+    QString err;
+    assert(b.loadFromFile(path, &err));
+    assert(b.requests().size() == a.requests().size());
+    int maxId = 0;
+    for (size_t i = 0; i < a.requests().size(); ++i) {
+        const TourRequest* ra = a.requests()[i];
+        const TourRequest* rb = b.requests()[i];
+        assert(ra->getId() == rb->getId());
+        assert(rb->getTourists().size() == ra->getTourists().size());
+        assert(rb->getTourists()[0]->documents()[0]->field("number") ==
+               ra->getTourists()[0]->documents()[0]->field("number"));
+        maxId = std::max(maxId, rb->getId());
+    }
+    assert(b.getRequestsForTour(t->getId()).size() == a.requests().size());
+    // Счётчик id продолжает нумерацию после загруженных заявок
+    assert(b.createRequest(c->getId(), t->getId())->getId() > maxId);
+}
+
+// --- 18. Висячие ссылки заявок при загрузке — замечания, а не молчаливый пропуск ---
+void test_load_dangling_refs() {
+    QTemporaryDir dir;
+    const QString path = dir.filePath("dangling.json");
+    QFile f(path);
+    assert(f.open(QIODevice::WriteOnly));
+    f.write(R"({
+        "clients": [{"id": 21, "lastName": "Фомин", "firstName": "Фёдор", "phone": "1",
+                     "email": "f@r.ru", "dateOfBirth": "1980-01-01"}],
+        "tours": [{"id": 31, "name": "Тур", "country": "Россия", "tourType": "Пляжный",
+                   "startDate": "2030-06-01", "durationDays": 7, "basePrice": 1000,
+                   "isDomestic": true, "visaRequired": false}],
+        "requests": [{"id": 41, "clientId": 21, "tourId": 31},
+                     {"id": 42, "clientId": 99, "tourId": 31},
+                     {"id": 43, "clientId": 98, "tourId": 97}]
+    })");
+    f.close();
+
+    for (int streaming = 0; streaming < 2; ++streaming) {
+        TravelAgency a;
+        QString err;
+        assert(streaming ? a.loadFromFileStreaming(path, {}, &err) : a.loadFromFile(path, &err));
+        assert(a.requests().size() == 1 && a.findRequestById(41));
+        const auto& issues = a.loadIssues();
+        assert(issues.size() == 3);
+        assert(issues[0].kind == LoadIssue::Kind::MissingClient && issues[0].requestId == 42 &&
+               issues[0].referencedId == 99);
+        assert(issues[1].requestId == 43 && issues[1].referencedId == 98);
+        assert(issues[2].kind == LoadIssue::Kind::MissingTour && issues[2].referencedId == 97);
+        assert(issues[2].message().contains("97"));
+    }
+}
+
+// --- 19. Ленивая загрузка подробностей заявок ---
+void test_lazy_request_details() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c = a.addClient("Ершов", "Егор", "", "12", "e@r.ru", QDate(1987,7,7), reg, reg, "");
+    Tour* t = a.addTour("Анталья", "Турция", "Пляжный", QDate::currentDate().addDays(25),
+                        10, 50000, false, false, {"Самолёт"});
+    for (int i = 0; i < 2; ++i) {
+        TourRequest* r = a.createRequest(c->getId(), t->getId());
+        r->addAdult("Ершов", "Егор", "");
+        r->addChild("Ершова", "Ева", "", QDate::currentDate().addYears(-7));
+        r->addAnimal("Собака", 12, "Багаж");
+        r->getTourists()[0]->documents()[0]->setField("number", QString("77%1").arg(i));
+    }
+    const int firstId = a.requests()[0]->getId();
+    const int secondId = a.requests()[1]->getId();
+    const double cost = a.requests()[0]->calculateTotalCost();
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("lazy.json");
+    assert(a.saveToFile(path));
+
+    for (int streaming = 0; streaming < 2; ++streaming) {
+        TravelAgency b;
+        b.setLazyRequestDetails(true);
+        QString err;
+        assert(streaming ? b.loadFromFileStreaming(path, {}, &err) : b.loadFromFile(path, &err));
+        TourRequest* first = b.findRequestById(firstId);
+        TourRequest* second = b.findRequestById(secondId);
+        assert(first->hasPendingDetails() && second->hasPendingDetails());
+        // Отложены только вложенные массивы; заголовок и сводка "totals" уже разобраны
+        assert(second->pendingDetails().contains("\"tourists\"") && !second->pendingDetails().contains("clientId"));
+        assert(second->totals().adults == 1 && second->totals().children == 1);
+        // Заголовок и стоимость — без разбора подробностей
+        assert(first->getTravelMode() == "Самолёт");
+        assert(first->calculateTotalCost() == cost);
+        assert(first->hasPendingDetails());
+
+        // Первое обращение к туристам разбирает только эту заявку
+        assert(first->getTourists().size() == 2);
+        assert(!first->hasPendingDetails() && second->hasPendingDetails());
+        assert(first->getTourists()[0]->documents()[0]->field("number").toString() == "770");
+        assert(first->getAnimals().size() == 1 && first->calculateTotalCost() == cost);
+
+        // Неразобранная заявка переживает сохранение в JSON, снимок и копию
+        const QString jsonCopy = dir.filePath("lazy-copy.json");
+        const QString snapCopy = dir.filePath("lazy-copy.snap");
+        assert(b.saveToFile(jsonCopy) && b.saveSnapshot(snapCopy));
+        assert(second->hasPendingDetails());
+        TravelAgency fromJson, fromSnap;
+        assert(fromJson.loadFromFile(jsonCopy) && fromSnap.loadSnapshot(snapCopy));
+        std::unique_ptr<TravelAgency> copy = b.clone();
+        for (TravelAgency* x : {&fromJson, &fromSnap, copy.get()}) {
+            const TourRequest* r = x->findRequestById(secondId);
+            assert(r->calculateTotalCost() == cost);
+            assert(r->getTourists()[0]->documents()[0]->field("number").toString() == "771");
+        }
+    }
+}
+
+// --- 20. Импорт/экспорт заявок в JSONL с ошибками по строкам ---
+void test_requests_jsonl() {
+    TravelAgency a;
+    Address reg = makeAddress();
+    Client* c = a.addClient("Щукин", "Семён", "", "13", "s@r.ru", QDate(1984,4,4), reg, reg, "");
+    Tour* t = a.addTour("Калининград", "Россия", "Экскурсионный", QDate::currentDate().addDays(18),
+                        4, 20000, true, false, {"Поезд"});
+    TourRequest* r1 = a.createRequest(c->getId(), t->getId());
+    r1->addAdult("Щукин", "Семён", "");
+    TourRequest* r2 = a.createRequest(c->getId(), t->getId());
+    r2->addAdult("Щукина", "Софья", "");
+    r2->addChild("Щукин", "Саша", "", QDate::currentDate().addYears(-5));
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("requests.jsonl");
+    assert(a.exportRequestsJsonl(path));
+
+    std::unique_ptr<TravelAgency> b = a.clone();
+    assert(b->deleteRequest(r1->getId()) && b->deleteRequest(r2->getId()));
+    JsonlImportResult result;
+    QString err;
+    assert(b->importRequestsJsonl(path, &result, {}, &err));
+    assert(result.imported == 2 && result.errors.empty());
+    assert(b->findRequestById(r2->getId())->getTourists().size() == 2);
+    assert(b->getSalesHistoryForClient(c->getId()).size() == 2);
+
+    // Повторный импорт: те же id уже заняты
+    assert(b->importRequestsJsonl(path, &result));
+    assert(result.imported == 0 && result.errors.size() == 2 && result.errors[1].line == 2);
+
+    QFile f(dir.filePath("partner.jsonl"));
+    assert(f.open(QIODevice::WriteOnly));
+    const QByteArray tourId = QByteArray::number(t->getId());
+    const QByteArray clientId = QByteArray::number(c->getId());
+    f.write("{\"clientId\": " + clientId + ", \"tourId\": " + tourId +
+            ", \"tourists\": [{\"lastName\": \"Щукин\", \"firstName\": \"Иван\"}]}\n");
+    f.write("{не json\n");
+    f.write("\n");
+    f.write("{\"clientId\": 999999, \"tourId\": " + tourId + "}\n");
+    // Оплаченная заявка без проверенных документов не проходит RequestService
+    f.write("{\"clientId\": " + clientId + ", \"tourId\": " + tourId +
+            ", \"status\": 2, \"tourists\": [{\"lastName\": \"Щукин\", \"firstName\": \"Пётр\"}]}\n");
+    f.write("{\"clientId\": " + clientId + ", \"tourId\": " + tourId + ", \"tourists\": []}\n");
+    f.close();
+
+    const size_t before = b->requests().size();
+    assert(b->importRequestsJsonl(f.fileName(), &result));
+    assert(result.imported == 1 && b->requests().size() == before + 1);
+    assert(result.errors.size() == 4);
+    assert(result.errors[0].line == 2 && result.errors[0].message.startsWith("Ошибка JSON"));
+    assert(result.errors[1].line == 4 && result.errors[1].message.contains("999999"));
+    assert(result.errors[2].line == 5);
+    assert(result.errors[3].line == 6);
+}
+
+// --- 21. Реестр схем документов: один экземпляр на тип, выражения готовы ---
+void test_document_schema_registry() {
+    for (int t = 0; t < DOCUMENT_TYPE_COUNT; ++t) {
+        const auto type = static_cast<DocumentType>(t);
+        const auto& first = DocumentService::fieldsForType(type);
+        assert(&first == &DocumentService::fieldsForType(type));
+        assert(!first.empty());
+        for (const auto& def : first) assert(def.regex.isValid());
+    }
+    Document passport(DocumentType::Passport);
+    passport.setField("series", "4510");
+    passport.setField("number", "12345");
+    QString err;
+    assert(!DocumentService::validateDocument(passport, &err) && err.contains("Номер"));
+    passport.setField("number", "123456");
+    assert(DocumentService::validateDocument(passport) && DocumentService::isMinimumFilled(passport));
+}
+
+// --- 22. Контрольные числа СНИЛС/ИНН/ОМС и пакетная проверка ---
+void test_document_checksums() {
+    assert(DocumentService::isValidSnils("112-233-445 95"));
+    assert(!DocumentService::isValidSnils("112-233-445 96"));
+    assert(DocumentService::isValidSnils("001-001-998 00"));  // старые номера без контроля
+    assert(DocumentService::isValidInn("500123456750"));
+    assert(!DocumentService::isValidInn("500123456751"));
+    assert(!DocumentService::isValidInn("50012345675"));
+    assert(DocumentService::isValidOms("1234567890123452"));
+    assert(!DocumentService::isValidOms("1234567890123456"));
+
+    Document snils(DocumentType::SNILS);
+    snils.setField("snils", "112-233-445 96");
+    QString err;
+    assert(!DocumentService::validateDocument(snils, &err) && err.contains("контрольная"));
+    snils.setField("snils", "112-233-44595");
+    assert(!DocumentService::validateDocument(snils, &err) && err.contains("формат"));
+
+    // Пакет больше порога параллельной проверки: порядок результатов сохраняется
+    std::vector<Document> docs;
+    for (int i = 0; i < 600; ++i) {
+        Document d(DocumentType::OMSPolicy);
+        d.setField("number", i % 3 ? "1234567890123452" : "1234567890123456");
+        docs.push_back(d);
+    }
+    std::vector<const Document*> batch;
+    for (const auto& d : docs) batch.push_back(&d);
+    batch.push_back(nullptr);
+    const std::vector<QString> results = DocumentService::validateDocuments(batch);
+    assert(results.size() == batch.size());
+    for (int i = 0; i < 600; ++i) assert(results[i].isEmpty() == (i % 3 != 0));
+    assert(results.back().isEmpty());
+}
+
+// --- 23. Пакетная проверка клиентов: ошибки по записям и полям ---
+void test_validate_clients_batch() {
+    assert(&ValidationService::nameRegex() == &ValidationService::nameRegex());
+
+    ClientRecord good{"Иванов", "Иван", "", "+7 900 000-00-00", "ivan@mail.ru", makeAddress(), makeAddress()};
+    ClientRecord bad = good;
+    bad.firstName = "Ivan";
+    bad.email = " ";
+    bad.actualAddress.postalCode = "12345";
+    bad.actualAddress.building = "корп";
+
+    std::vector<ClientRecord> records;
+    for (int i = 0; i < 500; ++i) records.push_back(i % 5 ? good : bad);
+    const auto results = ClientService::validateClients(records);
+    assert(results.size() == records.size());
+    for (int i = 0; i < 500; ++i) assert(results[i].empty() == (i % 5 != 0));
+
+    std::vector<QString> fields;
+    for (const FieldError& e : results[0]) fields.push_back(e.field);
+    assert(fields == (std::vector<QString>{"firstName", "actualAddress.building",
+                                           "actualAddress.postalCode", "email"}));
+
+    // Одиночная проверка по-прежнему сообщает первую ошибку
+    QString err;
+    assert(!ClientService::validateClient(bad.lastName, bad.firstName, bad.middleName, bad.phone, bad.email,
+                                          bad.registrationAddress, bad.actualAddress, &err));
+    assert(err == results[0].front().message);
+}
+
+// --- 24. Инкрементальная перегенерация документов: объекты остаются на месте ---
+void test_incremental_documents() {
+    Address reg = makeAddress();
+    Client cl("К", "Л", "", "1", "a@a.ru", QDate(1985,1,1), reg, reg, "");
+    Tour tr("Загран", "Турция", "Пляж", QDate::currentDate().addDays(60), 7, 50000.0, false, true);
+    TourRequest r(&cl, &tr);
+    for (int i = 0; i < 40; ++i) r.addAdult("Турист", "Групповой", "");
+    assert(r.getDocuments().size() == DocumentService::requiredRequestDocuments(r).size());
+
+    Document* passport = r.getTourists()[0]->documents()[0].get();
+    passport->setField("number", "751234567");
+    Document* voucher = r.getDocuments()[0].get();
+    r.addChild("Ребёнок", "Турист", "", QDate::currentDate().addYears(-5));
+    r.addAnimal("Кот", 3.0, "Переноска");
+    r.removeTourist(5);
+    assert(r.getTourists()[0]->documents()[0].get() == passport);
+    assert(passport->field("number") == "751234567");
+    assert(r.getDocuments()[0].get() == voucher);
+    assert(r.getDocuments().back()->getType() == DocumentType::VeterinaryPassport);
+
+    // Смена льготы дополняет документы только этого туриста
+    const size_t before = r.getTourists()[1]->documents().size();
+    r.tourist(1)->setHasBenefit(true);
+    r.regenerateTouristDocuments(1);
+    assert(r.getTourists()[1]->documents().size() == before + 1);
+    assert(r.getTourists()[2]->documents().size() == before);
+    r.regenerateDocuments();
+    assert(r.getTourists()[0]->documents()[0].get() == passport);
+}
+
+// --- 25. Правила документов: таблица по умолчанию и правила из файла ---
+void test_document_rules() {
+    Address reg = makeAddress();
+    Client cl("К", "Л", "", "1", "a@a.ru", QDate(1985,1,1), reg, reg, "");
+    Tour egypt("Пирамиды", "Египет", "Экскурсионный", QDate::currentDate().addDays(30), 7, 40000.0, false, false);
+    TourRequest r(&cl, &egypt);
+    r.addChild("Ребёнок", "Турист", "", QDate::currentDate().addYears(-6));
+    const Tourist& child = *r.getTourists()[0];
+    const DocumentMask expected = documentBit(DocumentType::InternationalPassport)
+        | documentBit(DocumentType::BirthCertificate) | documentBit(DocumentType::ConsentForChildDeparture);
+    assert(DocumentService::requiredPersonalMask(r, child) == expected);
+
+    // Недостающее — требуемое минус проверенное
+    for (auto& d : r.tourist(0)->documents()) d->setStatus(DocumentStatus::Verified);
+    for (auto& d : r.getDocuments()) d->setStatus(DocumentStatus::Verified);
+    assert(DocumentService::missingDocumentsSummary(r).isEmpty());
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("rules.json");
+    QFile f(path);
+    assert(f.open(QIODevice::WriteOnly));
+    f.write(R"({"rules": [{"scope": "tourist", "when": {"country": "египет", "child": false},
+                           "require": ["Visa"]}]})");
+    f.close();
+    DocumentRules rules = DocumentRules::defaults();
+    QString err;
+    assert(rules.loadFile(path, &err));
+
+    const DocumentRules saved = DocumentRules::active();
+    DocumentRules::setActive(rules);
+    r.addAdult("Взрослый", "Турист", "");
+    const Tourist& adult = *r.getTourists()[1];
+    assert(DocumentService::requiredPersonalMask(r, adult) & documentBit(DocumentType::Visa));
+    assert(!(DocumentService::requiredPersonalMask(r, child) & documentBit(DocumentType::Visa)));
+    assert(DocumentService::missingDocumentsSummary(r).size() == 2);
+    DocumentRules::setActive(saved);
+
+    assert(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write(R"({"rules": [{"scope": "tourist", "when": {}, "require": ["Passprt"]}]})");
+    f.close();
+    const size_t before = rules.rules().size();
+    assert(!rules.loadFile(path, &err) && err.contains("Passprt"));
+    assert(rules.rules().size() == before);
+}
+
+// --- 26. Кэш полноты документов: сбрасывается изменениями заявки ---
+void test_completeness_cache() {
+    Address reg = makeAddress();
+    Client cl("К", "Л", "", "1", "a@a.ru", QDate(1985,1,1), reg, reg, "");
+    Tour tr("Т", "РФ", "Пляж", QDate::currentDate().addDays(10), 5, 10000.0, true, false);
+    TourRequest r(&cl, &tr);
+    r.addAdult("Иванов", "Иван", "");
+    assert(!r.isComplete());
+    const QStringList& first = r.missingDocumentsSummary();
+    assert(&first == &r.missingDocumentsSummary());  // текст строится один раз
+
+    const Tourist& adult = *r.getTourists()[0];
+    for (const auto& d : adult.documents()) d->setStatus(DocumentStatus::Verified);
+    for (const auto& d : r.getDocuments()) d->setStatus(DocumentStatus::Verified);
+    assert(r.isComplete() && r.missingDocumentsSummary().isEmpty());
+    assert(r.missingTouristDocuments().size() == 1 && r.missingTouristDocuments()[0] == 0);
+
+    // Статус документа, льгота туриста, новый турист, животное — каждый сбрасывает кэш
+    adult.documents()[0]->setStatus(DocumentStatus::Available);
+    assert(!r.isComplete() && r.missingTouristDocuments()[0] == documentBit(DocumentType::Passport));
+    adult.documents()[0]->setStatus(DocumentStatus::Verified);
+    assert(r.isComplete());
+    r.getTourists()[0]->setHasBenefit(true);
+    r.regenerateTouristDocuments(0);
+    assert(r.missingTouristDocuments()[0] == documentBit(DocumentType::BenefitDocument));
+    r.getTourists()[0]->setHasBenefit(false);
+    assert(r.isComplete());
+    r.addAnimal("Кот", 3.0, "Переноска");
+    assert(r.missingRequestDocuments() == documentBit(DocumentType::VeterinaryPassport));
+
+    // Копия заявки следит за своими документами
+    std::unique_ptr<TourRequest> copy(r.clone(&cl, &tr));
+    for (const auto& d : copy->getDocuments()) d->setStatus(DocumentStatus::Verified);
+    assert(copy->isComplete() && !r.isComplete());
+
+    // Смена правил тоже сбрасывает кэш
+    const DocumentRules saved = DocumentRules::active();
+    DocumentRules rules = DocumentRules::defaults();
+    DocumentRules::Rule snils;
+    snils.documents = documentBit(DocumentType::SNILS);
+    rules.addRule(snils);
+    DocumentRules::setActive(rules);
+    assert(!copy->isComplete() && copy->missingDocumentsSummary().first().contains("СНИЛС"));
+    DocumentRules::setActive(saved);
+    assert(copy->isComplete());
+}
+
+// --- 27. Аудит документов по агентству: отбор по туру и окну вылета ---
+void test_document_audit() {
+    TravelAgency a;
+    const Address reg = makeAddress();
+    Client* c = a.addClient("Аудитов", "Игорь", "", "1", "a@a.ru", QDate(1980,1,1), reg, reg, "");
+    const QDate soon = QDate::currentDate().addDays(5);
+    Tour* near = a.addTour("Ближний", "Турция", "Пляжный", soon, 7, 30000.0, false, true, {"Самолёт"});
+    Tour* far = a.addTour("Дальний", "РФ", "Пляжный", soon.addDays(60), 7, 20000.0, true, false, {"Поезд"});
+    std::vector<int> nearIds;
+    for (int i = 0; i < 100; ++i) {
+        TourRequest* r = a.createRequest(c->getId(), (i % 2 ? far : near)->getId());
+        r->addAdult("Турист", "Первый", "");
+        if (i % 2 == 0) nearIds.push_back(r->getId());
+        if (i % 4 == 0) {  // каждая вторая заявка на ближний тур — полностью проверена
+            for (const auto& d : r->getTourists()[0]->documents()) d->setStatus(DocumentStatus::Verified);
+            for (const auto& d : r->getDocuments()) d->setStatus(DocumentStatus::Verified);
+        }
+    }
+    TourRequest* canceled = a.findRequestById(nearIds[1]);
+    canceled->setStatus(RequestStatus::Canceled);
+    canceled->getTourists()[0]->documents()[0]->setStatus(DocumentStatus::Available);
+
+    const auto all = a.auditDocuments();
+    std::unordered_set<int> withIssues;
+    for (const auto& e : all) withIssues.insert(e.requestId);
+    assert(withIssues.size() == 100 - 25 - 1);
+
+    DocumentAuditFilter window;
+    window.departureFrom = QDate::currentDate();
+    window.departureTo = QDate::currentDate().addDays(7);
+    window.includeCanceled = true;
+    const auto nearOnly = a.auditDocuments(window);
+    for (const auto& e : nearOnly)
+        assert(a.findRequestById(e.requestId)->getTour() == near);
+
+    DocumentAuditFilter byTour;
+    byTour.tourId = near->getId();
+    byTour.includeCanceled = true;
+    bool sawCanceled = false;
+    for (const auto& e : a.auditDocuments(byTour)) {
+        if (e.requestId != canceled->getId() || e.touristIndex != 0) continue;
+        sawCanceled = true;
+        assert(e.unverified == documentBit(DocumentType::InternationalPassport));
+        assert(e.missing & documentBit(DocumentType::Visa));
+    }
+    assert(sawCanceled);
+}
+
+// --- 28. Индекс сроков документов: поездка и истечение в ближайшие дни ---
+void test_document_expiry_index() {
+    TravelAgency a;
+    const Address reg = makeAddress();
+    Client* c = a.addClient("Сроков", "Пётр", "", "1", "a@a.ru", QDate(1980,1,1), reg, reg, "");
+    const QDate start = QDate::currentDate().addDays(20);
+    Tour* t = a.addTour("Виза", "Китай", "Экскурсионный", start, 10, 50000.0, false, true, {"Самолёт"});
+    TourRequest* r = a.createRequest(c->getId(), t->getId());
+    r->addAdult("Сроков", "Пётр", "");
+    auto findDoc = [](const std::vector<std::unique_ptr<Document>>& docs, DocumentType type) {
+        for (const auto& d : docs) if (d->getType() == type) return d.get();
+        return static_cast<Document*>(nullptr);
+    };
+    Document* visa = findDoc(r->getTourists()[0]->documents(), DocumentType::Visa);
+    Document* policy = findDoc(r->getDocuments(), DocumentType::InsurancePolicy);
+    assert(visa && policy);
+    visa->setField("validFrom", start.addDays(-30).toString(Qt::ISODate));
+    visa->setField("validTo", start.addDays(5).toString(Qt::ISODate));  // возвращение позже
+    policy->setField("validFrom", start.toString(Qt::ISODate));
+    policy->setField("validTo", t->getEndDate().toString(Qt::ISODate));
+    a.noteRequestChanged(r->getId());
+
+    // Без индекса: предупреждение считается по одной заявке
+    const QStringList warnings = a.documentValidityWarnings(r->getId());
+    assert(warnings.size() == 1 && warnings[0].contains("Виза"));
+
+    auto invalid = a.documentsInvalidForTrip();
+    assert(invalid.size() == 1 && invalid[0].type == DocumentType::Visa && invalid[0].touristIndex == 0);
+    assert(a.documentsExpiringWithin(25).size() == 1);
+    assert(a.documentsExpiringWithin(40).size() == 2);
+
+    // Правка полей и тура обновляет индекс по заявке
+    visa->setField("validTo", start.addDays(60).toString(Qt::ISODate));
+    a.noteRequestChanged(r->getId());
+    assert(a.documentsInvalidForTrip().empty() && a.documentValidityWarnings(r->getId()).isEmpty());
+    assert(a.editTour(t->getId(), "Виза", "Китай", "Экскурсионный", start.addDays(-3), 10, 50000.0,
+                      false, true, {"Самолёт"}));
+    invalid = a.documentsInvalidForTrip();
+    assert(invalid.size() == 1 && invalid[0].touristIndex == -1);
+
+    assert(a.deleteRequest(r->getId()));
+    assert(a.documentsInvalidForTrip().empty() && a.documentsExpiringWithin(365).empty());
+}
+
+// --- 29. Типизированные поля документа: даты как QDate, совместимый вид QVariantMap ---
+void test_document_typed_fields() {
+    Document passport(DocumentType::Passport);
+    passport.setField("series", "4510");
+    passport.setField("issueDate", "12.03.2015");        // старый формат даты
+    passport.setField("legacyNote", "из старого файла");  // ключа нет в схеме
+    passport.setField("issuedBy", "");
+    const int issue = DocumentService::fieldIndex(DocumentType::Passport, "issueDate");
+    assert(issue >= 0 && passport.dateAt(issue) == QDate(2015, 3, 12));
+    assert(passport.field("issueDate").toString() == "12.03.2015");  // возвращается как введена
+    assert(passport.date("issueDate") == QDate(2015, 3, 12));
+    assert(DocumentService::fieldIndex(DocumentType::Passport, "legacyNote") == -1);
+
+    const QVariantMap view = passport.fields();
+    assert(view.size() == 3 && view.value("series").toString() == "4510");
+    assert(view.value("issueDate").toString() == "12.03.2015" && !view.contains("issuedBy"));
+    assert(view.value("legacyNote").toString() == "из старого файла");
+
+    // Неразобранная дата хранится текстом; setFields и присваивание заменяют всё
+    Document copy(DocumentType::Passport);
+    copy.setFields(view);
+    assert(copy.fields() == view);
+    copy.setField("issueDate", "вчера");
+    assert(!copy.date("issueDate").isValid() && copy.field("issueDate").toString() == "вчера");
+    copy.setDate("issueDate", QDate(2020, 1, 2));
+    assert(copy.field("issueDate").toString() == "2020-01-02");
+    copy.setField("issueDate", "2021-05-06");
+    assert(copy.dateAt(issue) == QDate(2021, 5, 6) && copy.field("issueDate").toString() == "2021-05-06");
+
+    // Присваивание сохраняет привязку и выставляет флаг; копия не привязана
+    bool changed = false;
+    copy.bindChangeFlag(&changed);
+    copy = passport;
+    assert(copy.fields() == view && changed);
+    changed = false;
+    Document unbound(copy);
+    unbound.setStatus(DocumentStatus::Verified);
+    assert(!changed);
+    copy.setStatus(DocumentStatus::Verified);
+    assert(changed);
+}
+
+// --- 30. Модели таблиц: строки из векторов агентства, сигналы только об изменённых строках ---
+void test_table_models() {
+    TravelAgency a;
+    const Address reg = makeAddress();
+    Client* first = a.addClient("Первый", "Иван", "", "1", "a@a.ru", QDate(1980,1,1), reg, reg, "");
+    ClientTableModel clients(a);
+    RequestTableModel requests(a);
+    assert(clients.rowCount() == 1 && clients.columnCount() == 6);
+    assert(clients.headerData(1, Qt::Horizontal).toString() == "ФИО");
+    assert(clients.data(clients.index(0, 1)).toString() == first->getFullName());
+
+    int inserted = 0, removed = 0, changedRow = -1, resets = 0;
+    QObject::connect(&clients, &QAbstractItemModel::rowsInserted,
+                     [&](const QModelIndex&, int from, int to) { inserted += to - from + 1; });
+    QObject::connect(&clients, &QAbstractItemModel::rowsRemoved,
+                     [&](const QModelIndex&, int from, int to) { removed += to - from + 1; });
+    QObject::connect(&clients, &QAbstractItemModel::dataChanged,
+                     [&](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+                         assert(topLeft.row() == bottomRight.row());
+                         changedRow = topLeft.row();
+                     });
+    QObject::connect(&clients, &QAbstractItemModel::modelReset, [&]() { ++resets; });
+
+    Client* second = a.addClient("Второй", "Пётр", "", "2", "b@a.ru", QDate(1985,1,1), reg, reg, "");
+    clients.rowsAppended();
+    assert(inserted == 1 && clients.rowCount() == 2 && resets == 0);
+    clients.rowChanged(second->getId());
+    assert(changedRow == 1);
+
+    // Отбор поиска — своя строка, без копий данных
+    clients.setFilter({second});
+    assert(resets == 1 && clients.rowCount() == 1 && clients.idAt(0) == second->getId());
+    assert(clients.rowOf(first->getId()) == -1);
+    clients.clearFilter();
+    assert(resets == 2 && clients.rowCount() == 2);
+
+    const int row = clients.rowOf(second->getId());
+    assert(a.deleteClient(second->getId()));
+    clients.rowRemoved(row);
+    assert(removed == 1 && clients.rowCount() == 1 && clients.idAt(1) == 0);
+
+    Tour* t = a.addTour("Тур", "Россия", "Экскурсионный", QDate::currentDate().addDays(10), 5, 10000.0,
+                        true, false, {"Поезд"});
+    TourRequest* r = a.createRequest(first->getId(), t->getId());
+    requests.rowsAppended();
+    assert(requests.rowCount() == 1 && requests.data(requests.index(0, 2)).toString() == "Тур");
+    assert(requests.data(requests.index(0, 3)).toString() == "Черновик");
+    r->setStatus(RequestStatus::Paid);
+    requests.rowChanged(r->getId());
+    assert(requests.data(requests.index(0, 3)).toString() == "Оплачена");
+}
+
+// --- 31. Стоимость по счётчикам заявки и выручка агентства по статусам ---
+void test_cost_totals_and_revenue() {
+    TravelAgency a;
+    const Address reg = makeAddress();
+    Client* c = a.addClient("Итогов", "Иван", "", "1", "a@a.ru", QDate(1980,1,1), reg, reg, "");
+    Tour* t = a.addTour("Сочи", "Россия", "Пляжный", QDate::currentDate().addDays(9), 7, 10000.0,
+                        true, false, {"Поезд"});
+    TourRequest* r = a.createRequest(c->getId(), t->getId());
+    r->addAdult("Итогов", "Иван", "");
+    r->addChild("Итогова", "Анна", "", QDate::currentDate().addYears(-8));
+    r->addAnimal("Кот", 4.0, "Салон");
+    r->addAnimal("Пёс", 10.0, "Салон");
+    assert(r->totals().adults == 1 && r->totals().children == 1);
+    const double animals = TourRequest::animalSurcharge(4.0) + TourRequest::animalSurcharge(10.0);
+    assert(r->calculateTotalCost() == 10000.0 + 5000.0 + animals);
+    r->removeTourist(1);
+    r->removeAnimal(0);
+    assert(r->totals().children == 0 && r->calculateTotalCost() == 10000.0 + TourRequest::animalSurcharge(10.0));
+    r->removeAnimal(0);
+    assert(r->totals().animalSurcharge == 0.0);
+
+    // Выручка: вклад заявки переносится между статусами и следует за ценой тура
+    a.noteRequestChanged(r->getId());
+    assert(a.revenue(RequestStatus::Draft) == 10000.0 && a.revenue(RequestStatus::Paid) == 0.0);
+    r->setStatus(RequestStatus::Paid);
+    a.noteRequestChanged(r->getId());
+    assert(a.revenue(RequestStatus::Draft) == 0.0 && a.revenue(RequestStatus::Paid) == 10000.0);
+    assert(a.editTour(t->getId(), "Сочи", "Россия", "Пляжный", t->getStartDate(), 7, 12000.5,
+                      true, false, {"Поезд"}));
+    assert(a.revenue(RequestStatus::Paid) == 12000.5);
+    std::unique_ptr<TravelAgency> copy = a.clone();
+    assert(copy->revenue(RequestStatus::Paid) == 12000.5);
+    assert(a.deleteRequest(r->getId()));
+    assert(a.revenue(RequestStatus::Paid) == 0.0);
+}
+
+// --- 32. Поиск по мере ввода: пауза, отмена устаревших запросов, страницы результата ---
+void test_search_controller() {
+    std::atomic<int> runs{0};
+    SearchController search([&runs](const QString& text, const std::atomic<bool>& cancelled) {
+        ++runs;
+        if (text == "долгий") {
+            QElapsedTimer timer;
+            timer.start();
+            while (!cancelled && timer.elapsed() < 5000) QThread::msleep(1);
+            return std::vector<int>{-1};
+        }
+        std::vector<int> ids;
+        for (int i = 0; i < 1000; ++i)
+            if (QString::number(i).startsWith(text)) ids.push_back(i);
+        return ids;
+    });
+    QStringList delivered;
+    std::vector<int> last;
+    QEventLoop loop;
+    QObject::connect(&search, &SearchController::resultsReady,
+                     [&](const QString& text, const std::vector<int>& ids) {
+                         delivered << text;
+                         last = ids;
+                         loop.quit();
+                     });
+    auto waitResult = [&loop]() {
+        QTimer guard;
+        guard.setSingleShot(true);
+        QObject::connect(&guard, &QTimer::timeout, &loop, &QEventLoop::quit);
+        guard.start(5000);
+        loop.exec();
+    };
+
+    // Три нажатия подряд — один запрос по последнему тексту
+    search.setQuery("1");
+    search.setQuery("12");
+    search.setQuery("123");
+    waitResult();
+    assert(delivered == QStringList{"123"} && runs == 1 && last == std::vector<int>{123});
+
+    // Новый ввод отменяет запрос в работе; его результат не приходит
+    delivered.clear();
+    search.runNow("долгий");
+    search.setQuery("5");
+    waitResult();
+    assert(delivered == QStringList{"5"} && last.size() == 111);
+
+    SearchResultModel model({"ID"}, [](int id, int) { return QString::number(id); });
+    std::vector<int> ids(SearchResultModel::PAGE_SIZE * 2 + 5);
+    std::iota(ids.begin(), ids.end(), 1);
+    model.setResults(ids);
+    assert(model.rowCount() == SearchResultModel::PAGE_SIZE && model.canFetchMore(QModelIndex()));
+    model.fetchMore(QModelIndex());
+    model.fetchMore(QModelIndex());
+    assert(model.rowCount() == static_cast<int>(ids.size()) && !model.canFetchMore(QModelIndex()));
+    assert(model.data(model.index(3, 0)).toString() == "4" && model.idAt(model.rowCount()) == 0);
+}
+
+// --- 33. Загрузка: ошибка и отмена не трогают данные, готовые данные подменяются целиком ---
+void test_detached_load() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("agency.json");
+    const QString snapPath = dir.filePath("agency.snap");
+    Address reg = makeAddress();
+    {
+        TravelAgency src;
+        Client* c = src.addClient("Фомин", "Фёдор", "", "8", "f@f.ru", QDate(1980,1,1), reg, reg, "");
+        Tour* t = src.addTour("Казань", "Россия", "Экскурсионный", QDate::currentDate().addDays(20),
+                              3, 15000.0, true, false, {"Поезд"});
+        src.createRequest(c->getId(), t->getId())->addAdult("Фомин", "Фёдор", "");
+        src.addClient("Фомина", "Фаина", "", "9", "ff@f.ru", QDate(1982,2,2), reg, reg, "");
+        assert(src.saveToFile(path) && src.saveSnapshot(snapPath));
+    }
+
+    TravelAgency a;
+    Client* own = a.addClient("Свой", "Клиент", "", "1", "s@k.ru", QDate(1990,1,1), reg, reg, "");
+    const int ownId = own->getId();
+
+    // Битый файл: ошибка, прежние данные на месте
+    const QString broken = dir.filePath("broken.json");
+    QFile f(broken);
+    assert(f.open(QIODevice::WriteOnly));
+    f.write(R"({"clients": [{"id": 1, "lastName": "Иванов", "firstName": "Иван"}, {"id": )");
+    f.close();
+    QString err;
+    assert(!a.loadFromFile(broken, &err) && !err.isEmpty());
+    assert(!a.loadFromFileStreaming(broken, {}, &err));
+    assert(a.clients().size() == 1 && a.findClientById(ownId) == own);
+
+    // Отмена до начала разбора — ни одной записи
+    std::atomic<bool> cancelled{true};
+    err.clear();
+    assert(!TravelAgency::loadDetached(path, false, {}, &cancelled, &err) && !err.isEmpty());
+
+    // Загрузка в отдельный объект, затем подмена; старые данные переходят в него
+    cancelled = false;
+    std::unique_ptr<TravelAgency> loaded = TravelAgency::loadDetached(path, true, {}, &cancelled, &err);
+    assert(loaded && loaded->clients().size() == 2 && loaded->lazyRequestDetails());
+    assert(a.findClientById(ownId) == own);
+    assert(a.adoptData(*loaded));
+    assert(a.clients().size() == 2 && a.requests().size() == 1 && !a.findClientById(ownId));
+    assert(a.searchClients("Фаина").size() == 1);
+    assert(a.getSalesHistoryForClient(a.clients()[0]->getId()).size() == 1);
+    assert(a.revenue(RequestStatus::Draft) == a.requests()[0]->calculateTotalCost());
+    assert(loaded->clients().size() == 1 && loaded->findClientById(ownId) == own);
+
+    // Снимок выбирается по содержимому файла
+    std::unique_ptr<TravelAgency> fromSnap = TravelAgency::loadDetached(snapPath, false);
+    assert(fromSnap && fromSnap->requests().size() == 1
+           && fromSnap->requests()[0]->calculateTotalCost() == a.requests()[0]->calculateTotalCost());
+
+    // Снимок хранилища пишется заранее (в рабочем потоке), подмена его только переименовывает;
+    // журнал прежних данных очищается
+    const QString storePath = dir.filePath("store.snap");
+    const QString stagedPath = TravelAgency::stagedPathFor(storePath);
+    TravelAgency stored;
+    assert(stored.openStore(storePath, &err));
+    stored.addClient("Журнальный", "Клиент", "", "2", "j@k.ru", QDate(1990,1,1), reg, reg, "");
+    std::unique_ptr<TravelAgency> next = TravelAgency::loadDetached(path, false);
+    assert(next && next->stageStoreSnapshot(stored.storePath(), &err) && QFile::exists(stagedPath));
+    assert(stored.adoptData(*next, &err) && !QFile::exists(stagedPath));
+    stored.closeStore();
+    TravelAgency reopened;
+    assert(reopened.openStore(storePath, &err));
+    assert(reopened.clients().size() == 2 && reopened.requests().size() == 1);
+    reopened.closeStore();
+
+    // Прерванная подмена: остался только подготовленный снимок — он и открывается
+    assert(QFile::rename(storePath, stagedPath));
+    TravelAgency recovered;
+    assert(recovered.openStore(storePath, &err) && recovered.clients().size() == 2);
+    assert(QFile::exists(storePath) && !QFile::exists(stagedPath));
+}
+
+// --- 34. Модель выпадающего списка: порции строк, id в Qt::UserRole, правки без перестройки ---
+void test_table_model_paging() {
+    TravelAgency a;
+    const Address reg = makeAddress();
+    std::vector<int> ids;
+    const QStringList names = {"Аникин", "Борисов", "Власов", "Глебов", "Дымов"};
+    for (const QString& name : names)
+        ids.push_back(a.addClient(name, "Иван", "", "1", "c@c.ru", QDate(1980,1,1), reg, reg, "")->getId());
+    ClientTableModel combo(a);
+    combo.setPageSize(2);
+    assert(combo.rowCount() == 2 && combo.canFetchMore(QModelIndex()));
+    assert(combo.data(combo.index(1, 0), Qt::UserRole).toInt() == ids[1]);
+    assert(combo.data(combo.index(1, 1), Qt::EditRole).toString() == combo.data(combo.index(1, 1)).toString());
+
+    combo.fetchMore(QModelIndex());
+    assert(combo.rowCount() == 4);
+
+    // Новый клиент, пока подгружены не все строки, — придёт с очередной порцией
+    ids.push_back(a.addClient("Новиков", "Иван", "", "9", "n@c.ru", QDate(1980,1,1), reg, reg, "")->getId());
+    combo.rowsAppended();
+    assert(combo.rowCount() == 4 && combo.rowOf(ids[5]) == -1);
+    assert(combo.fetchRowOf(ids[5]) == 5 && combo.rowCount() == 6 && !combo.canFetchMore(QModelIndex()));
+
+    // Все строки показаны: следующий новый клиент виден сразу
+    ids.push_back(a.addClient("Егоров", "Иван", "", "8", "e@c.ru", QDate(1980,1,1), reg, reg, "")->getId());
+    combo.rowsAppended();
+    assert(combo.rowCount() == 7 && combo.idAt(6) == ids[6]);
+
+    // Удаление ещё не подгруженной строки и снова порции после reload
+    combo.reload();
+    assert(combo.rowCount() == 2);
+    assert(a.deleteClient(ids[4]));
+    combo.rowRemoved(combo.rowOf(ids[4]));
+    combo.fetchMore(QModelIndex());
+    combo.fetchMore(QModelIndex());
+    assert(combo.rowCount() == 6 && combo.rowOf(ids[4]) == -1 && !combo.canFetchMore(QModelIndex()));
+    // Строки после удалённой сдвинулись — индекс id → строка это учитывает
+    assert(combo.rowOf(ids[5]) == 4 && combo.rowOf(ids[6]) == 5);
+
+    // Без размера страницы — все строки сразу, как в таблицах
+    ClientTableModel table(a);
+    assert(table.rowCount() == 6 && !table.canFetchMore(QModelIndex()));
+}
+
+// --- 35. Файл прежнего формата: документы заявки сопоставляются по типу, а не по позиции ---
+void test_legacy_document_order() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("legacy.json");
+    QFile f(path);
+    assert(f.open(QIODevice::WriteOnly));
+    // Зарубежный тур с визой; документы в порядке, который писали прежние версии
+    f.write(R"({"clients": [{"id": 1, "lastName": "Орлов", "firstName": "Олег", "phone": "1", "email": "o@o.ru"}],
+               "tours": [{"id": 2, "name": "Анталья", "country": "Турция", "tourType": "Пляжный",
+                          "startDate": "2030-06-01", "durationDays": 10, "basePrice": 70000,
+                          "isDomestic": false, "visaRequired": true, "travelModes": ["Самолёт"]}],
+               "requests": [{"id": 3, "clientId": 1, "tourId": 2, "travelMode": "Самолёт",
+                             "tourists": [{"lastName": "Орлов", "firstName": "Олег", "documents": [
+                                 {"type": 1, "status": 2, "fields": {"number": "751234567"}},
+                                 {"type": 6, "status": 1, "fields": {"visaNumber": "TR12345"}}]}],
+                             "documents": [
+                                 {"type": 9, "status": 2, "fields": {"voucherNumber": "VCH-000777"}},
+                                 {"type": 7, "status": 1, "fields": {"policyNumber": "INS-123456", "company": "Полис"}},
+                                 {"type": 10, "status": 0, "fields": {"ticketNumber": "TK-555555"}}]}]})");
+    f.close();
+
+    auto check = [](const TravelAgency& a) {
+        const TourRequest* r = a.findRequestById(3);
+        assert(r);
+        const auto& docs = r->getDocuments();
+        assert(docs.size() == 3);
+        assert(docs[0]->getType() == DocumentType::Voucher && docs[0]->getStatus() == DocumentStatus::Verified);
+        assert(docs[0]->field("voucherNumber") == "VCH-000777");
+        assert(docs[1]->getType() == DocumentType::InsurancePolicy && docs[1]->getStatus() == DocumentStatus::Available);
+        assert(docs[1]->field("policyNumber") == "INS-123456" && docs[1]->field("company") == "Полис");
+        assert(!docs[1]->fields().contains("voucherNumber"));
+        assert(docs[2]->getType() == DocumentType::Tickets && docs[2]->field("ticketNumber") == "TK-555555");
+        const auto& personal = r->getTourists()[0]->documents();
+        assert(personal.size() == 2);
+        assert(personal[0]->getType() == DocumentType::InternationalPassport && personal[0]->field("number") == "751234567");
+        assert(personal[1]->getType() == DocumentType::Visa && personal[1]->field("visaNumber") == "TR12345");
+    };
+
+    TravelAgency eager, streamed;
+    QString err;
+    assert(eager.loadFromFile(path, &err));
+    check(eager);
+    streamed.setLazyRequestDetails(true);
+    assert(streamed.loadFromFileStreaming(path, {}, &err));
+    check(streamed);
+
+    // Снимок той же заявки даёт тот же результат
+    const QString snapPath = dir.filePath("legacy.snap");
+    assert(eager.saveSnapshot(snapPath));
+    TravelAgency snap;
+    assert(snap.loadSnapshot(snapPath, &err));
+    check(snap);
+}
+
+// --- 36. Повреждённые отложенные подробности: запись сохраняется, заявка помечается ---
+void test_broken_pending_details() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("broken.json");
+    QFile f(path);
+    assert(f.open(QIODevice::WriteOnly));
+    f.write(R"({"clients": [{"id": 1, "lastName": "Орлов", "firstName": "Олег", "phone": "1", "email": "o@o.ru"}],
+               "tours": [{"id": 2, "name": "Сочи", "country": "Россия", "tourType": "Пляжный",
+                          "startDate": "2030-06-01", "durationDays": 7, "basePrice": 10000,
+                          "isDomestic": true, "travelModes": ["Поезд"]}],
+               "requests": [{"id": 3, "clientId": 1, "tourId": 2, "travelMode": "Поезд",
+                             "tourists": [{"lastName": "Орлов", "firstName": "Олег"}],
+                             "animals": [{"type": "Кот", "weight": -1, "transport": "Переноска"}]}]})");
+    f.close();
+
+    TravelAgency a;
+    a.setLazyRequestDetails(true);
+    QString err;
+    assert(a.loadFromFile(path, &err));
+    TourRequest* r = a.findRequestById(3);
+    assert(r && r->hasPendingDetails());
+    const double cost = r->calculateTotalCost();
+
+    QString detailsErr;
+    assert(!r->materialize(&detailsErr));
+    assert(!detailsErr.isEmpty() && r->detailsBroken() && r->detailsError() == detailsErr);
+    // Запись и счётчики на месте, заявка не считается полной
+    assert(r->hasPendingDetails() && r->totals().adults == 1);
+    assert(r->calculateTotalCost() == cost);
+    assert(!r->isComplete());
+    bool threw = false;
+    try { r->addAdult("Орлова", "Анна", ""); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && r->totals().adults == 1);
+
+    // Сохранение пишет исходную запись; после перезагрузки ошибка та же
+    const QString savedPath = dir.filePath("saved.json");
+    assert(a.saveToFile(savedPath));
+    TravelAgency b;
+    b.setLazyRequestDetails(true);
+    assert(b.loadFromFile(savedPath, &err));
+    TourRequest* saved = b.findRequestById(3);
+    assert(saved && saved->hasPendingDetails() && !saved->materialize());
+    assert(saved->totals().adults == 1 && saved->calculateTotalCost() == cost);
+}
+
+// --- 37. Правка тура из журнала обновляет выручку его заявок ---
+void test_journal_tour_edit() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("store.snap");
+    Address reg = makeAddress();
+    int tourId = 0;
+    {
+        TravelAgency a;
+        assert(a.openStore(path));
+        Client* c = a.addClient("Орлов", "Олег", "", "8", "o@r.ru", QDate(1975,5,5), reg, reg, "");
+        Tour* t = a.addTour("Казань", "Россия", "Экскурсионный", QDate::currentDate().addDays(20),
+                            3, 9000, true, false, {"Поезд"});
+        tourId = t->getId();
+        TourRequest* r = a.createRequest(c->getId(), tourId);
+        r->addAdult("Орлов", "Олег", "");
+        r->setStatus(RequestStatus::Paid);
+        a.noteRequestChanged(r->getId());
+        assert(a.revenue(RequestStatus::Paid) == 9000);
+        assert(a.editTour(tourId, "Казань", "Россия", "Экскурсионный", t->getStartDate(), 3, 12000,
+                          true, false, {"Поезд"}));
+        assert(a.revenue(RequestStatus::Paid) == 12000);
+    }
+    TravelAgency b;
+    QString err;
+    assert(b.openStore(path, &err));
+    assert(b.findTourById(tourId)->getBasePrice() == 12000);
+    assert(b.revenue(RequestStatus::Paid) == 12000);
+    b.closeStore();
+
+    // То же в два шага, как при запуске окна: чтение в фоне, подмена в потоке окна
+    int records = -1;
+    std::unique_ptr<TravelAgency> loaded = TravelAgency::loadStoreDetached(path, true, &records, &err);
+    assert(loaded && records > 0);
+    TravelAgency c;
+    assert(c.adoptStore(*loaded, path, records, &err) && c.isStoreOpen() && c.storePath() == path);
+    assert(c.findTourById(tourId)->getBasePrice() == 12000);
+    assert(c.revenue(RequestStatus::Paid) == 12000);
+}
+
+// --- 38. Слушатель журнала: ошибки записи и сжатие выполняет владелец ---
+void test_journal_listener() {
+    QTemporaryDir dir;
+    assert(dir.isValid());
+    const QString path = dir.filePath("store.snap");
+    const QString journalPath = TravelAgency::journalPathFor(path);
+    Address reg = makeAddress();
+    int calls = 0;
+    QString lastErr = "не вызывался";
+    QString comment;
+    {
+        TravelAgency a;
+        assert(a.openStore(path));
+        a.setJournalListener([&](const QString& err) { ++calls; lastErr = err; });
+        Client* c = a.addClient("Орлов", "Олег", "", "8", "o@r.ru", QDate(1975,5,5), reg, reg, "");
+        assert(calls == 1 && lastErr.isEmpty());
+        for (int i = 0; !a.compactionDue(); ++i) {
+            assert(i < 10000);
+            comment = QString("правка %1").arg(i);
+            assert(a.editClient(c->getId(), "Орлов", "Олег", "", "8", "o@r.ru", QDate(1975,5,5),
+                                reg, reg, comment));
+        }
+        // Со слушателем журнал сам не сжимается
+        assert(!QFile::exists(path) && QFileInfo(journalPath).size() > 0);
+
+        QString err;
+        assert(a.saveSnapshot(TravelAgency::stagedPathFor(path), &err));
+        assert(a.commitStagedSnapshot(&err));
+        assert(!a.compactionDue() && QFile::exists(path) && QFileInfo(journalPath).size() == 0);
+        assert(!QFile::exists(TravelAgency::stagedPathFor(path)));
+    }
+    TravelAgency b;
+    QString err;
+    assert(b.openStore(path, &err));
+    assert(b.clients().size() == 1 && b.clients()[0]->getComments() == comment);
+}
+
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
     fprintf(stderr, "Тесты: Туристическое агентство\n");
@@ -151,6 +1443,35 @@ int main(int argc, char *argv[]) {
     RUN_TEST(test_documents_generated);
     RUN_TEST(test_agency_crud);
     RUN_TEST(test_document_warnings);
+    RUN_TEST(test_agency_lookup_index);
+    RUN_TEST(test_agency_request_indexes);
+    RUN_TEST(test_search_clients_index);
+    RUN_TEST(test_streaming_load);
+    RUN_TEST(test_binary_snapshot);
+    RUN_TEST(test_change_journal);
+    RUN_TEST(test_agency_clone);
+    RUN_TEST(test_parallel_request_load);
+    RUN_TEST(test_load_dangling_refs);
+    RUN_TEST(test_lazy_request_details);
+    RUN_TEST(test_requests_jsonl);
+    RUN_TEST(test_document_schema_registry);
+    RUN_TEST(test_document_checksums);
+    RUN_TEST(test_validate_clients_batch);
+    RUN_TEST(test_incremental_documents);
+    RUN_TEST(test_document_rules);
+    RUN_TEST(test_completeness_cache);
+    RUN_TEST(test_document_audit);
+    RUN_TEST(test_document_expiry_index);
+    RUN_TEST(test_document_typed_fields);
+    RUN_TEST(test_table_models);
+    RUN_TEST(test_cost_totals_and_revenue);
+    RUN_TEST(test_search_controller);
+    RUN_TEST(test_detached_load);
+    RUN_TEST(test_table_model_paging);
+    RUN_TEST(test_legacy_document_order);
+    RUN_TEST(test_broken_pending_details);
+    RUN_TEST(test_journal_tour_edit);
+    RUN_TEST(test_journal_listener);
     fprintf(stderr, "Все тесты пройдены.\n");
     return 0;
 }
@@ -2,7 +2,7 @@
 
 #include <stdexcept>
 
-int Tour::nextId = 1;
+std::atomic<int> Tour::nextId{1};
 
 Tour::Tour(const QString& name, const QString& country, const QString& tourType,
            const QDate& startDate, int durationDays, double basePrice,
@@ -11,8 +11,13 @@ Tour::Tour(const QString& name, const QString& country, const QString& tourType,
     : name_(name), country_(country), tourType_(tourType), startDate_(startDate),
     durationDays_(durationDays), basePrice_(basePrice), isDomestic_(isDomestic),
     visaRequired_(visaRequired) {
-    if (id > 0) { id_ = id; if (id >= nextId) nextId = id + 1; }
-    else { id_ = nextId++; }
+    if (id > 0) {
+        id_ = id;
+        int next = nextId.load();
+        while (id >= next && !nextId.compare_exchange_weak(next, id + 1)) {}
+    } else {
+        id_ = nextId++;
+    }
     if (name.trimmed().isEmpty()) throw std::invalid_argument("Название тура не может быть пустым");
     if (durationDays <= 0) throw std::invalid_argument("Длительность должна быть больше 0");
     if (basePrice < 0) throw std::invalid_argument("Базовая цена не может быть отрицательной");
@@ -3,6 +3,7 @@
 #include <QDate>
 #include <QString>
 #include <QStringList>
+#include <atomic>
 
 //=============================================================================
 // Класс Tour — тур
@@ -47,5 +48,5 @@ private:
     bool isDomestic_;
     bool visaRequired_;
     QStringList travelModes_;
-    static int nextId;
+    static std::atomic<int> nextId;  // загрузка может идти в фоновом потоке
 };
@@ -1,17 +1,54 @@
 #include "tour_request.h"
 
+#include <QJsonDocument>
+#include <QtGlobal>
+
 #include <algorithm>
 #include <stdexcept>
-#include <unordered_map>
 
 #include "document_service.h"
+#include "serialization_service.h"
+
+std::atomic<int> TourRequest::nextId{1};
+
+namespace {
+
+/**
+ * Приводит документы к требуемому набору на месте: требуемые типы идут первыми
+ * в порядке required (существующие объекты переставляются вместе с полями,
+ * недостающие создаются), остальные документы сохраняются следом.
+ */
+void syncDocuments(std::vector<std::unique_ptr<Document>>& docs, const std::vector<DocumentType>& required) {
+    // Частый случай — набор не изменился: ни перестановок, ни выделений памяти
+    bool unchanged = docs.size() >= required.size();
+    for (size_t i = 0; unchanged && i < required.size(); ++i)
+        unchanged = docs[i]->getType() == required[i];
+    if (unchanged) return;
 
-int TourRequest::nextId = 1;
+    std::vector<std::unique_ptr<Document>> ordered;
+    ordered.reserve(docs.size() + required.size());
+    for (DocumentType type : required) {
+        auto it = std::find_if(docs.begin(), docs.end(),
+                               [type](const std::unique_ptr<Document>& d) { return d && d->getType() == type; });
+        ordered.push_back(it != docs.end() ? std::move(*it) : std::make_unique<Document>(type));
+    }
+    for (auto& d : docs)
+        if (d) ordered.push_back(std::move(d));
+    docs.swap(ordered);
+}
+
+} // namespace
 
 TourRequest::TourRequest(Client* client, Tour* tour, int id)
     : client_(client), tour_(tour), status_(RequestStatus::Draft) {
-    if (id > 0) { id_ = id; if (id >= nextId) nextId = id + 1; }
-    else { id_ = nextId++; }
+    if (id > 0) {
+        id_ = id;
+        // Счётчик только растёт: итог не зависит от порядка создания заявок
+        int next = nextId.load();
+        while (id >= next && !nextId.compare_exchange_weak(next, id + 1)) {}
+    } else {
+        id_ = nextId++;
+    }
     if (!client_ || !tour_) throw std::invalid_argument("Клиент и тур обязательны");
     const QStringList modes = tour_->getTravelModes();
     travelMode_ = modes.isEmpty() ? "Самолёт" : modes.first();
@@ -19,39 +56,129 @@ TourRequest::TourRequest(Client* client, Tour* tour, int id)
     travelClass_ = classes.isEmpty() ? QString() : classes.first();
 }
 
+TourRequest* TourRequest::clone(Client* client, Tour* tour) const {
+    auto* copy = new TourRequest(client, tour, id_);
+    copy->status_ = status_;
+    copy->travelMode_ = travelMode_;
+    copy->travelClass_ = travelClass_;
+    // Неразобранные подробности копируются как есть (QByteArray разделяется неявно)
+    copy->pendingDetails_ = pendingDetails_;
+    copy->totals_ = totals_;
+    copy->detailsError_ = detailsError_;
+    copy->tourists_.reserve(tourists_.size());
+    for (const auto& t : tourists_) copy->tourists_.push_back(t->clone());
+    copy->animals_.reserve(animals_.size());
+    for (const auto& a : animals_) copy->animals_.push_back(std::make_unique<Animal>(*a));
+    copy->documents_.reserve(documents_.size());
+    for (const auto& d : documents_) copy->documents_.push_back(std::make_unique<Document>(*d));
+    copy->bindChangeFlags();
+    return copy;
+}
+
+void TourRequest::setPendingDetails(const QByteArray& payload, const DetailsSummary& summary) {
+    tourists_.clear();
+    animals_.clear();
+    documents_.clear();
+    pendingDetails_ = payload;
+    totals_ = summary;
+    detailsError_.clear();
+    completenessStale_ = true;
+}
+
+bool TourRequest::materialize(QString* err) const {
+    if (pendingDetails_.isEmpty()) return true;
+    if (detailsError_.isEmpty()) decodePendingDetails();
+    if (detailsError_.isEmpty()) return true;
+    if (err) *err = detailsError_;
+    return false;
+}
+
+void TourRequest::decodePendingDetails() const {
+    // Разбор идёт в отдельную заявку (счётчики набираются в её addAdult/addChild/
+    // addAnimal); эта получает результат, только если разбор прошёл целиком
+    TourRequest scratch(client_, tour_, id_);
+    scratch.status_ = status_;
+    scratch.travelMode_ = travelMode_;
+    scratch.travelClass_ = travelClass_;
+    try {
+        SerializationService::readRequestDetails(scratch, QJsonDocument::fromJson(pendingDetails_).object());
+    } catch (const std::exception& e) {
+        detailsError_ = QString("Заявка %1: некорректные данные туристов или документов: %2")
+                            .arg(id_).arg(QString::fromUtf8(e.what()));
+        return;
+    }
+    tourists_ = std::move(scratch.tourists_);
+    animals_ = std::move(scratch.animals_);
+    documents_ = std::move(scratch.documents_);
+    // Сводка из файла обычно совпадает с разобранной и не перезаписывается:
+    // таблица заявок читает её в потоке окна, пока аудит разбирает заявки в фоне
+    if (totals_.adults != scratch.totals_.adults || totals_.children != scratch.totals_.children
+        || totals_.animalSurcharge != scratch.totals_.animalSurcharge) {
+        totals_ = scratch.totals_;
+    }
+    pendingDetails_.clear();
+    bindChangeFlags();
+}
+
+void TourRequest::materializeForEdit() {
+    QString err;
+    if (!materialize(&err)) throw std::runtime_error(err.toStdString());
+}
+
 void TourRequest::addAdult(const QString& lastName, const QString& firstName, const QString& middleName) {
+    materializeForEdit();
     tourists_.push_back(std::make_unique<AdultTourist>(lastName, firstName, middleName));
-    regenerateDocuments();
+    ++totals_.adults;
+    regenerateTouristDocuments(static_cast<int>(tourists_.size()) - 1);
+    // Документы заявки от состава туристов не зависят; вызов лишь создаёт
+    // их у новой заявки, дальше он ничего не меняет
+    regenerateRequestDocuments();
 }
 
 void TourRequest::addChild(const QString& lastName, const QString& firstName, const QString& middleName,
                            const QDate& dateOfBirth) {
+    materializeForEdit();
     tourists_.push_back(std::make_unique<ChildTourist>(lastName, firstName, middleName, dateOfBirth));
-    regenerateDocuments();
+    ++totals_.children;
+    regenerateTouristDocuments(static_cast<int>(tourists_.size()) - 1);
+    regenerateRequestDocuments();
 }
 
 void TourRequest::removeTourist(int index) {
-    if (index >= 0 && index < static_cast<int>(tourists_.size()))
+    materializeForEdit();
+    if (index >= 0 && index < static_cast<int>(tourists_.size())) {
+        if (tourists_[index]->isChild()) --totals_.children;
+        else --totals_.adults;
         tourists_.erase(tourists_.begin() + index);
-    regenerateDocuments();
+    }
+    completenessStale_ = true;
 }
 
 void TourRequest::addAnimal(const QString& type, double weight, const QString& transport) {
+    materializeForEdit();
     QString err;
     if (!Animal::validate(type, weight, transport, &err))
         throw std::invalid_argument(err.toStdString());
     animals_.push_back(std::make_unique<Animal>(type, weight, transport));
-    regenerateDocuments();
+    totals_.animalSurcharge += animalSurcharge(weight);
+    // Животные влияют только на документы заявки (ветпаспорт)
+    regenerateRequestDocuments();
 }
 
 void TourRequest::removeAnimal(int index) {
-    if (index >= 0 && index < static_cast<int>(animals_.size()))
+    materializeForEdit();
+    if (index >= 0 && index < static_cast<int>(animals_.size())) {
+        totals_.animalSurcharge -= animalSurcharge(animals_[index]->getWeight());
         animals_.erase(animals_.begin() + index);
-    regenerateDocuments();
+        // Без накопленной ошибки округления у заявки без животных
+        if (animals_.empty()) totals_.animalSurcharge = 0.0;
+    }
+    regenerateRequestDocuments();
 }
 
 void TourRequest::setTravelMode(const QString& mode) {
     if (mode.trimmed().isEmpty()) return;
+    completenessStale_ = true;
     const QStringList modes = tour_->getTravelModes();
     if (!modes.isEmpty() && !modes.contains(mode)) {
         travelMode_ = modes.first();
@@ -85,66 +212,45 @@ QStringList TourRequest::travelClassOptionsForMode(const QString& mode) {
 }
 
 void TourRequest::regenerateDocuments() {
-    struct Snapshot {
-        DocumentStatus status;
-        QVariantMap fields;
-    };
-
-    auto snapshotDocs = [](const std::vector<std::unique_ptr<Document>>& docs) {
-        std::unordered_map<int, Snapshot> map;
-        for (const auto& doc : docs) {
-            map[(int)doc->getType()] = Snapshot{doc->getStatus(), doc->fields()};
-        }
-        return map;
-    };
-
-    const auto requestSnapshot = snapshotDocs(documents_);
-
+    if (!materialize()) return;
     for (auto& t : tourists_) {
-        const auto touristSnapshot = snapshotDocs(t->documents());
-        t->clearDocuments();
-        const auto required = DocumentService::requiredPersonalDocuments(*this, *t);
-        for (const auto& docType : required) {
-            auto doc = std::make_unique<Document>(docType);
-            auto it = touristSnapshot.find((int)docType);
-            if (it != touristSnapshot.end()) {
-                doc->setStatus(it->second.status);
-                doc->fields() = it->second.fields;
-            }
-            t->documents().push_back(std::move(doc));
-        }
-        for (const auto& item : touristSnapshot) {
-            const DocumentType docType = static_cast<DocumentType>(item.first);
-            if (std::find(required.begin(), required.end(), docType) != required.end()) continue;
-            auto doc = std::make_unique<Document>(docType);
-            doc->setStatus(item.second.status);
-            doc->fields() = item.second.fields;
-            t->documents().push_back(std::move(doc));
-        }
+        syncDocuments(t->documents(), DocumentService::requiredPersonalDocuments(*this, *t));
+        t->bindChangeFlag(&completenessStale_);
     }
+    regenerateRequestDocuments();
+}
 
-    documents_.clear();
-    const auto requestDocs = DocumentService::requiredRequestDocuments(*this);
-    for (const auto& docType : requestDocs) {
-        auto doc = std::make_unique<Document>(docType);
-        auto it = requestSnapshot.find((int)docType);
-        if (it != requestSnapshot.end()) {
-            doc->setStatus(it->second.status);
-            doc->fields() = it->second.fields;
-        }
-        documents_.push_back(std::move(doc));
-    }
-    for (const auto& item : requestSnapshot) {
-        const DocumentType docType = static_cast<DocumentType>(item.first);
-        if (std::find(requestDocs.begin(), requestDocs.end(), docType) != requestDocs.end()) continue;
-        auto doc = std::make_unique<Document>(docType);
-        doc->setStatus(item.second.status);
-        doc->fields() = item.second.fields;
-        documents_.push_back(std::move(doc));
-    }
+void TourRequest::regenerateTouristDocuments(int index) {
+    if (!materialize()) return;
+    if (index < 0 || index >= static_cast<int>(tourists_.size())) return;
+    Tourist& t = *tourists_[index];
+    syncDocuments(t.documents(), DocumentService::requiredPersonalDocuments(*this, t));
+    t.bindChangeFlag(&completenessStale_);
+    completenessStale_ = true;
+}
+
+void TourRequest::regenerateRequestDocuments() {
+    if (!materialize()) return;
+    syncDocuments(documents_, DocumentService::requiredRequestDocuments(*this));
+    for (auto& d : documents_) d->bindChangeFlag(&completenessStale_);
+    completenessStale_ = true;
+}
+
+void TourRequest::bindChangeFlags() const {
+    for (auto& t : tourists_) t->bindChangeFlag(&completenessStale_);
+    for (auto& d : documents_) d->bindChangeFlag(&completenessStale_);
+    completenessStale_ = true;
+}
+
+Tourist* TourRequest::tourist(int index) {
+    materialize();
+    if (index >= 0 && index < static_cast<int>(tourists_.size()))
+        return tourists_[index].get();
+    return nullptr;
 }
 
 Document* TourRequest::getDocument(int index) {
+    materialize();
     if (index >= 0 && index < static_cast<int>(documents_.size()))
         return documents_[index].get();
     return nullptr;
@@ -155,29 +261,89 @@ void TourRequest::setDocumentStatus(int index, DocumentStatus s) {
     if (d) d->setStatus(s);
 }
 
+void TourRequest::addDocument(std::unique_ptr<Document> doc) {
+    materializeForEdit();
+    doc->bindChangeFlag(&completenessStale_);
+    documents_.push_back(std::move(doc));
+    completenessStale_ = true;
+}
+
+void TourRequest::removeDocument(int index) {
+    materializeForEdit();
+    if (index >= 0 && index < static_cast<int>(documents_.size())) {
+        documents_.erase(documents_.begin() + index);
+        completenessStale_ = true;
+    }
+}
+
+void TourRequest::restoreDocument(std::unique_ptr<Document> saved) {
+    materializeForEdit();
+    const DocumentType type = saved->getType();
+    auto it = std::find_if(documents_.begin(), documents_.end(),
+                           [type](const std::unique_ptr<Document>& d) { return d->getType() == type; });
+    saved->bindChangeFlag(&completenessStale_);
+    if (it != documents_.end()) *it = std::move(saved);
+    else documents_.push_back(std::move(saved));
+    completenessStale_ = true;
+}
+
 double TourRequest::calculateTotalCost() const {
-    int adults = 0, children = 0;
-    for (const auto& t : tourists_) {
-        if (t->isChild()) ++children; else ++adults;
+    // Отложенные подробности не разбираются: сводка файла и есть счётчики
+    const double bp = tour_->getBasePrice();
+    return totals_.adults * bp + totals_.children * bp * CHILD_DISCOUNT + totals_.animalSurcharge;
+}
+
+void TourRequest::refreshCompleteness() const {
+    if (!materialize()) {
+        // Состав повреждённой заявки неизвестен — полной она не считается
+        completeness_ = Completeness();
+        completeness_.summary << detailsError_;
+        completeness_.summaryReady = true;
+        return;
     }
-    double bp = tour_->getBasePrice();
-    double cost = adults * bp + children * bp * CHILD_DISCOUNT;
-    for (const auto& a : animals_)
-        cost += ANIMAL_BASE + a->getWeight() * ANIMAL_PER_KG;
-    return cost;
+    if (!completenessStale_ && completeness_.rulesRevision == DocumentRules::revision()) return;
+    DocumentService::missingDocuments(*this, &completeness_.tourists, &completeness_.request);
+    completeness_.complete = completeness_.request == 0
+        && std::all_of(completeness_.tourists.begin(), completeness_.tourists.end(),
+                       [](DocumentMask m) { return m == 0; });
+    completeness_.rulesRevision = DocumentRules::revision();
+    completeness_.summaryReady = false;
+    completeness_.summary.clear();
+    completenessStale_ = false;
 }
 
-bool TourRequest::checkDocumentsComplete() const {
-    return DocumentService::missingDocumentsSummary(*this).isEmpty();
+bool TourRequest::isComplete() const {
+    refreshCompleteness();
+    return completeness_.complete;
+}
+
+const std::vector<DocumentMask>& TourRequest::missingTouristDocuments() const {
+    refreshCompleteness();
+    return completeness_.tourists;
+}
+
+DocumentMask TourRequest::missingRequestDocuments() const {
+    refreshCompleteness();
+    return completeness_.request;
+}
+
+const QStringList& TourRequest::missingDocumentsSummary() const {
+    refreshCompleteness();
+    if (!completeness_.summaryReady) {
+        completeness_.summary = DocumentService::formatMissing(*this, completeness_.tourists, completeness_.request);
+        completeness_.summaryReady = true;
+    }
+    return completeness_.summary;
 }
 
 QStringList TourRequest::getDocumentWarnings() const {
-    QStringList w = DocumentService::missingDocumentsSummary(*this);
-    if (tourists_.empty()) w << "В заявке нет ни одного туриста.";
+    QStringList w = missingDocumentsSummary();
+    if (tourists_.empty() && !detailsBroken()) w << "В заявке нет ни одного туриста.";
     return w;
 }
 
 QStringList TourRequest::getValidationWarnings() const {
+    materialize();
     QStringList w;
     for (const auto& t : tourists_) {
         if (t->isChild()) {
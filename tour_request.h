@@ -1,6 +1,8 @@
 #pragma once
 
+#include <QByteArray>
 #include <QStringList>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -8,6 +10,7 @@
 #include "animal.h"
 #include "client.h"
 #include "document.h"
+#include "document_rules.h"
 #include "tour.h"
 #include "tourist.h"
 
@@ -18,6 +21,8 @@
 class TourRequest {
 public:
     TourRequest(Client* client, Tour* tour, int id = 0);
+    /** Независимая копия с тем же id; клиент и тур — из копии агентства */
+    TourRequest* clone(Client* client, Tour* tour) const;
     Client* getClient() const { return client_; }
     Tour* getTour() const { return tour_; }
     RequestStatus getStatus() const { return status_; }
@@ -30,36 +35,97 @@ public:
     int getId() const { return id_; }
 
     // Туристы
-    const std::vector<std::unique_ptr<Tourist>>& getTourists() const { return tourists_; }
-    std::vector<std::unique_ptr<Tourist>>& tourists() { return tourists_; }
+    const std::vector<std::unique_ptr<Tourist>>& getTourists() const { materialize(); return tourists_; }
+    /** Турист для правки (изменения он отмечает сам); состав меняется только через add/remove */
+    Tourist* tourist(int index);
     void addAdult(const QString& lastName, const QString& firstName, const QString& middleName);
     void addChild(const QString& lastName, const QString& firstName, const QString& middleName,
                   const QDate& dateOfBirth);
     void removeTourist(int index);
 
     // Животные
-    const std::vector<std::unique_ptr<Animal>>& getAnimals() const { return animals_; }
+    const std::vector<std::unique_ptr<Animal>>& getAnimals() const { materialize(); return animals_; }
     void addAnimal(const QString& type, double weight, const QString& transport);
     void removeAnimal(int index);
 
     // Документы заявки (поездки)
-    const std::vector<std::unique_ptr<Document>>& getDocuments() const { return documents_; }
-    std::vector<std::unique_ptr<Document>>& documents() { return documents_; }
+    const std::vector<std::unique_ptr<Document>>& getDocuments() const { materialize(); return documents_; }
+    /**
+     * Дополняет документы до требуемого набора: недостающие создаются, имеющиеся
+     * остаются теми же объектами (с полями и статусом), лишние не удаляются.
+     */
     void regenerateDocuments();
+    /** То же только для одного туриста (после смены льготы, даты рождения) */
+    void regenerateTouristDocuments(int index);
+    /** То же только для документов заявки (тур, способ поездки, животные) */
+    void regenerateRequestDocuments();
     Document* getDocument(int index);
     void setDocumentStatus(int index, DocumentStatus s);
+    /** Дополнительный документ заявки (сверх требуемых) */
+    void addDocument(std::unique_ptr<Document> doc);
+    void removeDocument(int index);
+    /**
+     * Документ заявки из файла (после regenerateDocuments): заменяет документ
+     * того же типа — сопоставление по типу, а не по позиции; иначе добавляется.
+     */
+    void restoreDocument(std::unique_ptr<Document> saved);
 
     // Автоматический расчёт стоимости: взрослые + дети (скидка) + животные (доплата)
+    /** O(1): по счётчикам totals(), без обхода туристов и животных */
     double calculateTotalCost() const;
+    static double animalSurcharge(double weight) { return ANIMAL_BASE + weight * ANIMAL_PER_KG; }
 
     // Проверка наличия обязательных документов
-    bool checkDocumentsComplete() const;
+    /**
+     * Полнота кэшируется: недостающие типы по туристам и по заявке хранятся
+     * масками и пересчитываются только после изменения статуса или полей
+     * документа, туристов, животных, способа поездки или правил.
+     */
+    bool isComplete() const;
+    bool checkDocumentsComplete() const { return isComplete(); }
+    /** Недостающие типы по туристам (в их порядке) и по заявке */
+    const std::vector<DocumentMask>& missingTouristDocuments() const;
+    DocumentMask missingRequestDocuments() const;
+    /** Текст недостающих документов; строится только при запросе и тоже кэшируется */
+    const QStringList& missingDocumentsSummary() const;
+    /** Сбросить кэш полноты (изменение тура, от которого зависят требования) */
+    void invalidateCompleteness() const { completenessStale_ = true; }
     /** Список предупреждений о недостающих документах */
     QStringList getDocumentWarnings() const;
 
     // Предупреждения о возможных ошибках ввода
     QStringList getValidationWarnings() const;
 
+    /** Сводка, достаточная для расчёта стоимости без разбора подробностей */
+    struct DetailsSummary {
+        int adults = 0;
+        int children = 0;
+        double animalSurcharge = 0.0;
+    };
+    /**
+     * Счётчики туристов и сумма доплат за животных. Ведутся в addAdult/addChild/
+     * removeTourist/addAnimal/removeAnimal; у неразобранной заявки — из сводки файла.
+     */
+    const DetailsSummary& totals() const { return totals_; }
+
+    // --- Отложенные подробности (ленивая загрузка) ---
+    /**
+     * Туристы, животные и документы остаются неразобранной JSON-записью заявки
+     * и разбираются при первом обращении к ним (см. materialize()).
+     */
+    void setPendingDetails(const QByteArray& payload, const DetailsSummary& summary);
+    bool hasPendingDetails() const { return !pendingDetails_.isEmpty(); }
+    const QByteArray& pendingDetails() const { return pendingDetails_; }
+    /**
+     * Разбирает отложенные подробности, если они есть. Если запись разобрать
+     * не удалось, она остаётся как была (и так же пишется в файл), а заявка
+     * считается повреждённой: false и текст ошибки в err; изменять туристов,
+     * животных и документы такой заявки нельзя (исключение std::runtime_error).
+     */
+    bool materialize(QString* err = nullptr) const;
+    bool detailsBroken() const { return !detailsError_.isEmpty(); }
+    const QString& detailsError() const { return detailsError_; }
+
 private:
     int id_;
     Client* client_;
@@ -67,11 +133,33 @@ private:
     RequestStatus status_;
     QString travelMode_;
     QString travelClass_;
-    std::vector<std::unique_ptr<Tourist>> tourists_;
-    std::vector<std::unique_ptr<Animal>> animals_;
-    std::vector<std::unique_ptr<Document>> documents_;
-    static int nextId;
+    // Подробности разбираются по первому обращению, в том числе из const-методов
+    mutable std::vector<std::unique_ptr<Tourist>> tourists_;
+    mutable std::vector<std::unique_ptr<Animal>> animals_;
+    mutable std::vector<std::unique_ptr<Document>> documents_;
+    mutable QByteArray pendingDetails_;
+    mutable DetailsSummary totals_;
+    mutable QString detailsError_;  // непусто — pendingDetails_ не разбирается
+    // Кэш полноты; флаг выставляют сами документы и туристы (bindChangeFlag)
+    struct Completeness {
+        std::vector<DocumentMask> tourists;
+        DocumentMask request = 0;
+        bool complete = false;
+        std::uint64_t rulesRevision = 0;
+        bool summaryReady = false;
+        QStringList summary;
+    };
+    mutable Completeness completeness_;
+    mutable bool completenessStale_ = true;
+    // Атомарный: заявки при загрузке создаются из нескольких потоков
+    static std::atomic<int> nextId;
     static constexpr double CHILD_DISCOUNT = 0.5;   // 50% скидка детям
     static constexpr double ANIMAL_BASE = 1000.0;   // базовая доплата за животное
     static constexpr double ANIMAL_PER_KG = 5.0;    // доплата за кг веса
+
+    void decodePendingDetails() const;
+    /** materialize() перед изменением подробностей; у повреждённой заявки — исключение */
+    void materializeForEdit();
+    void refreshCompleteness() const;
+    void bindChangeFlags() const;
 };
@@ -3,6 +3,17 @@
 #include <algorithm>
 #include <stdexcept>
 
+Tourist::Tourist(const Tourist& other) {
+    documents_.reserve(other.documents_.size());
+    for (const auto& d : other.documents_)
+        documents_.push_back(std::make_unique<Document>(*d));
+}
+
+void Tourist::bindChangeFlag(bool* changed) {
+    changed_ = changed;
+    for (auto& d : documents_) d->bindChangeFlag(changed);
+}
+
 AdultTourist::AdultTourist(const QString& lastName, const QString& firstName, const QString& middleName)
     : lastName_(lastName), firstName_(firstName), middleName_(middleName) {
     if (lastName.trimmed().isEmpty() || firstName.trimmed().isEmpty())
@@ -61,4 +72,5 @@ void ChildTourist::setDateOfBirth(const QDate& d) {
     if (age > 18)
         throw std::invalid_argument("Возраст ребёнка не может быть больше 18 лет");
     dateOfBirth_ = d;
+    touch();
 }
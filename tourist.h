@@ -14,6 +14,8 @@
 class Tourist {
 public:
     virtual ~Tourist() = default;
+    /** Независимая копия вместе с документами */
+    virtual std::unique_ptr<Tourist> clone() const = 0;
     virtual bool isChild() const = 0;
     virtual int getAge(const QDate& asOf = QDate::currentDate()) const = 0;
     virtual QString displayName() const = 0;
@@ -23,16 +25,25 @@ public:
     virtual QString getMiddleName() const = 0;
     virtual bool hasBenefit() const = 0;
     virtual void setHasBenefit(bool value) = 0;
-    std::vector<std::unique_ptr<Document>>& documents() { return documents_; }
+    /** Неконстантный доступ считается изменением документов */
+    std::vector<std::unique_ptr<Document>>& documents() { touch(); return documents_; }
     const std::vector<std::unique_ptr<Document>>& documents() const { return documents_; }
-    void clearDocuments() { documents_.clear(); }
+    void clearDocuments() { documents_.clear(); touch(); }
+    /** Флаг владельца (заявки) для туриста и его документов, см. Document::bindChangeFlag */
+    void bindChangeFlag(bool* changed);
 protected:
+    Tourist() = default;
+    Tourist(const Tourist& other);
     std::vector<std::unique_ptr<Document>> documents_;
+    bool* changed_ = nullptr;
+
+    void touch() { if (changed_) *changed_ = true; }
 };
 
 class AdultTourist : public Tourist {
 public:
     AdultTourist(const QString& lastName, const QString& firstName, const QString& middleName);
+    std::unique_ptr<Tourist> clone() const override { return std::make_unique<AdultTourist>(*this); }
     bool isChild() const override { return false; }
     int getAge(const QDate&) const override { return 0; }
     QString displayName() const override;
@@ -41,10 +52,10 @@ public:
     QString getFirstName() const override { return firstName_; }
     QString getMiddleName() const override { return middleName_; }
     bool hasBenefit() const override { return hasBenefit_; }
-    void setHasBenefit(bool value) override { hasBenefit_ = value; }
-    void setLastName(const QString& n) { lastName_ = n; }
-    void setFirstName(const QString& n) { firstName_ = n; }
-    void setMiddleName(const QString& n) { middleName_ = n; }
+    void setHasBenefit(bool value) override { hasBenefit_ = value; touch(); }
+    void setLastName(const QString& n) { lastName_ = n; touch(); }
+    void setFirstName(const QString& n) { firstName_ = n; touch(); }
+    void setMiddleName(const QString& n) { middleName_ = n; touch(); }
 private:
     QString lastName_;
     QString firstName_;
@@ -56,6 +67,7 @@ class ChildTourist : public Tourist {
 public:
     ChildTourist(const QString& lastName, const QString& firstName, const QString& middleName,
                  const QDate& dateOfBirth);
+    std::unique_ptr<Tourist> clone() const override { return std::make_unique<ChildTourist>(*this); }
     bool isChild() const override { return true; }
     /** Автоматическое определение возраста по дате рождения на указанную дату */
     int getAge(const QDate& asOf = QDate::currentDate()) const override;
@@ -65,11 +77,11 @@ public:
     QString getFirstName() const override { return firstName_; }
     QString getMiddleName() const override { return middleName_; }
     bool hasBenefit() const override { return hasBenefit_; }
-    void setHasBenefit(bool value) override { hasBenefit_ = value; }
+    void setHasBenefit(bool value) override { hasBenefit_ = value; touch(); }
     QDate getDateOfBirth() const { return dateOfBirth_; }
-    void setLastName(const QString& n) { lastName_ = n; }
-    void setFirstName(const QString& n) { firstName_ = n; }
-    void setMiddleName(const QString& n) { middleName_ = n; }
+    void setLastName(const QString& n) { lastName_ = n; touch(); }
+    void setFirstName(const QString& n) { firstName_ = n; touch(); }
+    void setMiddleName(const QString& n) { middleName_ = n; touch(); }
     void setDateOfBirth(const QDate& d);
 private:
     QString lastName_;
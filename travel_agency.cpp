@@ -4,20 +4,184 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QTextStream>
+#include <QtConcurrent>
+#include <QtGlobal>
 
 #include <algorithm>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
-#include <tuple>
+#include <unordered_set>
+#include <utility>
 
+#include "binary_snapshot.h"
 #include "client_service.h"
+#include "document_service.h"
+#include "json_stream_reader.h"
+#include "request_service.h"
+#include "serialization_service.h"
+
+namespace {
+
+const char* const LOAD_CANCELED = "Загрузка отменена";
+
+QByteArray journalRecord(const QString& op, const QString& key, const QJsonValue& value) {
+    QJsonObject r;
+    r["op"] = op;
+    r[key] = value;
+    return QJsonDocument(r).toJson(QJsonDocument::Compact);
+}
+
+/** "putRequest": отложенные подробности заявки пишутся байтами, без разбора */
+QByteArray putRequestRecord(const TourRequest& r) {
+    return "{\"op\":\"putRequest\",\"request\":" + SerializationService::requestToJsonBytes(r) + '}';
+}
+
+void assignClient(Client* dst, const Client& src) {
+    dst->setLastName(src.getLastName());
+    dst->setFirstName(src.getFirstName());
+    dst->setMiddleName(src.getMiddleName());
+    dst->setPhone(src.getPhone());
+    dst->setEmail(src.getEmail());
+    dst->setDateOfBirth(src.getDateOfBirth());
+    dst->setComments(src.getComments());
+    dst->setRegistrationAddress(src.getRegistrationAddress());
+    dst->setActualAddress(src.getActualAddress());
+}
+
+void assignTour(Tour* dst, const Tour& src) {
+    dst->setName(src.getName());
+    dst->setCountry(src.getCountry());
+    dst->setTourType(src.getTourType());
+    dst->setStartDate(src.getStartDate());
+    dst->setDurationDays(src.getDurationDays());
+    dst->setBasePrice(src.getBasePrice());
+    dst->setDomestic(src.isDomestic());
+    dst->setVisaRequired(src.isVisaRequired());
+    dst->setTravelModes(src.getTravelModes());
+}
+
+} // namespace
+
+QString LoadIssue::message() const {
+    const QString target = kind == Kind::MissingClient ? "клиента" : "тура";
+    return QString("Заявка %1 пропущена: нет %2 с id %3").arg(requestId).arg(target).arg(referencedId);
+}
 
 TravelAgency::TravelAgency() = default;
 
 TravelAgency::~TravelAgency() {
+    clearAll();
+}
+
+void TravelAgency::registerClient(Client* c) {
+    clients_.push_back(c);
+    clientsById_.emplace(c->getId(), c);
+    if (searchIndexReady_) searchIndex_.add(c);
+}
+
+void TravelAgency::registerTour(Tour* t) {
+    tours_.push_back(t);
+    toursById_.emplace(t->getId(), t);
+}
+
+void TravelAgency::registerRequest(TourRequest* r) {
+    requests_.push_back(r);
+    requestsById_.emplace(r->getId(), r);
+    requestsByClient_[r->getClient()->getId()].push_back(r);
+    requestsByTour_[r->getTour()->getId()].push_back(r);
+    if (expiryIndexReady_) expiryIndex_.update(*r);
+    updateRevenue(*r);
+}
+
+void TravelAgency::unregisterRequest(TourRequest* r) {
+    auto removeFrom = [r](std::unordered_map<int, std::vector<TourRequest*>>& index, int key) {
+        auto it = index.find(key);
+        if (it == index.end()) return;
+        auto& list = it->second;
+        list.erase(std::find(list.begin(), list.end(), r));
+        if (list.empty()) index.erase(it);
+    };
+    removeFrom(requestsByClient_, r->getClient()->getId());
+    removeFrom(requestsByTour_, r->getTour()->getId());
+    requests_.erase(std::find(requests_.begin(), requests_.end(), r));
+    requestsById_.erase(r->getId());
+    if (expiryIndexReady_) expiryIndex_.remove(r->getId());
+    removeRevenue(r->getId());
+}
+
+void TravelAgency::replaceRequest(TourRequest* old, TourRequest* fresh) {
+    if (old->getClient() != fresh->getClient() || old->getTour() != fresh->getTour()) {
+        unregisterRequest(old);
+        delete old;
+        registerRequest(fresh);
+        return;
+    }
+    // Тот же клиент и тур: заявка остаётся на своём месте во всех списках
+    auto swapIn = [old, fresh](std::vector<TourRequest*>& list) {
+        *std::find(list.begin(), list.end(), old) = fresh;
+    };
+    swapIn(requests_);
+    swapIn(requestsByClient_[fresh->getClient()->getId()]);
+    swapIn(requestsByTour_[fresh->getTour()->getId()]);
+    requestsById_[fresh->getId()] = fresh;
+    if (expiryIndexReady_) expiryIndex_.update(*fresh);
+    updateRevenue(*fresh);
+    delete old;
+}
+
+void TravelAgency::noteDanglingRefs(const QJsonObject& request) {
+    const int id = request["id"].toInt();
+    const int clientId = request["clientId"].toInt();
+    const int tourId = request["tourId"].toInt();
+    if (!findClientById(clientId))
+        loadIssues_.push_back({LoadIssue::Kind::MissingClient, id, clientId});
+    if (!findTourById(tourId))
+        loadIssues_.push_back({LoadIssue::Kind::MissingTour, id, tourId});
+}
+
+void TravelAgency::swapData(TravelAgency& other) {
+    std::swap(clients_, other.clients_);
+    std::swap(tours_, other.tours_);
+    std::swap(requests_, other.requests_);
+    std::swap(clientsById_, other.clientsById_);
+    std::swap(toursById_, other.toursById_);
+    std::swap(requestsById_, other.requestsById_);
+    std::swap(requestsByClient_, other.requestsByClient_);
+    std::swap(requestsByTour_, other.requestsByTour_);
+    std::swap(revenueByStatus_, other.revenueByStatus_);
+    std::swap(revenueShares_, other.revenueShares_);
+    std::swap(loadIssues_, other.loadIssues_);
+    // Ленивые индексы строятся заново при первом обращении
+    for (TravelAgency* a : {this, &other}) {
+        a->searchIndex_.clear();
+        a->searchIndexReady_ = false;
+        a->expiryIndex_.clear();
+        a->expiryIndexReady_ = false;
+    }
+}
+
+void TravelAgency::clearAll() {
+    // Заявки удаляются первыми (ссылаются на клиентов и туры)
+    for (auto* r : requests_) delete r;
+    requests_.clear();
     for (auto* c : clients_) delete c;
+    clients_.clear();
     for (auto* t : tours_) delete t;
-    for (auto* r : requests_) delete r;
+    tours_.clear();
+    requestsById_.clear();
+    clientsById_.clear();
+    toursById_.clear();
+    requestsByClient_.clear();
+    requestsByTour_.clear();
+    searchIndex_.clear();
+    searchIndexReady_ = false;
+    expiryIndex_.clear();
+    expiryIndexReady_ = false;
+    revenueByStatus_.fill(0);
+    revenueShares_.clear();
 }
 
 Client* TravelAgency::addClient(const QString& lastName, const QString& firstName, const QString& middleName,
@@ -27,7 +191,8 @@ Client* TravelAgency::addClient(const QString& lastName, const QString& firstNam
     Client* c = ClientService::createClient(lastName, firstName, middleName, phone, email, dateOfBirth,
                                             registrationAddress, actualAddress, comments, 0, err);
     if (!c) return nullptr;
-    clients_.push_back(c);
+    registerClient(c);
+    journal(journalRecord("putClient", "client", SerializationService::clientToJson(*c)));
     return c;
 }
 
@@ -50,50 +215,47 @@ bool TravelAgency::editClient(int id, const QString& lastName, const QString& fi
     c->setComments(comments);
     c->setRegistrationAddress(registrationAddress);
     c->setActualAddress(actualAddress);
+    if (searchIndexReady_) searchIndex_.update(c);
+    journal(journalRecord("putClient", "client", SerializationService::clientToJson(*c)));
     return true;
 }
 
 bool TravelAgency::deleteClient(int id, QString* err) {
-    for (auto it = clients_.begin(); it != clients_.end(); ++it) {
-        if ((*it)->getId() == id) {
-            for (auto* r : requests_)
-                if (r->getClient()->getId() == id) {
-                    if (err) *err = "Невозможно удалить: есть заявки по этому клиенту";
-                    return false;
-                }
-            delete *it;
-            clients_.erase(it);
-            return true;
-        }
+    Client* c = findClientById(id);
+    if (!c) { if (err) *err = "Клиент не найден"; return false; }
+    if (requestsByClient_.count(id)) {
+        if (err) *err = "Невозможно удалить: есть заявки по этому клиенту";
+        return false;
     }
-    if (err) *err = "Клиент не найден";
-    return false;
+    clients_.erase(std::find(clients_.begin(), clients_.end(), c));
+    clientsById_.erase(id);
+    if (searchIndexReady_) searchIndex_.remove(c);
+    delete c;
+    journal(journalRecord("deleteClient", "id", id));
+    return true;
 }
 
 Client* TravelAgency::findClientById(int id) const {
-    for (auto* c : clients_) if (c->getId() == id) return c;
-    return nullptr;
+    auto it = clientsById_.find(id);
+    return it != clientsById_.end() ? it->second : nullptr;
 }
 
 std::vector<Client*> TravelAgency::searchClients(const QString& query) const {
-    std::vector<Client*> out;
     QString q = query.trimmed().toLower();
-    if (q.isEmpty()) return out;
-    for (auto* c : clients_) {
-        if (c->getFullName().toLower().contains(q) ||
-            c->getPhone().contains(q) ||
-            c->getEmail().toLower().contains(q))
-            out.push_back(c);
-    }
-    return out;
+    if (q.isEmpty()) return {};
+    prepareClientSearch();
+    return searchIndex_.search(q);
+}
+
+void TravelAgency::prepareClientSearch() const {
+    if (searchIndexReady_) return;
+    for (auto* c : clients_) searchIndex_.add(c);
+    searchIndexReady_ = true;
 }
 
 std::vector<TourRequest*> TravelAgency::getSalesHistoryForClient(int clientId) const {
-    std::vector<TourRequest*> out;
-    for (auto* r : requests_)
-        if (r->getClient()->getId() == clientId)
-            out.push_back(r);
-    return out;
+    auto it = requestsByClient_.find(clientId);
+    return it != requestsByClient_.end() ? it->second : std::vector<TourRequest*>();
 }
 
 // --- Tours ---
@@ -103,7 +265,8 @@ Tour* TravelAgency::addTour(const QString& name, const QString& country, const Q
                             QString* err) {
     try {
         auto* t = new Tour(name, country, tourType, startDate, durationDays, basePrice, isDomestic, visaRequired, travelModes);
-        tours_.push_back(t);
+        registerTour(t);
+        journal(journalRecord("putTour", "tour", SerializationService::tourToJson(*t)));
         return t;
     } catch (const std::exception& e) {
         if (err) *err = e.what();
@@ -127,6 +290,8 @@ bool TravelAgency::editTour(int id, const QString& name, const QString& country,
         t->setDomestic(isDomestic);
         t->setVisaRequired(visaRequired);
         t->setTravelModes(travelModes);
+        refreshTourRequests(id);
+        journal(journalRecord("putTour", "tour", SerializationService::tourToJson(*t)));
         return true;
     } catch (const std::exception& e) {
         if (err) *err = e.what();
@@ -134,26 +299,34 @@ bool TravelAgency::editTour(int id, const QString& name, const QString& country,
     }
 }
 
+void TravelAgency::refreshTourRequests(int tourId) {
+    // От тура зависят требуемые документы его заявок, проверка сроков и стоимость
+    auto it = requestsByTour_.find(tourId);
+    if (it == requestsByTour_.end()) return;
+    for (TourRequest* r : it->second) {
+        r->invalidateCompleteness();
+        if (expiryIndexReady_) expiryIndex_.update(*r);
+        updateRevenue(*r);
+    }
+}
+
 bool TravelAgency::deleteTour(int id, QString* err) {
-    for (auto it = tours_.begin(); it != tours_.end(); ++it) {
-        if ((*it)->getId() == id) {
-            for (auto* r : requests_)
-                if (r->getTour()->getId() == id) {
-                    if (err) *err = "Невозможно удалить: есть заявки на этот тур";
-                    return false;
-                }
-            delete *it;
-            tours_.erase(it);
-            return true;
-        }
+    Tour* t = findTourById(id);
+    if (!t) { if (err) *err = "Тур не найден"; return false; }
+    if (requestsByTour_.count(id)) {
+        if (err) *err = "Невозможно удалить: есть заявки на этот тур";
+        return false;
     }
-    if (err) *err = "Тур не найден";
-    return false;
+    tours_.erase(std::find(tours_.begin(), tours_.end(), t));
+    toursById_.erase(id);
+    delete t;
+    journal(journalRecord("deleteTour", "id", id));
+    return true;
 }
 
 Tour* TravelAgency::findTourById(int id) const {
-    for (auto* t : tours_) if (t->getId() == id) return t;
-    return nullptr;
+    auto it = toursById_.find(id);
+    return it != toursById_.end() ? it->second : nullptr;
 }
 
 // --- Requests ---
@@ -164,7 +337,8 @@ TourRequest* TravelAgency::createRequest(int clientId, int tourId, QString* err)
     if (!t) { if (err) *err = "Тур не найден"; return nullptr; }
     try {
         auto* r = new TourRequest(c, t);
-        requests_.push_back(r);
+        registerRequest(r);
+        journal(putRequestRecord(*r));
         return r;
     } catch (const std::exception& e) {
         if (err) *err = e.what();
@@ -173,131 +347,191 @@ TourRequest* TravelAgency::createRequest(int clientId, int tourId, QString* err)
 }
 
 bool TravelAgency::deleteRequest(int id, QString* err) {
-    for (auto it = requests_.begin(); it != requests_.end(); ++it) {
-        if ((*it)->getId() == id) {
-            delete *it;
-            requests_.erase(it);
-            return true;
+    TourRequest* r = findRequestById(id);
+    if (!r) { if (err) *err = "Заявка не найдена"; return false; }
+    unregisterRequest(r);
+    delete r;
+    journal(journalRecord("deleteRequest", "id", id));
+    return true;
+}
+
+TourRequest* TravelAgency::findRequestById(int id) const {
+    auto it = requestsById_.find(id);
+    return it != requestsById_.end() ? it->second : nullptr;
+}
+
+std::vector<TourRequest*> TravelAgency::getRequestsForTour(int tourId) const {
+    auto it = requestsByTour_.find(tourId);
+    return it != requestsByTour_.end() ? it->second : std::vector<TourRequest*>();
+}
+
+std::vector<DocumentAuditEntry> TravelAgency::auditDocuments(const DocumentAuditFilter& filter) const {
+    auto selected = [&filter](const TourRequest* r) {
+        if (!filter.includeCanceled && r->getStatus() == RequestStatus::Canceled) return false;
+        const QDate departure = r->getTour()->getStartDate();
+        return (!filter.departureFrom.isValid() || departure >= filter.departureFrom)
+               && (!filter.departureTo.isValid() || departure <= filter.departureTo);
+    };
+    std::vector<const TourRequest*> requests;
+    auto byTour = requestsByTour_.find(filter.tourId);
+    if (filter.tourId > 0 && byTour == requestsByTour_.end()) return {};
+    for (const TourRequest* r : filter.tourId > 0 ? byTour->second : requests_)
+        if (selected(r)) requests.push_back(r);
+
+    // Каждая заявка проверяется одним потоком и пишет только в свою ячейку
+    const int count = static_cast<int>(requests.size());
+    std::vector<std::vector<DocumentAuditEntry>> perRequest(count);
+    auto audit = [&](int i) {
+        const TourRequest& r = *requests[i];
+        if (r.isComplete()) return;
+        const auto& tourists = r.getTourists();
+        const auto& missing = r.missingTouristDocuments();
+        for (size_t k = 0; k < missing.size(); ++k) {
+            if (!missing[k]) continue;
+            const Tourist& t = *tourists[k];
+            perRequest[i].push_back({r.getId(), static_cast<int>(k), missing[k],
+                                     missing[k] & DocumentService::statusMask(t.documents(), DocumentStatus::Available)});
+        }
+        if (const DocumentMask m = r.missingRequestDocuments()) {
+            perRequest[i].push_back({r.getId(), -1, m,
+                                     m & DocumentService::statusMask(r.getDocuments(), DocumentStatus::Available)});
         }
+    };
+    if (count < PARALLEL_AUDIT_MIN) {
+        for (int i = 0; i < count; ++i) audit(i);
+    } else {
+        std::vector<int> indices(count);
+        std::iota(indices.begin(), indices.end(), 0);
+        QtConcurrent::blockingMap(indices, audit);
     }
-    if (err) *err = "Заявка не найдена";
-    return false;
+
+    std::vector<DocumentAuditEntry> out;
+    for (auto& entries : perRequest)
+        out.insert(out.end(), entries.begin(), entries.end());
+    return out;
 }
 
-TourRequest* TravelAgency::findRequestById(int id) const {
-    for (auto* r : requests_) if (r->getId() == id) return r;
-    return nullptr;
+void TravelAgency::ensureExpiryIndex() const {
+    if (expiryIndexReady_) return;
+    for (const TourRequest* r : requests_) expiryIndex_.update(*r);
+    expiryIndexReady_ = true;
 }
 
-// --- Save / Load (JSON) ---
-bool TravelAgency::saveToFile(const QString& path, QString* err) const {
-    QJsonObject root;
-    QJsonArray arrClients, arrTours, arrRequests;
+std::vector<DocumentValidity> TravelAgency::documentsInvalidForTrip() const {
+    ensureExpiryIndex();
+    return expiryIndex_.invalidForTrip();
+}
 
-    for (auto* c : clients_) {
-        QJsonObject o;
-        o["id"] = c->getId();
-        o["lastName"] = c->getLastName();
-        o["firstName"] = c->getFirstName();
-        o["middleName"] = c->getMiddleName();
-        o["fullName"] = c->getFullName();
-        o["phone"] = c->getPhone();
-        o["email"] = c->getEmail();
-        o["dateOfBirth"] = c->getDateOfBirth().toString(Qt::ISODate);
-        o["comments"] = c->getComments();
-        o["registrationAddress"] = c->getRegistrationAddress().toJson();
-        o["actualAddress"] = c->getActualAddress().toJson();
-        arrClients.append(o);
-    }
-
-    for (auto* t : tours_) {
-        QJsonObject o;
-        o["id"] = t->getId();
-        o["name"] = t->getName();
-        o["country"] = t->getCountry();
-        o["tourType"] = t->getTourType();
-        o["startDate"] = t->getStartDate().toString(Qt::ISODate);
-        o["durationDays"] = t->getDurationDays();
-        o["basePrice"] = t->getBasePrice();
-        o["isDomestic"] = t->isDomestic();
-        o["visaRequired"] = t->isVisaRequired();
-        QJsonArray travelModes;
-        for (const QString& mode : t->getTravelModes())
-            travelModes.append(mode);
-        o["travelModes"] = travelModes;
-        arrTours.append(o);
+std::vector<DocumentValidity> TravelAgency::documentsExpiringWithin(int days, const QDate& from) const {
+    ensureExpiryIndex();
+    return expiryIndex_.expiringWithin(from, days);
+}
+
+QStringList TravelAgency::documentValidityWarnings(int requestId) const {
+    const TourRequest* r = findRequestById(requestId);
+    if (!r) return {};
+    std::vector<DocumentValidity> invalid;
+    if (expiryIndexReady_) {
+        invalid = expiryIndex_.invalidForTrip(requestId);
+    } else {
+        for (const DocumentValidity& v : DocumentExpiryIndex::collect(*r))
+            if (!DocumentExpiryIndex::coversTrip(v, *r->getTour())) invalid.push_back(v);
     }
+    QStringList out;
+    for (const DocumentValidity& v : invalid) out << DocumentExpiryIndex::describe(v, *r);
+    return out;
+}
 
-    for (auto* r : requests_) {
-        QJsonObject o;
-        o["id"] = r->getId();
-        o["clientId"] = r->getClient()->getId();
-        o["tourId"] = r->getTour()->getId();
-        o["status"] = static_cast<int>(r->getStatus());
-        o["travelMode"] = r->getTravelMode();
-        o["travelClass"] = r->getTravelClass();
-
-        QJsonArray tourists, animals, documents;
-
-        for (const auto& t : r->getTourists()) {
-            QJsonObject to;
-            to["isChild"] = t->isChild();
-            to["lastName"] = t->getLastName();
-            to["firstName"] = t->getFirstName();
-            to["middleName"] = t->getMiddleName();
-            to["fullName"] = t->getFullName();
-            to["hasBenefit"] = t->hasBenefit();
-            if (t->isChild()) {
-                to["dateOfBirth"] = static_cast<ChildTourist*>(t.get())->getDateOfBirth().toString(Qt::ISODate);
-            }
-            QJsonArray touristDocs;
-            for (const auto& doc : t->documents()) {
-                QJsonObject docObj;
-                docObj["type"] = static_cast<int>(doc->getType());
-                docObj["status"] = static_cast<int>(doc->getStatus());
-                docObj["fields"] = QJsonObject::fromVariantMap(doc->fields());
-                touristDocs.append(docObj);
-            }
-            to["documents"] = touristDocs;
-            tourists.append(to);
-        }
+double TravelAgency::revenue(RequestStatus status) const {
+    return revenueByStatus_[static_cast<int>(status)] / 100.0;
+}
 
-        for (const auto& a : r->getAnimals()) {
-            QJsonObject ao;
-            ao["type"] = a->getType();
-            ao["weight"] = a->getWeight();
-            ao["transport"] = a->getTransport();
-            animals.append(ao);
-        }
+void TravelAgency::updateRevenue(const TourRequest& r) {
+    removeRevenue(r.getId());
+    const RevenueShare share{r.getStatus(), qRound64(r.calculateTotalCost() * 100.0)};
+    revenueByStatus_[static_cast<int>(share.status)] += share.kopecks;
+    revenueShares_.emplace(r.getId(), share);
+}
 
-        for (const auto& d : r->getDocuments()) {
-            QJsonObject docObj;
-            docObj["type"] = static_cast<int>(d->getType());
-            docObj["status"] = static_cast<int>(d->getStatus());
-            docObj["fields"] = QJsonObject::fromVariantMap(d->fields());
-            documents.append(docObj);
-        }
+void TravelAgency::removeRevenue(int requestId) {
+    auto it = revenueShares_.find(requestId);
+    if (it == revenueShares_.end()) return;
+    revenueByStatus_[static_cast<int>(it->second.status)] -= it->second.kopecks;
+    revenueShares_.erase(it);
+}
 
-        o["tourists"] = tourists;
-        o["animals"] = animals;
-        o["documents"] = documents;
-        arrRequests.append(o);
+std::unique_ptr<TravelAgency> TravelAgency::clone() const {
+    auto copy = std::make_unique<TravelAgency>();
+    for (auto* c : clients_) copy->registerClient(new Client(*c));
+    for (auto* t : tours_) copy->registerTour(new Tour(*t));
+    for (auto* r : requests_) {
+        copy->registerRequest(r->clone(copy->findClientById(r->getClient()->getId()),
+                                       copy->findTourById(r->getTour()->getId())));
     }
+    return copy;
+}
 
-    root["clients"] = arrClients;
-    root["tours"] = arrTours;
-    root["requests"] = arrRequests;
+// --- Save / Load (JSON) ---
+bool TravelAgency::saveToFile(const QString& path, QString* err) const {
+    return saveToFile(path, SaveProgress(), err);
+}
 
-    QFile f(path);
+bool TravelAgency::saveToFile(const QString& path, const SaveProgress& progress, QString* err) const {
+    const qint64 total = static_cast<qint64>(clients_.size() + tours_.size() + requests_.size());
+    qint64 done = 0;
+    auto step = [&]() {
+        if (progress && ++done % SAVE_PROGRESS_STEP == 0) progress(done, total);
+    };
+
+    // Старый файл заменяется только после полной записи нового
+    QSaveFile f(path);
     if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
         if (err) *err = "Не удалось открыть файл для записи";
         return false;
     }
-    f.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+
+    // Корень пишется по записи в порядке clients, tours, requests: QJsonObject
+    // сортирует ключи, и "requests" оказался бы раньше "tours" — тогда потоковая
+    // загрузка читала бы файл дважды (заявкам нужны уже загруженные туры)
+    auto writeArray = [&](const char* key, const auto& items, const auto& toBytes, bool last) {
+        f.write(QByteArray("    \"") + key + "\": [");
+        bool first = true;
+        for (const auto* item : items) {
+            f.write(first ? "\n        " : ",\n        ");
+            f.write(toBytes(*item));
+            first = false;
+            step();
+        }
+        f.write(first ? "]" : "\n    ]");
+        f.write(last ? "\n" : ",\n");
+    };
+    f.write("{\n");
+    auto compact = [](const QJsonObject& o) { return QJsonDocument(o).toJson(QJsonDocument::Compact); };
+    writeArray("clients", clients_, [&](const Client& c) { return compact(SerializationService::clientToJson(c)); }, false);
+    writeArray("tours", tours_, [&](const Tour& t) { return compact(SerializationService::tourToJson(t)); }, false);
+    writeArray("requests", requests_, SerializationService::requestToJsonBytes, true);
+    f.write("}\n");
+    if (!f.commit()) {
+        if (err) *err = "Не удалось записать файл: " + f.errorString();
+        return false;
+    }
+    if (progress) progress(total, total);
     return true;
 }
 
 bool TravelAgency::loadFromFile(const QString& path, QString* err) {
+    // Разбор в отдельный объект: при ошибке текущие данные не меняются
+    TravelAgency fresh;
+    fresh.lazyRequestDetails_ = lazyRequestDetails_;
+    if (!fresh.readJson(path, err)) return false;
+    return adoptData(fresh, err);
+}
+
+bool TravelAgency::readJson(const QString& path, QString* err) {
+    // Отложенным подробностям нужен исходный текст записей — его отдаёт
+    // потоковый разбор, без построения дерева всего файла
+    if (lazyRequestDetails_) return readJsonStreaming(path, {}, nullptr, err);
+
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
         if (err) *err = "Не удалось открыть файл";
@@ -313,138 +547,468 @@ bool TravelAgency::loadFromFile(const QString& path, QString* err) {
 
     QJsonObject root = doc.object();
 
-    // Очищаем и загружаем заявки в последнюю очередь (зависят от клиентов и туров)
-    for (auto* r : requests_) delete r;
-    requests_.clear();
-    for (auto* c : clients_) delete c;
-    clients_.clear();
-    for (auto* t : tours_) delete t;
-    tours_.clear();
+    // Заявки загружаются в последнюю очередь (зависят от клиентов и туров)
+    try {
+        for (const QJsonValue& v : root["clients"].toArray())
+            registerClient(SerializationService::clientFromJson(v.toObject()));
 
-    // Клиенты
-    auto parseLegacyName = [](const QString& fullName) {
-        QStringList parts = fullName.split(' ', Qt::SkipEmptyParts);
-        QString last = parts.value(0);
-        QString first = parts.value(1);
-        QString middle = parts.mid(2).join(' ');
-        return std::tuple<QString, QString, QString>(last, first, middle);
+        for (const QJsonValue& v : root["tours"].toArray())
+            registerTour(SerializationService::tourFromJson(v.toObject()));
+    } catch (const std::exception& e) {
+        if (err) *err = QString("Некорректные данные: %1").arg(e.what());
+        return false;
+    }
+
+    // Заявки — основной объём данных: разбираются параллельно в отдельные
+    // объекты (клиенты и туры здесь только читаются), затем регистрируются
+    // последовательно в порядке файла. id берутся из файла, поэтому итог
+    // (включая TourRequest::nextId) тот же, что при разборе в одном потоке.
+    const QJsonArray requestsArr = root["requests"].toArray();
+    const int count = static_cast<int>(requestsArr.size());
+    std::vector<TourRequest*> decoded(count, nullptr);
+    std::vector<QString> errors(count);
+    auto decode = [&](int i) {
+        const QJsonObject o = requestsArr.at(i).toObject();
+        Client* c = findClientById(o["clientId"].toInt());
+        Tour* t = findTourById(o["tourId"].toInt());
+        if (!c || !t) return;
+        try {
+            decoded[i] = SerializationService::requestFromJson(o, c, t);
+        } catch (const std::exception& e) {
+            errors[i] = e.what();
+        }
+    };
+    // Записи без id получают его из счётчика по порядку — такие разбираются в одном потоке
+    bool parallel = count >= PARALLEL_DECODE_MIN;
+    for (int i = 0; parallel && i < count; ++i)
+        parallel = requestsArr.at(i).toObject()["id"].toInt() > 0;
+    if (!parallel) {
+        for (int i = 0; i < count; ++i) decode(i);
+    } else {
+        std::vector<int> indices(count);
+        std::iota(indices.begin(), indices.end(), 0);
+        QtConcurrent::blockingMap(indices, [&decode](int i) { decode(i); });
+    }
+
+    // Как и раньше, сообщается первая по порядку ошибка
+    const auto failed = std::find_if(errors.begin(), errors.end(),
+                                     [](const QString& e) { return !e.isEmpty(); });
+    if (failed != errors.end()) {
+        for (auto* r : decoded) delete r;
+        if (err) *err = QString("Некорректные данные: %1").arg(*failed);
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (decoded[i]) registerRequest(decoded[i]);
+        else noteDanglingRefs(requestsArr.at(i).toObject());
+    }
+    return true;
+}
+
+bool TravelAgency::loadFromFileStreaming(const QString& path, const LoadProgress& progress, QString* err) {
+    TravelAgency fresh;
+    fresh.lazyRequestDetails_ = lazyRequestDetails_;
+    if (!fresh.readJsonStreaming(path, progress, nullptr, err)) return false;
+    return adoptData(fresh, err);
+}
+
+bool TravelAgency::readJsonStreaming(const QString& path, const LoadProgress& progress,
+                                     const std::atomic<bool>* cancelled, QString* err) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (err) *err = "Не удалось открыть файл";
+        return false;
+    }
+
+    const qint64 total = f.size();
+    qint64 done = 0;
+    qint64 lastReported = -1;
+    auto report = [&](qint64 value, bool force) {
+        done = value;
+        if (!progress || (!force && done - lastReported < PROGRESS_STEP)) return;
+        lastReported = done;
+        progress(done, total);
     };
 
-    for (const QJsonValue& v : root["clients"].toArray()) {
-        QJsonObject o = v.toObject();
-        int id = o["id"].toInt();
-        QString last = o["lastName"].toString();
-        QString first = o["firstName"].toString();
-        QString middle = o["middleName"].toString();
-        if (last.isEmpty() && first.isEmpty() && o.contains("fullName")) {
-            auto legacy = parseLegacyName(o["fullName"].toString());
-            last = std::get<0>(legacy);
-            first = std::get<1>(legacy);
-            middle = std::get<2>(legacy);
+    QString recordError;
+    auto decode = [&recordError](const QByteArray& bytes, QJsonObject* obj) {
+        QJsonParseError perr;
+        const QJsonDocument doc = QJsonDocument::fromJson(bytes, &perr);
+        if (!doc.isObject()) {
+            recordError = "Ошибка JSON: " + (doc.isNull() ? perr.errorString() : QString("ожидался объект"));
+            return false;
         }
-        Address reg = Address::fromJson(o["registrationAddress"].toObject());
-        Address actual = Address::fromJson(o["actualAddress"].toObject());
-        if (actual.isEmpty() && !reg.isEmpty()) actual = reg;
-        clients_.push_back(new Client(
-            last,
-            first,
-            middle,
-            o["phone"].toString(),
-            o["email"].toString(),
-            QDate::fromString(o["dateOfBirth"].toString(), Qt::ISODate),
-            reg,
-            actual,
-            o["comments"].toString(),
-            id
-            ));
-    }
-
-    // Туры
-    for (const QJsonValue& v : root["tours"].toArray()) {
-        QJsonObject o = v.toObject();
-        int id = o["id"].toInt();
-        tours_.push_back(new Tour(
-            o["name"].toString(),
-            o["country"].toString(),
-            o["tourType"].toString(),
-            QDate::fromString(o["startDate"].toString(), Qt::ISODate),
-            o["durationDays"].toInt(),
-            o["basePrice"].toDouble(),
-            o["isDomestic"].toBool(),
-            o["visaRequired"].toBool(),
-            [&o]() {
-                QStringList modes;
-                for (const QJsonValue& mv : o["travelModes"].toArray())
-                    modes.append(mv.toString());
-                return modes;
-            }(),
-            id
-            ));
-    }
-
-    // Заявки
-    for (const QJsonValue& v : root["requests"].toArray()) {
-        QJsonObject o = v.toObject();
-        int id = o["id"].toInt();
+        *obj = doc.object();
+        return true;
+    };
+    // Отмена проверяется перед каждой записью
+    auto stopped = [&recordError, cancelled]() {
+        if (!cancelled || !cancelled->load()) return false;
+        recordError = LOAD_CANCELED;
+        return true;
+    };
 
-        Client* c = findClientById(o["clientId"].toInt());
-        Tour* t = findTourById(o["tourId"].toInt());
-        if (!c || !t) continue;
-
-        TourRequest* r = new TourRequest(c, t, id);
-        r->setStatus(static_cast<RequestStatus>(o["status"].toInt()));
-        if (o.contains("travelMode"))
-            r->setTravelMode(o["travelMode"].toString());
-        if (o.contains("travelClass"))
-            r->setTravelClass(o["travelClass"].toString());
-
-        for (const QJsonValue& tv : o["tourists"].toArray()) {
-            QJsonObject to = tv.toObject();
-            QString last = to["lastName"].toString();
-            QString first = to["firstName"].toString();
-            QString middle = to["middleName"].toString();
-            if (last.isEmpty() && first.isEmpty() && to.contains("fullName")) {
-                auto legacy = parseLegacyName(to["fullName"].toString());
-                last = std::get<0>(legacy);
-                first = std::get<1>(legacy);
-                middle = std::get<2>(legacy);
+    // Элементы массива заявок: base — сколько байт уже учтено до начала массива
+    auto readRequests = [&](JsonStreamReader& reader, qint64 base, qint64 start) {
+        QByteArray raw;
+        QByteArray details;
+        QJsonObject o;
+        if (!reader.beginArray()) return true;
+        while (reader.nextElement(&raw)) {
+            if (stopped()) return false;
+            // Лениво разбирается только заголовок; подробности остаются байтами
+            if (lazyRequestDetails_) {
+                if (!SerializationService::splitRequestJson(raw, &o, &details, &recordError)) return false;
+            } else if (!decode(raw, &o)) {
+                return false;
             }
-            if (to["isChild"].toBool()) {
-                r->addChild(last, first, middle,
-                            QDate::fromString(to["dateOfBirth"].toString(), Qt::ISODate));
+            Client* c = findClientById(o["clientId"].toInt());
+            Tour* t = findTourById(o["tourId"].toInt());
+            if (!c || !t) noteDanglingRefs(o);
+            else if (lazyRequestDetails_) registerRequest(SerializationService::requestFromJsonLazy(o, details, c, t));
+            else registerRequest(SerializationService::requestFromJson(o, c, t));
+            report(base + reader.position() - start, false);
+        }
+        return true;
+    };
+
+    try {
+        JsonStreamReader reader(&f);
+        if (!reader.beginObject()) {
+            if (err) *err = "Ошибка JSON: " + reader.errorString();
+            return false;
+        }
+
+        // saveToFile пишет "requests" последним, и файл читается за один проход.
+        // В файлах с другим порядком ключей (например, записанных QJsonObject по
+        // алфавиту) массив заявок до "tours" пропускается и читается вторым проходом.
+        bool clientsSeen = false, toursSeen = false;
+        qint64 requestsOffset = -1;
+        qint64 deferred = 0;
+        QString key;
+        QByteArray raw;
+        QJsonObject o;
+        while (reader.nextKey(&key)) {
+            if (key == "clients" || key == "tours") {
+                const bool isClients = key == "clients";
+                if (reader.beginArray()) {
+                    while (reader.nextElement(&raw)) {
+                        if (stopped() || !decode(raw, &o)) break;
+                        if (isClients) registerClient(SerializationService::clientFromJson(o));
+                        else registerTour(SerializationService::tourFromJson(o));
+                        report(reader.position() - deferred, false);
+                    }
+                }
+                if (!recordError.isEmpty() || reader.hasError()) break;
+                if (isClients) clientsSeen = true;
+                else toursSeen = true;
+            } else if (key == "requests" && clientsSeen && toursSeen) {
+                const qint64 start = reader.position();
+                if (!readRequests(reader, start - deferred, start) || reader.hasError()) break;
+            } else if (key == "requests") {
+                requestsOffset = reader.position();
+                reader.skipValue();
+                deferred += reader.position() - requestsOffset;
             } else {
-                r->addAdult(last, first, middle);
-            }
-            auto& tourist = r->tourists().back();
-            tourist->setHasBenefit(to["hasBenefit"].toBool());
-            tourist->clearDocuments();
-            for (const QJsonValue& dv : to["documents"].toArray()) {
-                QJsonObject dobj = dv.toObject();
-                auto doc = std::make_unique<Document>(static_cast<DocumentType>(dobj["type"].toInt()));
-                doc->setStatus(static_cast<DocumentStatus>(dobj["status"].toInt()));
-                doc->fields() = dobj["fields"].toObject().toVariantMap();
-                tourist->documents().push_back(std::move(doc));
+                reader.skipValue();
             }
         }
+        if (reader.hasError() && recordError.isEmpty())
+            recordError = "Ошибка JSON: " + reader.errorString();
+
+        if (recordError.isEmpty() && requestsOffset >= 0) {
+            f.seek(requestsOffset);
+            JsonStreamReader second(&f);
+            if (readRequests(second, done, requestsOffset) && second.hasError())
+                recordError = "Ошибка JSON: " + second.errorString();
+        }
+    } catch (const std::exception& e) {
+        recordError = QString("Некорректные данные: %1").arg(e.what());
+    }
+
+    if (!recordError.isEmpty()) {
+        if (err) *err = recordError;
+        return false;
+    }
+    report(total, true);
+    return true;
+}
+
+bool TravelAgency::saveSnapshot(const QString& path, QString* err) const {
+    return BinarySnapshot::save(*this, path, err);
+}
+
+bool TravelAgency::loadSnapshot(const QString& path, QString* err) {
+    TravelAgency fresh;
+    fresh.lazyRequestDetails_ = lazyRequestDetails_;
+    if (!BinarySnapshot::load(fresh, path, err)) return false;
+    return adoptData(fresh, err);
+}
+
+std::unique_ptr<TravelAgency> TravelAgency::loadDetached(const QString& path, bool lazyRequestDetails,
+                                                         const LoadProgress& progress,
+                                                         const std::atomic<bool>* cancelled,
+                                                         QString* err) {
+    auto fresh = std::make_unique<TravelAgency>();
+    fresh->lazyRequestDetails_ = lazyRequestDetails;
+    bool ok;
+    if (BinarySnapshot::isSnapshotFile(path)) {
+        // Снимок читается одним проходом: отмена учитывается после него
+        ok = BinarySnapshot::load(*fresh, path, err);
+        if (ok && progress) progress(1, 1);
+    } else {
+        ok = fresh->readJsonStreaming(path, progress, cancelled, err);
+    }
+    if (ok && cancelled && cancelled->load()) {
+        if (err) *err = LOAD_CANCELED;
+        ok = false;
+    }
+    if (!ok) return nullptr;
+    return fresh;
+}
+
+bool TravelAgency::adoptData(TravelAgency& loaded, QString* err) {
+    const QString staged = std::exchange(loaded.stagedSnapshot_, QString());
+    swapData(loaded);
+    if (!journal_.isOpen() || staged != stagedPathFor(storePath_)) {
+        if (!staged.isEmpty()) QFile::remove(staged);
+        // Данные заменены целиком: журнал не описывает их, хранилище пишется заново
+        return !journal_.isOpen() || compactStore(err);
+    }
+    // Снимок уже записан: журнал прежних данных очищается, файл подменяется
+    return commitStagedSnapshot(err);
+}
+
+bool TravelAgency::stageStoreSnapshot(const QString& snapshotPath, QString* err) {
+    const QString staged = stagedPathFor(snapshotPath);
+    if (!saveSnapshot(staged, err)) return false;
+    stagedSnapshot_ = staged;
+    return true;
+}
+
+// --- JSONL ---
+bool TravelAgency::importRequestsJsonl(const QString& path, JsonlImportResult* result,
+                                       const LoadProgress& progress, QString* err) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (err) *err = "Не удалось открыть файл";
+        return false;
+    }
+
+    JsonlImportResult local;
+    JsonlImportResult& out = result ? *result : local;
+    out = JsonlImportResult();
+    const qint64 total = f.size();
+
+    std::vector<TourRequest*> batch;
+    std::unordered_set<int> batchIds;
+    auto commit = [&]() {
+        for (auto* r : batch) {
+            registerRequest(r);
+            journal(putRequestRecord(*r));
+        }
+        out.imported += static_cast<int>(batch.size());
+        batch.clear();
+        batchIds.clear();
+        if (progress) progress(f.pos(), total);
+    };
 
-        for (const QJsonValue& av : o["animals"].toArray()) {
-            QJsonObject ao = av.toObject();
-            r->addAnimal(ao["type"].toString(), ao["weight"].toDouble(), ao["transport"].toString());
+    int lineNo = 0;
+    while (!f.atEnd()) {
+        const QByteArray line = f.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty()) continue;
+        auto reject = [&](const QString& message) { out.errors.push_back({lineNo, message}); };
+
+        QJsonParseError perr;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &perr);
+        if (!doc.isObject()) {
+            reject("Ошибка JSON: " + (doc.isNull() ? perr.errorString() : QString("ожидался объект")));
+            continue;
+        }
+        const QJsonObject o = doc.object();
+        const int id = o["id"].toInt();
+        if (id > 0 && (findRequestById(id) || batchIds.count(id))) {
+            reject(QString("Заявка с id %1 уже есть").arg(id));
+            continue;
+        }
+        Client* c = findClientById(o["clientId"].toInt());
+        Tour* t = findTourById(o["tourId"].toInt());
+        if (!c || !t) {
+            reject(!c ? QString("Нет клиента с id %1").arg(o["clientId"].toInt())
+                      : QString("Нет тура с id %1").arg(o["tourId"].toInt()));
+            continue;
         }
 
-        // Документы заявки
-        r->regenerateDocuments();
-        QJsonArray docsArr = o["documents"].toArray();
-        const int n = std::min<int>(static_cast<int>(docsArr.size()),
-                                    static_cast<int>(r->getDocuments().size()));
-        for (int i = 0; i < n; ++i) {
-            QJsonObject dobj = docsArr[i].toObject();
-            r->documents()[i]->setStatus(static_cast<DocumentStatus>(dobj["status"].toInt()));
-            r->documents()[i]->fields() = dobj["fields"].toObject().toVariantMap();
+        std::unique_ptr<TourRequest> r;
+        try {
+            r.reset(SerializationService::requestFromJson(o, c, t));
+        } catch (const std::exception& e) {
+            reject(QString("Некорректные данные: %1").arg(e.what()));
+            continue;
         }
+        QString validationErr;
+        if (!RequestService::validateForImport(*r, &validationErr)) {
+            reject(validationErr);
+            continue;
+        }
+        batchIds.insert(r->getId());
+        batch.push_back(r.release());
+        if (static_cast<int>(batch.size()) >= IMPORT_BATCH) commit();
+    }
+    commit();
+    return true;
+}
 
-        requests_.push_back(r);
+bool TravelAgency::exportRequestsJsonl(const QString& path, QString* err) const {
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err) *err = "Не удалось открыть файл для записи";
+        return false;
+    }
+    for (auto* r : requests_) {
+        QByteArray line = SerializationService::requestToJsonBytes(*r);
+        line.append('\n');
+        f.write(line);
+    }
+    if (!f.commit()) {
+        if (err) *err = "Не удалось записать файл: " + f.errorString();
+        return false;
     }
+    return true;
+}
+
+// --- Рабочее хранилище (снимок + журнал) ---
+bool TravelAgency::openStore(const QString& snapshotPath, QString* err) {
+    closeStore();
+    int records = 0;
+    const auto loaded = loadStoreDetached(snapshotPath, lazyRequestDetails_, &records, err);
+    return loaded && adoptStore(*loaded, snapshotPath, records, err);
+}
 
+std::unique_ptr<TravelAgency> TravelAgency::loadStoreDetached(const QString& snapshotPath,
+                                                              bool lazyRequestDetails, int* records,
+                                                              QString* err) {
+    // Подготовленный снимок (adoptData) остался от прерванной подмены: без
+    // основного он и есть данные хранилища, рядом с основным — устарел
+    const QString staged = stagedPathFor(snapshotPath);
+    if (QFile::exists(staged)) {
+        if (QFile::exists(snapshotPath)) QFile::remove(staged);
+        else QFile::rename(staged, snapshotPath);
+    }
+    auto fresh = std::make_unique<TravelAgency>();
+    fresh->lazyRequestDetails_ = lazyRequestDetails;
+    if (QFile::exists(snapshotPath) && !BinarySnapshot::load(*fresh, snapshotPath, err)) return nullptr;
+
+    // Журнал у нового объекта закрыт: воспроизведённые записи не пишутся заново
+    TravelAgency* target = fresh.get();
+    const auto apply = [target](const QJsonObject& r, QString* e) { return target->applyJournalRecord(r, e); };
+    if (!ChangeJournal::replay(journalPathFor(snapshotPath), apply, records, err)) return nullptr;
+    return fresh;
+}
+
+bool TravelAgency::adoptStore(TravelAgency& loaded, const QString& snapshotPath, int records, QString* err) {
+    closeStore();
+    swapData(loaded);
+    if (!journal_.open(journalPathFor(snapshotPath), records, err)) return false;
+    storePath_ = snapshotPath;
+    return true;
+}
+
+void TravelAgency::closeStore() {
+    journal_.close();
+    storePath_.clear();
+}
+
+bool TravelAgency::compactStore(QString* err) {
+    if (!journal_.isOpen()) {
+        if (err) *err = "Хранилище не открыто";
+        return false;
+    }
+    // Сначала новый снимок (QSaveFile подменяет файл атомарно), затем очистка
+    // журнала. Сбой между шагами не страшен: записи журнала идемпотентны.
+    return saveSnapshot(storePath_, err) && journal_.clear(err);
+}
+
+bool TravelAgency::commitStagedSnapshot(QString* err) {
+    if (!journal_.isOpen()) {
+        if (err) *err = "Хранилище не открыто";
+        return false;
+    }
+    if (!journal_.clear(err)) return false;
+    QFile::remove(storePath_);
+    if (!QFile::rename(stagedPathFor(storePath_), storePath_)) {
+        if (err) *err = "Не удалось заменить снимок хранилища";
+        return false;
+    }
+    return true;
+}
+
+void TravelAgency::noteRequestChanged(int requestId) {
+    TourRequest* r = findRequestById(requestId);
+    if (!r) return;
+    if (expiryIndexReady_) expiryIndex_.update(*r);
+    updateRevenue(*r);
+    journal(putRequestRecord(*r));
+}
+
+void TravelAgency::journal(const QByteArray& record) {
+    if (!journal_.isOpen()) return;
+    QString err;
+    const bool written = journal_.append(record, &err);
+    if (journalListener_) {
+        journalListener_(err);
+        return;
+    }
+    if (!written || (compactionDue() && !compactStore(&err)))
+        qWarning("%s", qPrintable(err));
+}
+
+/**
+ * Записи "put*" содержат объект целиком и заменяют его или добавляют, "delete*"
+ * удаляют по id. Повторное применение уже учтённой записи ничего не меняет,
+ * поэтому отсутствующие объекты и ссылки при воспроизведении пропускаются.
+ */
+bool TravelAgency::applyJournalRecord(const QJsonObject& record, QString* err) {
+    const QString op = record["op"].toString();
+    try {
+        if (op == "putClient") {
+            std::unique_ptr<Client> c(SerializationService::clientFromJson(record["client"].toObject()));
+            if (Client* existing = findClientById(c->getId())) {
+                assignClient(existing, *c);
+                if (searchIndexReady_) searchIndex_.update(existing);
+            } else {
+                registerClient(c.release());
+            }
+        } else if (op == "putTour") {
+            std::unique_ptr<Tour> t(SerializationService::tourFromJson(record["tour"].toObject()));
+            if (Tour* existing = findTourById(t->getId())) {
+                assignTour(existing, *t);
+                refreshTourRequests(existing->getId());
+            } else {
+                registerTour(t.release());
+            }
+        } else if (op == "putRequest") {
+            const QJsonObject o = record["request"].toObject();
+            Client* c = findClientById(o["clientId"].toInt());
+            Tour* t = findTourById(o["tourId"].toInt());
+            if (!c || !t) return true;
+            TourRequest* fresh = SerializationService::requestFromJson(o, c, t);
+            if (TourRequest* existing = findRequestById(fresh->getId())) replaceRequest(existing, fresh);
+            else registerRequest(fresh);
+        } else if (op == "deleteClient") {
+            deleteClient(record["id"].toInt());
+        } else if (op == "deleteTour") {
+            deleteTour(record["id"].toInt());
+        } else if (op == "deleteRequest") {
+            deleteRequest(record["id"].toInt());
+        } else {
+            if (err) *err = "Неизвестная операция \"" + op + "\"";
+            return false;
+        }
+    } catch (const std::exception& e) {
+        if (err) *err = QString("Некорректные данные: %1").arg(e.what());
+        return false;
+    }
     return true;
 }
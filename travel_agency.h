@@ -1,11 +1,57 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
+#include "change_journal.h"
 #include "client.h"
+#include "client_search_index.h"
+#include "document_expiry_index.h"
 #include "tour.h"
 #include "tour_request.h"
 
+/** Замечание загрузки: заявка пропущена из-за ссылки на отсутствующий объект */
+struct LoadIssue {
+    enum class Kind { MissingClient, MissingTour };
+    Kind kind;
+    int requestId;     // id пропущенной заявки
+    int referencedId;  // clientId или tourId, которого нет в файле
+    QString message() const;
+};
+
+/** Итог импорта заявок из JSONL: ошибки по номерам строк (с 1) */
+struct JsonlImportResult {
+    struct LineError {
+        int line;
+        QString message;
+    };
+    int imported = 0;
+    std::vector<LineError> errors;
+};
+
+/**
+ * Строка аудита документов: недостающие типы одного туриста заявки или
+ * самой заявки. unverified — часть missing, где документ есть, но не проверен.
+ */
+struct DocumentAuditEntry {
+    int requestId;
+    int touristIndex;        // индекс в getTourists(); -1 — документы заявки
+    DocumentMask missing;
+    DocumentMask unverified;
+};
+
+/** Отбор заявок для аудита; поля по умолчанию — без ограничения */
+struct DocumentAuditFilter {
+    int tourId = 0;              // 0 — все туры
+    QDate departureFrom;         // дата начала тура, включительно
+    QDate departureTo;
+    bool includeCanceled = false;
+};
+
 //=============================================================================
 // TravelAgency — логика приложения (отделение от интерфейса)
 //=============================================================================
@@ -30,6 +76,11 @@ public:
     Client* findClientById(int id) const;
     /** Поиск по ФИО, телефону, email (подстрока, без учёта регистра) */
     std::vector<Client*> searchClients(const QString& query) const;
+    /**
+     * Строит индекс поиска клиентов заранее. После этого searchClients только
+     * читает индекс и может вызываться из рабочих потоков, пока данные не меняются.
+     */
+    void prepareClientSearch() const;
     /** История заявок (продаж) по клиенту */
     std::vector<TourRequest*> getSalesHistoryForClient(int clientId) const;
 
@@ -53,13 +104,213 @@ public:
     TourRequest* createRequest(int clientId, int tourId, QString* err = nullptr);
     bool deleteRequest(int id, QString* err = nullptr);
     TourRequest* findRequestById(int id) const;
+    /** Заявки по туру (в порядке создания) */
+    std::vector<TourRequest*> getRequestsForTour(int tourId) const;
+    /**
+     * Аудит документов по всем заявкам или отобранным (тур, окно вылета).
+     * Заявки проверяются параллельно через кэш полноты каждой заявки;
+     * результат — в порядке заявок, полные заявки в него не попадают.
+     * Данные во время аудита не должны меняться.
+     */
+    std::vector<DocumentAuditEntry> auditDocuments(const DocumentAuditFilter& filter = {}) const;
+
+    // --- Выручка ---
+    /**
+     * Сумма стоимости заявок в статусе. Ведётся по каждой заявке при её
+     * создании, удалении, noteRequestChanged() и изменении её тура; запрос O(1).
+     */
+    double revenue(RequestStatus status) const;
+
+    // --- Сроки действия документов (validFrom/validTo) ---
+    /**
+     * Документы, не покрывающие даты своей поездки. Индекс сроков строится при
+     * первом запросе, дальше обновляется по заявке: при её создании, удалении,
+     * noteRequestChanged() и изменении её тура.
+     */
+    std::vector<DocumentValidity> documentsInvalidForTrip() const;
+    /** Документы, срок которых истекает с from по from + days */
+    std::vector<DocumentValidity> documentsExpiringWithin(int days, const QDate& from = QDate::currentDate()) const;
+    /** Предупреждения о сроках документов одной заявки; индекс для этого не строится */
+    QStringList documentValidityWarnings(int requestId) const;
+
+    /**
+     * Независимая копия данных (id сохраняются, журнал не копируется).
+     * Строки Qt разделяются неявно, поэтому копия дешевле сериализации.
+     */
+    std::unique_ptr<TravelAgency> clone() const;
 
     // --- Сохранение / загрузка ---
+    // Загрузка читает файл в отдельный объект и подменяет данные только после
+    // успешного разбора: при ошибке текущие данные остаются как были.
+    /** Запись атомарная: через временный файл и переименование (QSaveFile) */
     bool saveToFile(const QString& path, QString* err = nullptr) const;
+    /** Прогресс сохранения: записано объектов из общего числа */
+    using SaveProgress = std::function<void(qint64 done, qint64 total)>;
+    bool saveToFile(const QString& path, const SaveProgress& progress, QString* err = nullptr) const;
     bool loadFromFile(const QString& path, QString* err = nullptr);
+    /**
+     * Ленивый режим JSON-загрузки: у заявок сразу читается заголовок (id, клиент,
+     * тур, статус, способ и класс поездки), а туристы, животные и документы
+     * разбираются при первом обращении к ним. Стоимость доступна без разбора.
+     */
+    void setLazyRequestDetails(bool lazy) { lazyRequestDetails_ = lazy; }
+    bool lazyRequestDetails() const { return lazyRequestDetails_; }
+    /** Замечания последней JSON-загрузки (пропущенные заявки с висячими ссылками) */
+    const std::vector<LoadIssue>& loadIssues() const { return loadIssues_; }
+    /** Прогресс загрузки: обработано байт из общего размера файла */
+    using LoadProgress = std::function<void(qint64 done, qint64 total)>;
+    /**
+     * Потоковая загрузка того же формата: объекты создаются по мере чтения
+     * элементов массивов, без DOM всего файла. Память сверх данных ограничена
+     * размером блока чтения и самой крупной записи.
+     */
+    bool loadFromFileStreaming(const QString& path, const LoadProgress& progress = {},
+                               QString* err = nullptr);
+    /** Двоичный снимок (см. BinarySnapshot): быстрее JSON, только для своих файлов */
+    bool saveSnapshot(const QString& path, QString* err = nullptr) const;
+    bool loadSnapshot(const QString& path, QString* err = nullptr);
+    /**
+     * Загрузка в новый объект (для фонового потока): этот объект не нужен и не
+     * меняется. Снимок или JSON (потоково) — по содержимому файла. cancelled
+     * проверяется между записями JSON; при отмене или ошибке — nullptr и err.
+     */
+    static std::unique_ptr<TravelAgency> loadDetached(const QString& path, bool lazyRequestDetails,
+                                                      const LoadProgress& progress = {},
+                                                      const std::atomic<bool>* cancelled = nullptr,
+                                                      QString* err = nullptr);
+    /**
+     * Забирает данные loaded целиком, loaded получает прежние (освободить их
+     * можно в другом потоке). Журнал и путь хранилища остаются у этого объекта;
+     * открытое хранилище переписывается новым снимком, а если loaded уже записал
+     * его (stageStoreSnapshot) — подготовленный файл только подставляется.
+     */
+    bool adoptData(TravelAgency& loaded, QString* err = nullptr);
+    /**
+     * Для загрузки в фоне: пишет снимок этих данных в stagedPathFor(snapshotPath),
+     * чтобы adoptData в потоке окна не записывал снимок хранилища сам.
+     */
+    bool stageStoreSnapshot(const QString& snapshotPath, QString* err = nullptr);
+
+    // --- Обмен заявками в JSONL (одна заявка на строку) ---
+    /**
+     * Строка — запись заявки в формате сохранения (clientId, tourId, туристы,
+     * животные, документы). Файл читается построчно; каждая заявка проверяется
+     * RequestService::validateForImport, принятые добавляются пачками по
+     * IMPORT_BATCH. Ошибочная строка попадает в result->errors и не прерывает
+     * импорт. false — только если файл не открылся.
+     * id из строки сохраняется, если он свободен; без id назначается новый.
+     */
+    bool importRequestsJsonl(const QString& path, JsonlImportResult* result,
+                             const LoadProgress& progress = {}, QString* err = nullptr);
+    /** Все заявки по одной на строку; запись атомарная (QSaveFile) */
+    bool exportRequestsJsonl(const QString& path, QString* err = nullptr) const;
+
+    // --- Рабочее хранилище: снимок + журнал изменений ---
+    /**
+     * Загружает снимок (если он есть) и воспроизводит журнал journalPathFor(path).
+     * Дальше каждое изменение через методы агентства сразу дописывается в журнал,
+     * а при COMPACT_EVERY записях журнал сжимается в новый снимок.
+     */
+    bool openStore(const QString& snapshotPath, QString* err = nullptr);
+    /**
+     * openStore в два шага для фонового потока: loadStoreDetached читает снимок
+     * и воспроизводит журнал в новый объект (records — сколько в нём записей),
+     * adoptStore в потоке окна подменяет данные и открывает журнал для дозаписи
+     * (false — журнал не открылся: данные подменены, но правки не сохраняются).
+     */
+    static std::unique_ptr<TravelAgency> loadStoreDetached(const QString& snapshotPath, bool lazyRequestDetails,
+                                                           int* records, QString* err = nullptr);
+    bool adoptStore(TravelAgency& loaded, const QString& snapshotPath, int records, QString* err = nullptr);
+    void closeStore();
+    bool isStoreOpen() const { return journal_.isOpen(); }
+    /** Снимок открытого хранилища; пусто — хранилище не открыто */
+    const QString& storePath() const { return storePath_; }
+    /** Записывает снимок текущих данных и очищает журнал */
+    bool compactStore(QString* err = nullptr);
+    /**
+     * Вызывается после каждой записи в журнал: err — ошибка записи (пусто —
+     * записано). Со слушателем журнал сам не сжимается: владелец проверяет
+     * compactionDue(), пишет снимок в stagedPathFor(storePath()) (saveSnapshot
+     * можно в фоне, пока данные не меняются) и вызывает commitStagedSnapshot().
+     * Без слушателя ошибка идёт в лог, а сжатие выполняется сразу.
+     */
+    using JournalListener = std::function<void(const QString& err)>;
+    void setJournalListener(JournalListener listener) { journalListener_ = std::move(listener); }
+    /** В журнале COMPACT_EVERY записей или больше — пора сжать его в снимок */
+    bool compactionDue() const { return journal_.isOpen() && journal_.recordCount() >= COMPACT_EVERY; }
+    /**
+     * Снимок этих данных из stagedPathFor(storePath()) становится снимком
+     * хранилища, журнал очищается. Прерванную подмену доводит до конца openStore
+     */
+    bool commitStagedSnapshot(QString* err = nullptr);
+    /**
+     * Туристы, животные, документы, статус и способ поездки меняются прямо
+     * в TourRequest; после такого изменения заявка записывается в журнал.
+     */
+    void noteRequestChanged(int requestId);
+    static QString journalPathFor(const QString& snapshotPath) { return snapshotPath + ".journal"; }
+    static QString stagedPathFor(const QString& snapshotPath) { return snapshotPath + ".new"; }
 
 private:
+    friend class BinarySnapshot;
+
+    static constexpr qint64 PROGRESS_STEP = 256 * 1024;  // не чаще, чем раз в 256 КБ
+    static constexpr int COMPACT_EVERY = 1000;           // записей журнала до сжатия
+    static constexpr qint64 SAVE_PROGRESS_STEP = 1000;   // объектов между отчётами
+    static constexpr int PARALLEL_DECODE_MIN = 256;      // меньше заявок — в одном потоке
+    static constexpr int IMPORT_BATCH = 500;             // заявок в одной пачке импорта
+    static constexpr int PARALLEL_AUDIT_MIN = 64;        // меньше заявок — аудит в одном потоке
+
     std::vector<Client*> clients_;
     std::vector<Tour*> tours_;
     std::vector<TourRequest*> requests_;
+    // Индексы id → объект, синхронизируются с векторами выше
+    std::unordered_map<int, Client*> clientsById_;
+    std::unordered_map<int, Tour*> toursById_;
+    std::unordered_map<int, TourRequest*> requestsById_;
+    // Вторичные индексы: id клиента/тура → его заявки в порядке создания
+    std::unordered_map<int, std::vector<TourRequest*>> requestsByClient_;
+    std::unordered_map<int, std::vector<TourRequest*>> requestsByTour_;
+    // Триграммный индекс поиска клиентов: строится при первом поиске,
+    // после этого обновляется при добавлении/изменении/удалении
+    mutable ClientSearchIndex searchIndex_;
+    mutable bool searchIndexReady_ = false;
+    // Индекс сроков документов: тоже строится при первом запросе (разбирает
+    // отложенные подробности всех заявок), затем обновляется по заявке
+    mutable DocumentExpiryIndex expiryIndex_;
+    mutable bool expiryIndexReady_ = false;
+    // Выручка по статусам в копейках (целые суммы не накапливают ошибку) и вклад
+    // каждой заявки, который вычитается при её изменении
+    struct RevenueShare {
+        RequestStatus status;
+        qint64 kopecks;
+    };
+    std::array<qint64, REQUEST_STATUS_COUNT> revenueByStatus_{};
+    std::unordered_map<int, RevenueShare> revenueShares_;
+    std::vector<LoadIssue> loadIssues_;
+    bool lazyRequestDetails_ = false;
+    // Журнал открыт только между openStore() и closeStore()
+    ChangeJournal journal_;
+    QString storePath_;
+    QString stagedSnapshot_;  // снимок этих данных от stageStoreSnapshot
+    JournalListener journalListener_;
+
+    void registerClient(Client* c);
+    void registerTour(Tour* t);
+    void registerRequest(TourRequest* r);
+    void unregisterRequest(TourRequest* r);
+    void replaceRequest(TourRequest* old, TourRequest* fresh);
+    void clearAll();
+    void swapData(TravelAgency& other);
+    bool readJson(const QString& path, QString* err);
+    bool readJsonStreaming(const QString& path, const LoadProgress& progress,
+                           const std::atomic<bool>* cancelled, QString* err);
+    void ensureExpiryIndex() const;
+    void updateRevenue(const TourRequest& r);
+    /** После правки тура: кэш полноты, индекс сроков и выручка его заявок */
+    void refreshTourRequests(int tourId);
+    void removeRevenue(int requestId);
+    void noteDanglingRefs(const QJsonObject& request);
+    void journal(const QByteArray& record);
+    bool applyJournalRecord(const QJsonObject& record, QString* err);
 };
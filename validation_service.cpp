@@ -1,19 +1,34 @@
 #include "validation_service.h"
 
-QRegularExpression ValidationService::nameRegex() {
-    return QRegularExpression(QStringLiteral("^[А-ЯЁа-яё]+(-[А-ЯЁа-яё]+)*$"));
+namespace {
+
+/** Выражение, скомпилированное заранее: match() из разных потоков безопасен */
+QRegularExpression compiled(const QString& pattern) {
+    QRegularExpression re(pattern);
+    re.optimize();
+    return re;
+}
+
+} // namespace
+
+const QRegularExpression& ValidationService::nameRegex() {
+    static const QRegularExpression re = compiled(QStringLiteral("^[А-ЯЁа-яё]+(-[А-ЯЁа-яё]+)*$"));
+    return re;
 }
 
-QRegularExpression ValidationService::addressTextRegex() {
-    return QRegularExpression(QStringLiteral("^[А-ЯЁа-яё]+([ -][А-ЯЁа-яё]+)*$"));
+const QRegularExpression& ValidationService::addressTextRegex() {
+    static const QRegularExpression re = compiled(QStringLiteral("^[А-ЯЁа-яё]+([ -][А-ЯЁа-яё]+)*$"));
+    return re;
 }
 
-QRegularExpression ValidationService::houseRegex() {
-    return QRegularExpression(QStringLiteral("^\\d+[А-Яа-я]?(\\/\\d+[А-Яа-я]?)?$"));
+const QRegularExpression& ValidationService::houseRegex() {
+    static const QRegularExpression re = compiled(QStringLiteral("^\\d+[А-Яа-я]?(\\/\\d+[А-Яа-я]?)?$"));
+    return re;
 }
 
-QRegularExpression ValidationService::postalCodeRegex() {
-    return QRegularExpression(QStringLiteral("^\\d{6}$"));
+const QRegularExpression& ValidationService::postalCodeRegex() {
+    static const QRegularExpression re = compiled(QStringLiteral("^\\d{6}$"));
+    return re;
 }
 
 bool ValidationService::validateNamePart(const QString& value, QString* err) {
@@ -34,33 +49,25 @@ bool ValidationService::validateOptionalNamePart(const QString& value, QString*
 }
 
 bool ValidationService::validateAddress(const Address& address, QString* err) {
-    if (address.region.trimmed().isEmpty() || !addressTextRegex().match(address.region).hasMatch()) {
-        if (err) *err = "Регион: только кириллица, пробелы и дефис";
-        return false;
-    }
-    if (address.city.trimmed().isEmpty() || !addressTextRegex().match(address.city).hasMatch()) {
-        if (err) *err = "Город: только кириллица, пробелы и дефис";
-        return false;
-    }
-    if (address.street.trimmed().isEmpty() || !addressTextRegex().match(address.street).hasMatch()) {
-        if (err) *err = "Улица: только кириллица, пробелы и дефис";
-        return false;
-    }
-    if (address.house.trimmed().isEmpty() || !houseRegex().match(address.house).hasMatch()) {
-        if (err) *err = "Дом: допустимы цифры, литера и /";
-        return false;
-    }
-    if (!address.building.trimmed().isEmpty() && !houseRegex().match(address.building).hasMatch()) {
-        if (err) *err = "Корпус: допустимы цифры, литера и /";
-        return false;
-    }
-    if (!address.apartment.trimmed().isEmpty() && !houseRegex().match(address.apartment).hasMatch()) {
-        if (err) *err = "Квартира: допустимы цифры, литера и /";
-        return false;
-    }
-    if (address.postalCode.trimmed().isEmpty() || !postalCodeRegex().match(address.postalCode).hasMatch()) {
-        if (err) *err = "Индекс: 6 цифр";
-        return false;
-    }
-    return true;
+    const std::vector<FieldError> errors = addressErrors(address);
+    if (errors.empty()) return true;
+    if (err) *err = errors.front().message;
+    return false;
+}
+
+std::vector<FieldError> ValidationService::addressErrors(const Address& address, const QString& prefix) {
+    std::vector<FieldError> out;
+    auto check = [&](const char* key, const QString& value, bool required,
+                     const QRegularExpression& re, const char* message) {
+        if (value.trimmed().isEmpty() ? required : !re.match(value).hasMatch())
+            out.push_back({prefix + QLatin1String(key), QString::fromUtf8(message)});
+    };
+    check("region", address.region, true, addressTextRegex(), "Регион: только кириллица, пробелы и дефис");
+    check("city", address.city, true, addressTextRegex(), "Город: только кириллица, пробелы и дефис");
+    check("street", address.street, true, addressTextRegex(), "Улица: только кириллица, пробелы и дефис");
+    check("house", address.house, true, houseRegex(), "Дом: допустимы цифры, литера и /");
+    check("building", address.building, false, houseRegex(), "Корпус: допустимы цифры, литера и /");
+    check("apartment", address.apartment, false, houseRegex(), "Квартира: допустимы цифры, литера и /");
+    check("postalCode", address.postalCode, true, postalCodeRegex(), "Индекс: 6 цифр");
+    return out;
 }
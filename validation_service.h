@@ -3,16 +3,27 @@
 #include <QRegularExpression>
 #include <QString>
 
+#include <vector>
+
 #include "address.h"
 
+/** Ошибка проверки одного поля: ключ поля и текст сообщения */
+struct FieldError {
+    QString field;
+    QString message;
+};
+
 class ValidationService {
 public:
-    static QRegularExpression nameRegex();
-    static QRegularExpression addressTextRegex();
-    static QRegularExpression houseRegex();
-    static QRegularExpression postalCodeRegex();
+    // Выражения компилируются один раз; ссылки действительны всегда
+    static const QRegularExpression& nameRegex();
+    static const QRegularExpression& addressTextRegex();
+    static const QRegularExpression& houseRegex();
+    static const QRegularExpression& postalCodeRegex();
 
     static bool validateNamePart(const QString& value, QString* err = nullptr);
     static bool validateOptionalNamePart(const QString& value, QString* err = nullptr);
     static bool validateAddress(const Address& address, QString* err = nullptr);
+    /** Все ошибки адреса; ключи полей — prefix + "region", "city" и т.д. */
+    static std::vector<FieldError> addressErrors(const Address& address, const QString& prefix = QString());
 };